@@ -1,41 +1,326 @@
 #include <DataRepresentation/Array2D.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <omp.h>
 
 namespace lpmldata
 {
 
+namespace
+{
+	const std::size_t kAlignment = 64;  // Cache line and AVX-512 register width.
+	const int kBlockSize = 64;          // Edge of the cache blocks used by the kernels.
+}
+
+//-----------------------------------------------------------------------------
+template < typename Type >
+Array2D< Type >::Array2D()
+:
+	mRowCount( 0 ),
+	mColumnCount( 0 ),
+	mLayout( Array2DLayout::ColumnMajor ),
+	mRowStride( 1 ),
+	mColumnStride( 0 ),
+	mAllocation( nullptr ),
+	mArray( nullptr )
+{
+}
+
 //-----------------------------------------------------------------------------
 template < typename Type >
-Array2D< Type >::Array2D( unsigned int aRowCount, unsigned int aColumnCount )
+Array2D< Type >::Array2D( unsigned int aRowCount, unsigned int aColumnCount, Array2DLayout aLayout )
 :
 	mRowCount( aRowCount ),
-	mColumnCount( aColumnCount )
+	mColumnCount( aColumnCount ),
+	mLayout( aLayout ),
+	mRowStride( aLayout == Array2DLayout::RowMajor ? aColumnCount : 1 ),
+	mColumnStride( aLayout == Array2DLayout::RowMajor ? 1 : aRowCount ),
+	mAllocation( nullptr ),
+	mArray( nullptr )
 {
-	if ( aRowCount > 0 && aColumnCount > 0 ) mArray = new Type[ aRowCount * aColumnCount ];
-	for ( unsigned int arrayIndex = 0; arrayIndex < aRowCount * aColumnCount; ++arrayIndex )
+	std::size_t elementCount = std::size_t( aRowCount ) * aColumnCount;
+
+	if ( elementCount > 0 )
+	{
+		mAllocation = ::operator new( elementCount * sizeof( Type ) + kAlignment );
+		mArray      = reinterpret_cast< Type* >( ( reinterpret_cast< std::uintptr_t >( mAllocation ) + kAlignment - 1 ) & ~std::uintptr_t( kAlignment - 1 ) );
+	}
+
+	for ( std::size_t arrayIndex = 0; arrayIndex < elementCount; ++arrayIndex )
 	{
 		mArray[ arrayIndex ] = 0;
 	}
 }
 
+//-----------------------------------------------------------------------------
+template < typename Type >
+Array2D< Type >::Array2D( Array2D< Type >&& aOther )
+:
+	mRowCount( aOther.mRowCount ),
+	mColumnCount( aOther.mColumnCount ),
+	mLayout( aOther.mLayout ),
+	mRowStride( aOther.mRowStride ),
+	mColumnStride( aOther.mColumnStride ),
+	mAllocation( aOther.mAllocation ),
+	mArray( aOther.mArray )
+{
+	aOther.mRowCount     = 0;
+	aOther.mColumnCount  = 0;
+	aOther.mAllocation   = nullptr;
+	aOther.mArray        = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+template < typename Type >
+Array2D< Type >& Array2D< Type >::operator = ( Array2D< Type >&& aOther )
+{
+	if ( this != &aOther )
+	{
+		release();
+
+		mRowCount     = aOther.mRowCount;
+		mColumnCount  = aOther.mColumnCount;
+		mLayout       = aOther.mLayout;
+		mRowStride    = aOther.mRowStride;
+		mColumnStride = aOther.mColumnStride;
+		mAllocation   = aOther.mAllocation;
+		mArray        = aOther.mArray;
+
+		aOther.mRowCount    = 0;
+		aOther.mColumnCount = 0;
+		aOther.mAllocation  = nullptr;
+		aOther.mArray       = nullptr;
+	}
+
+	return *this;
+}
+
 //-----------------------------------------------------------------------------
 template < typename Type >
 Array2D< Type >::~Array2D()
 {
-	delete[] mArray;
+	release();
 }
 
 //-----------------------------------------------------------------------------
 template < typename Type >
-const Type& Array2D< Type >::operator() ( unsigned int aX, unsigned int aY ) const
+void Array2D< Type >::release()
 {
-	return mArray[ aY*mRowCount + aX ];
+	::operator delete( mAllocation );
+
+	mAllocation = nullptr;
+	mArray      = nullptr;
 }
 
 //-----------------------------------------------------------------------------
 template < typename Type >
-Type& Array2D< Type >::operator() ( unsigned int aX, unsigned int aY )
+void Array2D< Type >::fill( const Type& aValue )
 {
-	return mArray[ aY*mRowCount + aX ];
+	std::fill( mArray, mArray + std::size_t( mRowCount ) * mColumnCount, aValue );
+}
+
+//-----------------------------------------------------------------------------
+template < typename Type >
+Array2D< Type > Array2D< Type >::clone( Array2DLayout aLayout ) const
+{
+	Array2D< Type > copy( mRowCount, mColumnCount, aLayout );
+
+	if ( aLayout == mLayout )
+	{
+		if ( mArray != nullptr ) std::memcpy( copy.mArray, mArray, std::size_t( mRowCount ) * mColumnCount * sizeof( Type ) );
+		return copy;
+	}
+
+	for ( unsigned int x = 0; x < mRowCount; ++x )
+	{
+		for ( unsigned int y = 0; y < mColumnCount; ++y )
+		{
+			copy( x, y ) = operator()( x, y );
+		}
+	}
+
+	return copy;
+}
+
+//-----------------------------------------------------------------------------
+template < typename Type >
+Array2D< Type > Array2D< Type >::transposed() const
+{
+	Array2D< Type > transposed( mColumnCount, mRowCount, mLayout );
+
+	// Blocked to keep both the source and the destination tiles in cache.
+	for ( unsigned int xBlock = 0; xBlock < mRowCount; xBlock += kBlockSize )
+	{
+		for ( unsigned int yBlock = 0; yBlock < mColumnCount; yBlock += kBlockSize )
+		{
+			unsigned int xEnd = std::min( xBlock + kBlockSize, mRowCount );
+			unsigned int yEnd = std::min( yBlock + kBlockSize, mColumnCount );
+
+			for ( unsigned int x = xBlock; x < xEnd; ++x )
+			{
+				for ( unsigned int y = yBlock; y < yEnd; ++y )
+				{
+					transposed( y, x ) = operator()( x, y );
+				}
+			}
+		}
+	}
+
+	return transposed;
+}
+
+//-----------------------------------------------------------------------------
+template < typename Type >
+void Array2D< Type >::gemm( const Array2D< Type >& aA, const Array2D< Type >& aB, Array2D< Type >& aC, Type aAlpha, Type aBeta )
+{
+	int rowCount    = aA.rowCount();
+	int innerCount  = aA.columnCount();
+	int columnCount = aB.columnCount();
+
+	if ( aB.rowCount() != unsigned( innerCount ) || aC.rowCount() != unsigned( rowCount ) || aC.columnCount() != unsigned( columnCount ) )
+	{
+		return;
+	}
+
+	if ( aBeta == Type( 0 ) )
+	{
+		aC.fill( 0 );
+	}
+	else if ( aBeta != Type( 1 ) )
+	{
+		Type* c = aC.data();
+		for ( std::size_t index = 0; index < std::size_t( rowCount ) * columnCount; ++index ) c[ index ] *= aBeta;
+	}
+
+	const Type* a = aA.data();
+	const Type* b = aB.data();
+	Type* c       = aC.data();
+
+	// i-k-j order: the innermost loop walks rows of B and C, contiguous when both are row-major.
+	bool isContiguous = aB.columnStride() == 1 && aC.columnStride() == 1;
+
+	#pragma omp parallel for schedule( static )
+	for ( int rowBlock = 0; rowBlock < rowCount; rowBlock += kBlockSize )
+	{
+		int rowEnd = std::min( rowBlock + kBlockSize, rowCount );
+
+		for ( int innerBlock = 0; innerBlock < innerCount; innerBlock += kBlockSize )
+		{
+			int innerEnd = std::min( innerBlock + kBlockSize, innerCount );
+
+			for ( int i = rowBlock; i < rowEnd; ++i )
+			{
+				Type* cRow = c + std::size_t( i ) * aC.rowStride();
+
+				for ( int k = innerBlock; k < innerEnd; ++k )
+				{
+					Type aValue = aAlpha * a[ std::size_t( i ) * aA.rowStride() + std::size_t( k ) * aA.columnStride() ];
+
+					if ( aValue == Type( 0 ) ) continue;
+
+					const Type* bRow = b + std::size_t( k ) * aB.rowStride();
+
+					if ( isContiguous )
+					{
+						for ( int j = 0; j < columnCount; ++j )
+						{
+							cRow[ j ] += aValue * bRow[ j ];
+						}
+					}
+					else
+					{
+						for ( int j = 0; j < columnCount; ++j )
+						{
+							cRow[ std::size_t( j ) * aC.columnStride() ] += aValue * bRow[ std::size_t( j ) * aB.columnStride() ];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+template < typename Type >
+void Array2D< Type >::gemv( const Array2D< Type >& aA, const Type* aX, Type* aY, Type aAlpha, Type aBeta )
+{
+	int rowCount    = aA.rowCount();
+	int columnCount = aA.columnCount();
+
+	#pragma omp parallel for schedule( static )
+	for ( int i = 0; i < rowCount; ++i )
+	{
+		auto aRow = aA.row( i );
+		Type sum  = 0;
+
+		if ( aRow.isContiguous() )
+		{
+			const Type* values = aRow.data();
+			for ( int j = 0; j < columnCount; ++j ) sum += values[ j ] * aX[ j ];
+		}
+		else
+		{
+			for ( int j = 0; j < columnCount; ++j ) sum += aRow[ j ] * aX[ j ];
+		}
+
+		aY[ i ] = aAlpha * sum + ( aBeta == Type( 0 ) ? Type( 0 ) : aBeta * aY[ i ] );
+	}
+}
+
+//-----------------------------------------------------------------------------
+template < typename Type >
+void Array2D< Type >::syrk( const Array2D< Type >& aA, Array2D< Type >& aC, Type aAlpha, Type aBeta )
+{
+	int rowCount    = aA.rowCount();
+	int columnCount = aA.columnCount();
+
+	if ( aC.rowCount() != unsigned( columnCount ) || aC.columnCount() != unsigned( columnCount ) )
+	{
+		return;
+	}
+
+	// Column dot products need contiguous columns.
+	Array2D< Type > columnMajor;
+	const Array2D< Type >* source = &aA;
+
+	if ( aA.layout() != Array2DLayout::ColumnMajor )
+	{
+		columnMajor = aA.clone( Array2DLayout::ColumnMajor );
+		source      = &columnMajor;
+	}
+
+	const Type* a = source->data();
+
+	// Upper triangle, then mirrored.
+	#pragma omp parallel for schedule( dynamic )
+	for ( int i = 0; i < columnCount; ++i )
+	{
+		const Type* left = a + std::size_t( i ) * rowCount;
+
+		for ( int j = i; j < columnCount; ++j )
+		{
+			const Type* right = a + std::size_t( j ) * rowCount;
+			Type sum = 0;
+
+			for ( int k = 0; k < rowCount; ++k )
+			{
+				sum += left[ k ] * right[ k ];
+			}
+
+			Type previous = aBeta == Type( 0 ) ? Type( 0 ) : aBeta * aC( i, j );
+			aC( i, j ) = aAlpha * sum + previous;
+		}
+	}
+
+	for ( int i = 0; i < columnCount; ++i )
+	{
+		for ( int j = 0; j < i; ++j )
+		{
+			aC( i, j ) = aC( j, i );
+		}
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -45,4 +330,4 @@ template class DataRepresentation_API Array2D< unsigned int >;
 template class DataRepresentation_API Array2D< float >;
 template class DataRepresentation_API Array2D< double >;
 
-}
\ No newline at end of file
+}
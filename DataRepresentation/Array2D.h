@@ -8,19 +8,74 @@ namespace lpmldata
 
 //-----------------------------------------------------------------------------
 
+/*!
+* \brief Storage order of the Array2D elements.
+*/
+enum class Array2DLayout
+{
+	ColumnMajor = 0,  //!< Elements of a column are contiguous (default, the original Array2D order).
+	RowMajor          //!< Elements of a row are contiguous.
+};
+
+//-----------------------------------------------------------------------------
+
+/*!
+* \brief Non-owning strided view of one row or one column of an Array2D.
+*/
+template < typename Type >
+class Array2DSpan
+{
+
+public:
+
+	Array2DSpan( Type* aData, unsigned int aSize, unsigned int aStride ) : mData( aData ), mSize( aSize ), mStride( aStride ) {}
+
+	Type& operator[] ( unsigned int aIndex ) const { return mData[ aIndex * mStride ]; }
+
+	Type& at( unsigned int aIndex ) const { return mData[ aIndex * mStride ]; }
+
+	Type* data() const { return mData; }
+
+	unsigned int size() const { return mSize; }
+
+	unsigned int stride() const { return mStride; }
+
+	bool isContiguous() const { return mStride == 1; }
+
+private:
+
+	Type*         mData;
+	unsigned int  mSize;
+	unsigned int  mStride;
+};
+
+//-----------------------------------------------------------------------------
+
+/*!
+* \brief Dense two dimensional array. The storage is 64 byte aligned and either column- or row-major.
+*
+* \details Copying is explicit through clone(), the array can be moved. Views of rows and columns do not copy.
+* The blocked gemm, gemv and syrk kernels accept any layout, they are fastest when the operands are row-major.
+*/
 template < typename Type >
 class DataRepresentation_API Array2D
 {
 
 public:
 
-	Array2D( unsigned int aRowCount, unsigned int aColumnCount );
+	Array2D();
+
+	Array2D( unsigned int aRowCount, unsigned int aColumnCount, Array2DLayout aLayout = Array2DLayout::ColumnMajor );
+
+	Array2D( Array2D< Type >&& aOther );
+
+	Array2D& operator = ( Array2D< Type >&& aOther );
 
 	virtual ~Array2D();
 
-	const Type& operator () ( unsigned int aX, unsigned int aY ) const;
+	const Type& operator () ( unsigned int aX, unsigned int aY ) const { return mArray[ aX * mRowStride + aY * mColumnStride ]; }
 
-	Type& operator () ( unsigned int aX, unsigned int aY );
+	Type& operator () ( unsigned int aX, unsigned int aY ) { return mArray[ aX * mRowStride + aY * mColumnStride ]; }
 
 	void addEntry( unsigned int aX, unsigned int aY ) { operator() ( aX, aY ) += 1; }
 
@@ -30,17 +85,77 @@ public:
 
 	const Type& at( unsigned int aX, unsigned int aY ) const { return operator()( aX, aY ); }
 
+	Array2DLayout layout() const { return mLayout; }
+
+	Type* data() { return mArray; }
+
+	const Type* data() const { return mArray; }
+
+	/*!
+	* \brief Distance between consecutive elements of a column.
+	*/
+	unsigned int rowStride() const { return mRowStride; }
+
+	/*!
+	* \brief Distance between consecutive elements of a row.
+	*/
+	unsigned int columnStride() const { return mColumnStride; }
+
+	Array2DSpan< Type > row( unsigned int aX ) { return Array2DSpan< Type >( mArray + aX * mRowStride, mColumnCount, mColumnStride ); }
+
+	Array2DSpan< const Type > row( unsigned int aX ) const { return Array2DSpan< const Type >( mArray + aX * mRowStride, mColumnCount, mColumnStride ); }
+
+	Array2DSpan< Type > column( unsigned int aY ) { return Array2DSpan< Type >( mArray + aY * mColumnStride, mRowCount, mRowStride ); }
+
+	Array2DSpan< const Type > column( unsigned int aY ) const { return Array2DSpan< const Type >( mArray + aY * mColumnStride, mRowCount, mRowStride ); }
+
+	void fill( const Type& aValue );
+
+	/*!
+	* \brief Explicit deep copy.
+	* \param [in] aLayout Layout of the copy.
+	*/
+	Array2D< Type > clone( Array2DLayout aLayout ) const;
+
+	Array2D< Type > clone() const { return clone( mLayout ); }
+
+	/*!
+	* \brief Returns with the transposed array in the same layout.
+	*/
+	Array2D< Type > transposed() const;
+
+	/*!
+	* \brief C = aAlpha * A * B + aBeta * C. C must be sized A.rowCount() x B.columnCount().
+	*/
+	static void gemm( const Array2D< Type >& aA, const Array2D< Type >& aB, Array2D< Type >& aC, Type aAlpha = 1, Type aBeta = 0 );
+
+	/*!
+	* \brief y = aAlpha * A * x + aBeta * y, with x of A.columnCount() and y of A.rowCount() elements.
+	*/
+	static void gemv( const Array2D< Type >& aA, const Type* aX, Type* aY, Type aAlpha = 1, Type aBeta = 0 );
+
+	/*!
+	* \brief C = aAlpha * A^T * A + aBeta * C. C must be sized A.columnCount() x A.columnCount(), with A holding samples in rows this is the scatter matrix.
+	*/
+	static void syrk( const Array2D< Type >& aA, Array2D< Type >& aC, Type aAlpha = 1, Type aBeta = 0 );
+
 private:
 
-	// to prevent unwanted copying:
+	// to prevent unwanted copying, use clone():
 	Array2D( const Array2D< Type >& );
 	Array2D& operator = ( const Array2D< Type >& );
 
+	void release();
+
 private:
 
-	unsigned int mRowCount;
-	unsigned int mColumnCount;
-	Type* mArray;
+	unsigned int   mRowCount;
+	unsigned int   mColumnCount;
+	Array2DLayout  mLayout;
+	unsigned int   mRowStride;
+	unsigned int   mColumnStride;
+	void*          mAllocation;    //!< Start of the allocated block, mArray points to its 64 byte aligned part.
+	Type*          mArray;
 };
 
 //-----------------------------------------------------------------------------
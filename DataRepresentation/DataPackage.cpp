@@ -1,4 +1,6 @@
 #include <DataRepresentation/DataPackage.h>
+#include <DataRepresentation/DistanceKernels.h>
+#include <cstring>
 //#include <Evaluation/TabularDataFilter.h>
 
 namespace lpmldata
@@ -21,6 +23,7 @@ void DataPackage::setActiveLabel( QString aLabel )
 	if ( labels.contains( aLabel ) )
 	{
 		mActiveLabelIndex = labels.indexOf( aLabel );
+		mFingerprint.reset();
 	}
 	else
 	{
@@ -77,6 +80,73 @@ QStringList DataPackage::commonKeys() const
 	return featureKeySet.intersect( labelKeySet ).subtract( labelKeySetNA ).toList();
 }
 
+//-----------------------------------------------------------------------------
+
+quint64 DataPackage::fingerprint() const
+{
+	auto cached = std::atomic_load( &mFingerprint );
+	if ( cached != nullptr )
+	{
+		return *cached;
+	}
+
+	// splitmix64 finalizer of each value, combined with the FNV prime.
+	auto combine = []( quint64 aHash, quint64 aValue )
+	{
+		aValue += 0x9e3779b97f4a7c15ULL;
+		aValue  = ( aValue ^ ( aValue >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+		aValue  = ( aValue ^ ( aValue >> 27 ) ) * 0x94d049bb133111ebULL;
+		aValue ^= aValue >> 31;
+
+		return ( aHash ^ aValue ) * 0x100000001b3ULL;
+	};
+
+	auto keys = commonKeys();
+	keys.sort();
+
+	int keyCount     = keys.size();
+	int featureCount = mFDB.columnCount();
+
+	QVector< quint64 > rowHashes( keyCount, 0 );
+
+	#pragma omp parallel for schedule( static )
+	for ( int keyIndex = 0; keyIndex < keyCount; ++keyIndex )
+	{
+		const QString& key = keys.at( keyIndex );
+		quint64 hash       = combine( 0xcbf29ce484222325ULL, qHash( key ) );
+		hash               = combine( hash, qHash( mLDB.valueAt( key, mActiveLabelIndex ).toString() ) );
+
+		const QVariantList& values = mFDB.table().constFind( key ).value();
+		for ( auto& value : values )
+		{
+			double number = value.toDouble();
+			quint64 bits;
+			std::memcpy( &bits, &number, sizeof( bits ) );
+			hash = combine( hash, bits );
+		}
+
+		rowHashes[ keyIndex ] = hash;
+	}
+
+	quint64 fingerprint = combine( 0xcbf29ce484222325ULL, quint64( keyCount ) );
+	fingerprint         = combine( fingerprint, quint64( featureCount ) );
+	fingerprint         = combine( fingerprint, quint64( mActiveLabelIndex ) );
+
+	for ( auto& headerName : mFDB.headerNames() )
+	{
+		fingerprint = combine( fingerprint, qHash( headerName ) );
+	}
+
+	for ( auto rowHash : rowHashes )
+	{
+		fingerprint = combine( fingerprint, rowHash );
+	}
+
+	std::atomic_store( &mFingerprint, std::shared_ptr< const quint64 >( std::make_shared< quint64 >( fingerprint ) ) );
+
+	return fingerprint;
+}
+
 //-----------------------------------------------------------------------------
 //Used in: FeatureSelection
 lpmldata::TabularData DataPackage::featureDatabaseSubset( QStringList aFeatureNames ) const
@@ -290,32 +360,21 @@ lpmldata::TabularData DataPackage::sampleDatabaseSubset( const QStringList& aKey
 
 //-----------------------------------------------------------------------------
 //Used in: Oversampling
-lpmldata::TabularData DataPackage::sampleDatabaseSubset( QMap< QString, QVector< double > >& aSynthSamples ) const
+lpmldata::TabularData DataPackage::sampleDatabaseSubset( const QStringList& aSyntheticKeys, const lpmldata::Array2D< double >& aSyntheticRows ) const
 {
 	lpmldata::TabularData filteredFDB;
 	auto headers = mFDB.headerNames();
 	filteredFDB.setHeader( headers );
 
 	auto keys = commonKeys();
+	filteredFDB.table().reserve( keys.size() + aSyntheticKeys.size() );
 
-	for ( int i = 0; i < keys.size(); ++i )
+	for ( auto& key : keys )
 	{
-		QVariantList featureRow;
-
-		for ( auto& key : keys )
-		{
-			featureRow = mFDB.value( key );
-
-			filteredFDB.insert( key, featureRow );
-		}
+		filteredFDB.insert( key, mFDB.value( key ) );
 	}
 
-	for ( int i = 0; i < aSynthSamples.size(); ++i )
-	{
-		auto key           = aSynthSamples.keys().at( i );
-		auto featureVector = aSynthSamples.value( key );		
-		filteredFDB.insert( key, toQVariantList( featureVector ) );
-	}
+	filteredFDB.appendRows( aSyntheticKeys, aSyntheticRows );
 
 	return filteredFDB;
 }
@@ -384,68 +443,170 @@ QMap< QString, QStringList > DataPackage::keysOfLabelGroups() const
 QMap< QString, double >  DataPackage::distance( const QMap< QString, QVariantList >& aFirst, const QMap< QString, QVariantList >& aSecond ) const
 {
 	QMap< QString, double > dist;
-	QString names;
 
-	double squared            = 0.0;
-	double substractedSquared = 0.0;
+	if ( aFirst.isEmpty() || aSecond.isEmpty() )
+	{
+		return dist;
+	}
+
+	dist.insert( aSecond.lastKey(), distance( aFirst.first(), aSecond.first() ) );
+
+	return dist;
+}
+
+//-----------------------------------------------------------------------------
+
+double DataPackage::distance( QVector< double >& aFirst, QVector< double >& aSecond )
+{
+	return lpmldata::DistanceKernels::euclidean( aFirst.constData(), aSecond.constData(), std::min( aFirst.size(), aSecond.size() ) );
+}
+
+//-----------------------------------------------------------------------------
+
+double DataPackage::distance( const QVariantList& aFirst, const QVariantList& aSecond ) const
+{
+	//Convert once into dense rows for the vectorized kernel
+	int size = std::min( aFirst.size(), aSecond.size() );
+
+	QVector< double > first( size );
+	QVector< double > second( size );
+
+	for ( int i = 0; i < size; ++i )
+	{
+		first[ i ]  = aFirst.at( i ).toDouble();
+		second[ i ] = aSecond.at( i ).toDouble();
+	}
+
+	return lpmldata::DistanceKernels::euclidean( first.constData(), second.constData(), size );
+}
+
+//-----------------------------------------------------------------------------
 
+std::shared_ptr< const lpmldata::PairwiseDistanceMatrix > DataPackage::pairwiseDistances( DistancePrecision aPrecision ) const
+{
+	bool isValid = mPairwiseDistances != nullptr && mPairwiseDistances->isMatching( mFDB );
 
-	auto firstValues  = aFirst.values().at( 0 );
-	auto secondValues = aSecond.values().at( 0 );
+	if ( isValid && aPrecision == DistancePrecision::Double && mPairwiseDistances->precision() == DistancePrecision::Single )
+	{
+		isValid = false;
+	}
 
-	for ( int i = 0; i < aFirst.keys().size(); ++i )
+	if ( !isValid )
 	{
+		mPairwiseDistances = std::make_shared< lpmldata::PairwiseDistanceMatrix >( mFDB, aPrecision );
+	}
 
-		for ( int j = 0; j < firstValues.size(); ++j )
+	return mPairwiseDistances;
+}
+
+//-----------------------------------------------------------------------------
+
+template < typename Index >
+std::shared_ptr< Index > DataPackage::cachedIndex( QList< QPair< QStringList, std::shared_ptr< Index > > >& aCache, const QStringList& aSortedKeys ) const
+{
+	// The number of requested samples present in the feature database, an index is stale if it differs.
+	int presentCount = 0;
+	if ( aSortedKeys.isEmpty() )
+	{
+		presentCount = mFDB.rowCount();
+	}
+	else
+	{
+		for ( auto& key : aSortedKeys )
+		{
+			if ( mFDB.table().contains( key ) ) ++presentCount;
+		}
+	}
+
+	for ( int entryIndex = 0; entryIndex < aCache.size(); ++entryIndex )
+	{
+		if ( aCache.at( entryIndex ).first != aSortedKeys )
 		{
-			auto secondNames = aSecond.keys().at( i );
-			auto firstNames = aFirst.keys().at( i );
+			continue;
+		}
+
+		auto index   = aCache.at( entryIndex ).second;
+		bool isValid = int( index->sampleCount() ) == presentCount;
 
-			substractedSquared = pow( secondValues.at( j ).toDouble() - firstValues.at( j ).toDouble(), 2.0 );
-			substractedSquared += substractedSquared;
-			names = secondNames;
+		if ( isValid && aSortedKeys.isEmpty() )
+		{
+			for ( auto iterator = mFDB.table().constBegin(); iterator != mFDB.table().constEnd() && isValid; ++iterator )
+			{
+				isValid = index->indexOf( iterator.key() ) >= 0;
+			}
+		}
+
+		aCache.removeAt( entryIndex );
+
+		if ( isValid )
+		{
+			aCache.prepend( qMakePair( aSortedKeys, index ) );
+			return index;
 		}
 
+		break;
 	}
-	squared = sqrt( substractedSquared );
 
-	dist.insert( names, squared );
+	return nullptr;
+}
 
-	return dist;
+//-----------------------------------------------------------------------------
+
+template < typename Index >
+void DataPackage::cacheIndex( QList< QPair< QStringList, std::shared_ptr< Index > > >& aCache, const QStringList& aSortedKeys, std::shared_ptr< Index > aIndex ) const
+{
+	const int maximumCachedIndexCount = 4;
+
+	for ( int entryIndex = aCache.size() - 1; entryIndex >= 0; --entryIndex )
+	{
+		if ( aCache.at( entryIndex ).first == aSortedKeys )
+		{
+			aCache.removeAt( entryIndex );
+		}
+	}
+
+	aCache.prepend( qMakePair( aSortedKeys, aIndex ) );
+
+	while ( aCache.size() > maximumCachedIndexCount )
+	{
+		aCache.removeLast();
+	}
 }
 
 //-----------------------------------------------------------------------------
 
-double DataPackage::distance( QVector< double >& aFirst, QVector< double >& aSecond )
+std::shared_ptr< const lpmldata::NearestNeighbourIndex > DataPackage::nearestNeighbourIndex( const QStringList& aKeys ) const
 {
-	double dist               = 0.0;
-	double substractedSquared = 0.0;
+	QStringList keys = aKeys;
+	keys.sort();
+
+	auto index = cachedIndex( mNeighbourIndices, keys );
 
-	for ( int i = 0; i < aFirst.size(); ++i )
+	if ( index == nullptr )
 	{
-		substractedSquared = pow( aSecond.at( i ) - aFirst.at( i ), 2.0 );
-		substractedSquared += substractedSquared;
+		index = std::make_shared< lpmldata::NearestNeighbourIndex >( mFDB, keys );
+		cacheIndex( mNeighbourIndices, keys, index );
 	}
-	dist = sqrt( substractedSquared );
 
-	return dist;
+	return index;
 }
 
 //-----------------------------------------------------------------------------
 
-double DataPackage::distance( const QVariantList& aFirst, const QVariantList& aSecond ) const
+std::shared_ptr< const lpmldata::HnswIndex > DataPackage::approximateNeighbourIndex( const QStringList& aKeys, unsigned int aConnectionCount, unsigned int aConstructionBreadth ) const
 {
-	double dist               = 0.0;
-	double substractedSquared = 0.0;
+	QStringList keys = aKeys;
+	keys.sort();
 
-	for ( int i = 0; i < aFirst.size(); ++i )
+	auto index = cachedIndex( mApproximateNeighbourIndices, keys );
+
+	if ( index == nullptr || index->connectionCount() != std::max( aConnectionCount, 2u ) || index->constructionBreadth() < aConstructionBreadth )
 	{
-		substractedSquared = pow( aSecond.at( i ).toDouble() - aFirst.at( i ).toDouble(), 2.0 );
-		substractedSquared += substractedSquared;
+		index = std::make_shared< lpmldata::HnswIndex >( mFDB, keys, QVector< double >(), aConnectionCount, aConstructionBreadth );
+		cacheIndex( mApproximateNeighbourIndices, keys, index );
 	}
-	dist = sqrt( substractedSquared );
 
-	return dist;
+	return index;
 }
 
 //-----------------------------------------------------------------------------
@@ -624,6 +785,7 @@ void DataPackage::initialize( lpmldata::TabularData& aFDB, lpmldata::TabularData
 {
 	mFDB       = aFDB;
 	mLDB       = aLDB;
+	invalidateCaches();
 	mLabelName = aLabelName;
 	
 
@@ -986,25 +1148,44 @@ void DataPackage::updateLDB()
 	lpmldata::TabularData updatedLDB;
 
 	mLDB = labelDatabaseSubset( mFDB.keys() );	
+	mFingerprint.reset();
 }
 
 //-----------------------------------------------------------------------------
 
 lpmldata::TabularData DataPackage::normalizeData()
 {
-	QVector< QVector< double > > normalizedFeatureColumns;
+	// The column statistics are cached by the feature database, the features are not collected one by one.
+	const lpmldata::TabularData& FDB = mFDB;
+	auto columnStatistics            = FDB.columnStatistics();
+	int featureCount                 = columnStatistics.columnCount();
 
-	auto featureNames = mFDB.headerNames();
-	
-	for ( auto& featureName : featureNames )
-	{
-		auto featureColumn           = this->featureColumn( featureName );
-		auto normalizedFeatureColumn = this->normalizeFeature( featureColumn );
+	QVector< double > means( featureCount );
+	QVector< double > standardDeviations( featureCount );
 
-		normalizedFeatureColumns.push_back( normalizedFeatureColumn );
+	for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+	{
+		means[ featureIndex ]              = columnStatistics.mean( featureIndex );
+		standardDeviations[ featureIndex ] = std::sqrt( columnStatistics.variance( featureIndex ) * columnStatistics.count( featureIndex ) );  // Same scaling as normalizeFeature().
 	}
 
-	auto normalizedFDB = this->featureDatabaseSubset( normalizedFeatureColumns );
+	lpmldata::TabularData normalizedFDB;
+	normalizedFDB.setHeader( FDB.headerNames() );
+
+	for ( auto rowIterator = FDB.table().constBegin(); rowIterator != FDB.table().constEnd(); ++rowIterator )
+	{
+		const QVariantList& featureRow = rowIterator.value();
+
+		QVariantList normalizedRow;
+		normalizedRow.reserve( featureCount );
+
+		for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+		{
+			normalizedRow.push_back( ( featureRow.at( featureIndex ).toDouble() - means.at( featureIndex ) ) / standardDeviations.at( featureIndex ) );
+		}
+
+		normalizedFDB.insert( rowIterator.key(), normalizedRow );
+	}
 
 	return normalizedFDB;
 }
@@ -13,9 +13,14 @@
 
 #include <DataRepresentation/Export.h>
 #include <DataRepresentation/TabularData.h>
+#include <DataRepresentation/Array2D.h>
+#include <DataRepresentation/PairwiseDistanceMatrix.h>
+#include <DataRepresentation/NearestNeighbourIndex.h>
+#include <DataRepresentation/HnswIndex.h>
 #include <QDebug>
 #include <QString>
 #include <QList>
+#include <memory>
 
 namespace lpmldata
 {
@@ -35,7 +40,11 @@ public:
 		mSampleKeys(),
 		mIsValidDataset(),
 		mFeatureCount(),
-		mIncludedKeys()
+		mIncludedKeys(),
+		mPairwiseDistances(),
+		mNeighbourIndices(),
+		mApproximateNeighbourIndices(),
+		mFingerprint()
 	{
 		mLabelName = mLDB.headerNames().at( 0 );
 		initialize( aFDB, aLDB, mLabelName );
@@ -57,22 +66,31 @@ public:
 
 	lpmldata::TabularData& featureDatabase()
 	{
+		invalidateCaches();  // The caller may change the samples through the reference.
 		return mFDB;
 	}
 
 	lpmldata::TabularData& labelDatabase()
 	{
+		mFingerprint.reset();
 		return mLDB;
 	}
 
 	void setActiveLabel( QString aLabel );
 
-	void setActiveLabelIndex( int aIndex ) { mActiveLabelIndex = aIndex; };
+	void setActiveLabelIndex( int aIndex ) { mActiveLabelIndex = aIndex; mFingerprint.reset(); };
 
 	const QStringList labelGroups() const;	
 
 	QStringList commonKeys() const;
 
+	/*!
+	* \brief 64-bit hash of the common samples with their feature values and active labels, the header and the active label index.
+	* \details Equal packages give equal fingerprints, used to reuse results computed for the same data.
+	* Computed on first use and kept until the samples, the labels or the active label change.
+	*/
+	quint64 fingerprint() const;
+
 	int activeLabelIndex() const
 	{
 		return mActiveLabelIndex;
@@ -97,7 +115,7 @@ public:
 	lpmldata::TabularData featureDatabaseSubset( QVector< QVector< double > >& aFeatureColumns ) const;
 	//In sample space
 	lpmldata::TabularData sampleDatabaseSubset( const QStringList& aKeys ) const; //Used in: IsolationForest, TomekLinks, RandomUndersampling
-	lpmldata::TabularData sampleDatabaseSubset( QMap< QString, QVector< double > >& aSynthSamples ) const; //Used in: Oversampling
+	lpmldata::TabularData sampleDatabaseSubset( const QStringList& aSyntheticKeys, const lpmldata::Array2D< double >& aSyntheticRows ) const; //Used in: Oversampling, the synthetic rows are appended in one block
 	lpmldata::TabularData syntheticSampleDatabaseSubset( QMap< QString, QVector< double > >& aSynthSamples ) const;
 
 	//Store LDB 
@@ -115,6 +133,33 @@ public:
 	double distance( QVector< double >& aFirst, QVector< double >& aSecond );
 	double distance( const QVariantList& aFirst, const QVariantList& aSecond ) const;
 
+	/*!
+	* \brief Euclidean distances between all samples of the feature database, computed on first use and shared by the resampling methods.
+	* \details Recomputed if the sample keys changed since the last call or if double precision is requested after a single precision computation.
+	* Not synchronized, do not call it concurrently on the same package.
+	* \param [in] aPrecision Storage precision used when the matrix has to be computed.
+	*/
+	std::shared_ptr< const lpmldata::PairwiseDistanceMatrix > pairwiseDistances( DistancePrecision aPrecision = DistancePrecision::Double ) const;
+
+	/*!
+	* \brief k-d tree over the feature rows of the given samples, built on first use and shared by the resampling methods.
+	* \details The last few indices are kept, an index is rebuilt if any of its samples was added or removed since.
+	* Not synchronized, do not call it concurrently on the same package.
+	* \param [in] aKeys The indexed samples, all samples of the feature database if empty.
+	*/
+	std::shared_ptr< const lpmldata::NearestNeighbourIndex > nearestNeighbourIndex( const QStringList& aKeys = QStringList() ) const;
+
+	/*!
+	* \brief Approximate (HNSW) neighbour graph over the feature rows of the given samples, cached like nearestNeighbourIndex().
+	* \details A cached graph is rebuilt if it was built with a different connection count or a smaller construction breadth.
+	* \param [in] aKeys The indexed samples, all samples of the feature database if empty.
+	* \param [in] aConnectionCount Links of a sample on the upper layers (M).
+	* \param [in] aConstructionBreadth Candidate list size while building (efConstruction).
+	*/
+	std::shared_ptr< const lpmldata::HnswIndex > approximateNeighbourIndex( const QStringList& aKeys = QStringList(), unsigned int aConnectionCount = 16, unsigned int aConstructionBreadth = 200 ) const;
+
+	void invalidateCaches() { mPairwiseDistances.reset(); mNeighbourIndices.clear(); mApproximateNeighbourIndices.clear(); mFingerprint.reset(); }
+
 	//lpmldata::TabularData normalize( const lpmldata::TabularData& aFDB ) const;
 	double mean( const double& aSum, const int& aColumnSize ) const;
 	double standardDeviation( const QVector< QVariant >& aFeatureColumn, const double& aMean ) const;
@@ -154,6 +199,13 @@ public:
 	QStringList keysByLabelGroup( const lpmldata::TabularData& aLabelDatabase, const int aLabelIndex, const QString aReferenceLabel );
 	void updateLDB();
 
+private:
+	template < typename Index >
+	std::shared_ptr< Index > cachedIndex( QList< QPair< QStringList, std::shared_ptr< Index > > >& aCache, const QStringList& aSortedKeys ) const;
+
+	template < typename Index >
+	void cacheIndex( QList< QPair< QStringList, std::shared_ptr< Index > > >& aCache, const QStringList& aSortedKeys, std::shared_ptr< Index > aIndex ) const;
+
 private:
 	lpmldata::TabularData  mFDB;
 	lpmldata::TabularData  mLDB;
@@ -165,6 +217,11 @@ private:
 	bool                   mIsValidDataset;
 	int                    mFeatureCount;
 	QStringList            mIncludedKeys;
+
+	mutable std::shared_ptr< lpmldata::PairwiseDistanceMatrix >  mPairwiseDistances;  //!< Lazily computed, copies of the package share it until their samples change.
+	mutable QList< QPair< QStringList, std::shared_ptr< lpmldata::NearestNeighbourIndex > > >  mNeighbourIndices;  //!< Sorted requested keys and the index built for them, most recent first.
+	mutable QList< QPair< QStringList, std::shared_ptr< lpmldata::HnswIndex > > >              mApproximateNeighbourIndices;  //!< Same for the approximate graphs.
+	mutable std::shared_ptr< const quint64 >  mFingerprint;  //!< Lazily computed fingerprint(), swapped atomically as packages may be ranked from several threads.
 };
 
 }
@@ -0,0 +1,358 @@
+/*!
+* \file
+* Member function definitions for DistanceKernels class. This file is part of DataRepresentation module.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#include <DataRepresentation/DistanceKernels.h>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#	define LPMLDATA_X86
+#	include <immintrin.h>
+#	if defined( _MSC_VER )
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+namespace lpmldata
+{
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Scalar fallback
+
+namespace scalar
+{
+
+struct Simd
+{
+	typedef double Vector;
+	static const unsigned int width = 1;
+
+	static Vector zero() { return 0.0; }
+	static Vector broadcast( double aValue ) { return aValue; }
+	static Vector load( const double* aData ) { return *aData; }
+	static void store( double* aData, Vector aValue ) { *aData = aValue; }
+	static Vector add( Vector aFirst, Vector aSecond ) { return aFirst + aSecond; }
+	static Vector sub( Vector aFirst, Vector aSecond ) { return aFirst - aSecond; }
+	static Vector mul( Vector aFirst, Vector aSecond ) { return aFirst * aSecond; }
+	static Vector multiplyAdd( Vector aFirst, Vector aSecond, Vector aAddend ) { return aFirst * aSecond + aAddend; }
+	static Vector abs( Vector aValue ) { return std::abs( aValue ); }
+	static double sum( Vector aValue ) { return aValue; }
+};
+
+#include <DataRepresentation/DistanceKernelsSimd.h>
+
+}
+
+#if defined( LPMLDATA_X86 )
+
+//-----------------------------------------------------------------------------
+// AVX2 + FMA
+
+#if defined( __GNUC__ )
+#	pragma GCC push_options
+#	pragma GCC target( "avx2,fma" )
+#endif
+
+namespace avx2
+{
+
+struct Simd
+{
+	typedef __m256d Vector;
+	static const unsigned int width = 4;
+
+	static Vector zero() { return _mm256_setzero_pd(); }
+	static Vector broadcast( double aValue ) { return _mm256_set1_pd( aValue ); }
+	static Vector load( const double* aData ) { return _mm256_loadu_pd( aData ); }
+	static void store( double* aData, Vector aValue ) { _mm256_storeu_pd( aData, aValue ); }
+	static Vector add( Vector aFirst, Vector aSecond ) { return _mm256_add_pd( aFirst, aSecond ); }
+	static Vector sub( Vector aFirst, Vector aSecond ) { return _mm256_sub_pd( aFirst, aSecond ); }
+	static Vector mul( Vector aFirst, Vector aSecond ) { return _mm256_mul_pd( aFirst, aSecond ); }
+	static Vector multiplyAdd( Vector aFirst, Vector aSecond, Vector aAddend ) { return _mm256_fmadd_pd( aFirst, aSecond, aAddend ); }
+	static Vector abs( Vector aValue ) { return _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), aValue ); }
+
+	static double sum( Vector aValue )
+	{
+		__m128d low  = _mm_add_pd( _mm256_castpd256_pd128( aValue ), _mm256_extractf128_pd( aValue, 1 ) );
+		__m128d high = _mm_unpackhi_pd( low, low );
+		return _mm_cvtsd_f64( _mm_add_sd( low, high ) );
+	}
+};
+
+#include <DataRepresentation/DistanceKernelsSimd.h>
+
+}
+
+#if defined( __GNUC__ )
+#	pragma GCC pop_options
+#endif
+
+//-----------------------------------------------------------------------------
+// AVX-512F
+
+#if defined( __GNUC__ )
+#	pragma GCC push_options
+#	pragma GCC target( "avx512f,avx2,fma" )
+#endif
+
+namespace avx512
+{
+
+struct Simd
+{
+	typedef __m512d Vector;
+	static const unsigned int width = 8;
+
+	static Vector zero() { return _mm512_setzero_pd(); }
+	static Vector broadcast( double aValue ) { return _mm512_set1_pd( aValue ); }
+	static Vector load( const double* aData ) { return _mm512_loadu_pd( aData ); }
+	static void store( double* aData, Vector aValue ) { _mm512_storeu_pd( aData, aValue ); }
+	static Vector add( Vector aFirst, Vector aSecond ) { return _mm512_add_pd( aFirst, aSecond ); }
+	static Vector sub( Vector aFirst, Vector aSecond ) { return _mm512_sub_pd( aFirst, aSecond ); }
+	static Vector mul( Vector aFirst, Vector aSecond ) { return _mm512_mul_pd( aFirst, aSecond ); }
+	static Vector multiplyAdd( Vector aFirst, Vector aSecond, Vector aAddend ) { return _mm512_fmadd_pd( aFirst, aSecond, aAddend ); }
+	static Vector abs( Vector aValue ) { return _mm512_max_pd( aValue, _mm512_sub_pd( _mm512_setzero_pd(), aValue ) ); }
+
+	static double sum( Vector aValue )
+	{
+		__m256d half = _mm256_add_pd( _mm512_castpd512_pd256( aValue ), _mm512_extractf64x4_pd( aValue, 1 ) );
+		__m128d low  = _mm_add_pd( _mm256_castpd256_pd128( half ), _mm256_extractf128_pd( half, 1 ) );
+		__m128d high = _mm_unpackhi_pd( low, low );
+		return _mm_cvtsd_f64( _mm_add_sd( low, high ) );
+	}
+};
+
+#include <DataRepresentation/DistanceKernelsSimd.h>
+
+}
+
+#if defined( __GNUC__ )
+#	pragma GCC pop_options
+#endif
+
+#endif
+
+//-----------------------------------------------------------------------------
+// Runtime dispatch
+
+struct KernelTable
+{
+	SimdLevel level;
+	double ( *squaredEuclidean )( const double*, const double*, unsigned int );
+	double ( *manhattan )( const double*, const double*, unsigned int );
+	void ( *dotProducts )( const double*, const double*, unsigned int, double&, double&, double& );
+	void ( *interpolate )( const double*, const double*, double, unsigned int, double* );
+};
+
+KernelTable kernelTable( SimdLevel aLevel )
+{
+#if defined( LPMLDATA_X86 )
+	if ( aLevel == SimdLevel::Avx512 )
+	{
+		return { SimdLevel::Avx512, &avx512::squaredEuclidean, &avx512::manhattan, &avx512::dotProducts, &avx512::interpolate };
+	}
+	if ( aLevel == SimdLevel::Avx2 )
+	{
+		return { SimdLevel::Avx2, &avx2::squaredEuclidean, &avx2::manhattan, &avx2::dotProducts, &avx2::interpolate };
+	}
+#endif
+	return { SimdLevel::Scalar, &scalar::squaredEuclidean, &scalar::manhattan, &scalar::dotProducts, &scalar::interpolate };
+}
+
+//-----------------------------------------------------------------------------
+
+SimdLevel detectSimdLevel()
+{
+#if defined( LPMLDATA_X86 )
+	unsigned int info[ 4 ] = { 0, 0, 0, 0 };
+	unsigned long long xcr0 = 0;
+
+#	if defined( _MSC_VER )
+	auto cpuid = [ &info ]( int aLeaf ) { int registers[ 4 ]; __cpuidex( registers, aLeaf, 0 ); for ( int i = 0; i < 4; ++i ) info[ i ] = registers[ i ]; };
+#	else
+	auto cpuid = [ &info ]( int aLeaf ) { __cpuid_count( aLeaf, 0, info[ 0 ], info[ 1 ], info[ 2 ], info[ 3 ] ); };
+#	endif
+
+	cpuid( 0 );
+	if ( info[ 0 ] < 7 )
+	{
+		return SimdLevel::Scalar;
+	}
+
+	cpuid( 1 );
+	bool isFma     = ( info[ 2 ] & ( 1u << 12 ) ) != 0;
+	bool isOsxsave = ( info[ 2 ] & ( 1u << 27 ) ) != 0;
+	bool isAvx     = ( info[ 2 ] & ( 1u << 28 ) ) != 0;
+
+	if ( !isFma || !isOsxsave || !isAvx )
+	{
+		return SimdLevel::Scalar;
+	}
+
+	// The operating system has to save the wide registers on context switch.
+#	if defined( _MSC_VER )
+	xcr0 = _xgetbv( 0 );
+#	else
+	unsigned int xcr0Low;
+	unsigned int xcr0High;
+	__asm__ __volatile__( "xgetbv" : "=a"( xcr0Low ), "=d"( xcr0High ) : "c"( 0 ) );
+	xcr0 = ( static_cast< unsigned long long >( xcr0High ) << 32 ) | xcr0Low;
+#	endif
+
+	if ( ( xcr0 & 0x6 ) != 0x6 )
+	{
+		return SimdLevel::Scalar;
+	}
+
+	cpuid( 7 );
+	bool isAvx2    = ( info[ 1 ] & ( 1u << 5 ) ) != 0;
+	bool isAvx512F = ( info[ 1 ] & ( 1u << 16 ) ) != 0;
+
+	if ( isAvx512F && ( xcr0 & 0xE6 ) == 0xE6 )
+	{
+		return SimdLevel::Avx512;
+	}
+
+	if ( isAvx2 )
+	{
+		return SimdLevel::Avx2;
+	}
+#endif
+
+	return SimdLevel::Scalar;
+}
+
+//-----------------------------------------------------------------------------
+
+KernelTable& activeKernels()
+{
+	static KernelTable kernels = kernelTable( DistanceKernels::supportedSimdLevel() );
+	return kernels;
+}
+
+//-----------------------------------------------------------------------------
+
+inline double evaluate( const KernelTable& aKernels, DistanceMetric aMetric, const double* aFirst, const double* aSecond, unsigned int aSize )
+{
+	switch ( aMetric )
+	{
+		case DistanceMetric::SquaredEuclidean:
+			return aKernels.squaredEuclidean( aFirst, aSecond, aSize );
+
+		case DistanceMetric::Euclidean:
+			return std::sqrt( aKernels.squaredEuclidean( aFirst, aSecond, aSize ) );
+
+		case DistanceMetric::Manhattan:
+			return aKernels.manhattan( aFirst, aSecond, aSize );
+
+		case DistanceMetric::Cosine:
+		{
+			double firstSecond;
+			double firstFirst;
+			double secondSecond;
+			aKernels.dotProducts( aFirst, aSecond, aSize, firstSecond, firstFirst, secondSecond );
+
+			if ( firstFirst <= 0.0 || secondSecond <= 0.0 )
+			{
+				return 1.0;
+			}
+
+			return 1.0 - firstSecond / std::sqrt( firstFirst * secondSecond );
+		}
+	}
+
+	return 0.0;
+}
+
+}
+
+//-----------------------------------------------------------------------------
+
+double DistanceKernels::squaredEuclidean( const double* aFirst, const double* aSecond, unsigned int aSize )
+{
+	return activeKernels().squaredEuclidean( aFirst, aSecond, aSize );
+}
+
+//-----------------------------------------------------------------------------
+
+double DistanceKernels::manhattan( const double* aFirst, const double* aSecond, unsigned int aSize )
+{
+	return activeKernels().manhattan( aFirst, aSecond, aSize );
+}
+
+//-----------------------------------------------------------------------------
+
+double DistanceKernels::cosine( const double* aFirst, const double* aSecond, unsigned int aSize )
+{
+	return evaluate( activeKernels(), DistanceMetric::Cosine, aFirst, aSecond, aSize );
+}
+
+//-----------------------------------------------------------------------------
+
+double DistanceKernels::distance( DistanceMetric aMetric, const double* aFirst, const double* aSecond, unsigned int aSize )
+{
+	return evaluate( activeKernels(), aMetric, aFirst, aSecond, aSize );
+}
+
+//-----------------------------------------------------------------------------
+
+void DistanceKernels::oneToMany( DistanceMetric aMetric, const double* aQuery, const double* aRows, unsigned int aRowCount, unsigned int aSize, double* aDistances, unsigned int aRowStride )
+{
+	const KernelTable& kernels = activeKernels();
+	const unsigned int rowStride = aRowStride == 0 ? aSize : aRowStride;
+	const int rowCount = static_cast< int >( aRowCount );
+
+	// Only large batches are split, callers often run in parallel regions already.
+	#pragma omp parallel for schedule( static ) if ( rowCount >= 4096 )
+	for ( int rowIndex = 0; rowIndex < rowCount; ++rowIndex )
+	{
+		aDistances[ rowIndex ] = evaluate( kernels, aMetric, aQuery, aRows + static_cast< std::size_t >( rowIndex ) * rowStride, aSize );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void DistanceKernels::interpolate( const double* aFirst, const double* aSecond, double aFactor, unsigned int aSize, double* aResult )
+{
+	activeKernels().interpolate( aFirst, aSecond, aFactor, aSize, aResult );
+}
+
+//-----------------------------------------------------------------------------
+
+SimdLevel DistanceKernels::simdLevel()
+{
+	return activeKernels().level;
+}
+
+//-----------------------------------------------------------------------------
+
+SimdLevel DistanceKernels::supportedSimdLevel()
+{
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+//-----------------------------------------------------------------------------
+
+void DistanceKernels::setSimdLevel( SimdLevel aLevel )
+{
+	// Not synchronized, call it before starting parallel work.
+	activeKernels() = kernelTable( std::min( aLevel, supportedSimdLevel() ) );
+}
+
+//-----------------------------------------------------------------------------
+
+}
@@ -0,0 +1,90 @@
+/*!
+* \file
+* DistanceKernels class definition. This file is part of DataRepresentation module.
+* The DistanceKernels provide distance computations and the row interpolation of the oversampling over contiguous double rows. The AVX2 or AVX-512 implementation is selected once at runtime based on the CPU, with a scalar fallback.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <DataRepresentation/Export.h>
+#include <cmath>
+
+namespace lpmldata
+{
+
+//-----------------------------------------------------------------------------
+
+enum class DistanceMetric
+{
+	SquaredEuclidean = 0,
+	Euclidean,
+	Manhattan,
+	Cosine            //!< 1 - cosine similarity, 1 if any of the vectors is zero.
+};
+
+enum class SimdLevel
+{
+	Scalar = 0,
+	Avx2,
+	Avx512
+};
+
+//-----------------------------------------------------------------------------
+
+class DataRepresentation_API DistanceKernels
+{
+
+public:
+
+	static double squaredEuclidean( const double* aFirst, const double* aSecond, unsigned int aSize );
+
+	static double euclidean( const double* aFirst, const double* aSecond, unsigned int aSize ) { return std::sqrt( squaredEuclidean( aFirst, aSecond, aSize ) ); }
+
+	static double manhattan( const double* aFirst, const double* aSecond, unsigned int aSize );
+
+	static double cosine( const double* aFirst, const double* aSecond, unsigned int aSize );
+
+	static double distance( DistanceMetric aMetric, const double* aFirst, const double* aSecond, unsigned int aSize );
+
+	/*!
+	* \brief Distances of one query row to a block of rows.
+	* \param [in] aMetric The distance metric.
+	* \param [in] aQuery The query row of aSize values.
+	* \param [in] aRows The first row of the block.
+	* \param [in] aRowCount The number of rows in the block.
+	* \param [in] aSize The number of values in each row.
+	* \param [out] aDistances Caller provided buffer of aRowCount values.
+	* \param [in] aRowStride Distance between the starts of consecutive rows, 0 means densely packed rows (aSize).
+	*/
+	static void oneToMany( DistanceMetric aMetric, const double* aQuery, const double* aRows, unsigned int aRowCount, unsigned int aSize, double* aDistances, unsigned int aRowStride = 0 );
+
+	/*!
+	* \brief Point on the segment between two rows, aResult = aFirst + aFactor * ( aSecond - aFirst ).
+	* \details aResult may alias aFirst or aSecond.
+	*/
+	static void interpolate( const double* aFirst, const double* aSecond, double aFactor, unsigned int aSize, double* aResult );
+
+	/*!
+	* \brief The instruction set used by the kernels.
+	*/
+	static SimdLevel simdLevel();
+
+	/*!
+	* \brief The best instruction set supported by the CPU and the operating system.
+	*/
+	static SimdLevel supportedSimdLevel();
+
+	/*!
+	* \brief Forces an instruction set, e.g. for benchmarking. Levels above supportedSimdLevel() are clamped.
+	*/
+	static void setSimdLevel( SimdLevel aLevel );
+};
+
+//-----------------------------------------------------------------------------
+
+}
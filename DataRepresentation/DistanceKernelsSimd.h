@@ -0,0 +1,126 @@
+/*!
+* \file
+* Distance kernel bodies written against a small SIMD wrapper. This file is part of DataRepresentation module.
+* It is intentionally without include guard: DistanceKernels.cpp includes it once per instruction set, inside a namespace that defines the Simd wrapper type:
+*   Simd::Vector, Simd::width, zero(), broadcast(), load(), store(), sub(), add(), mul(), multiplyAdd(), abs() and sum().
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+//-----------------------------------------------------------------------------
+
+double squaredEuclidean( const double* aFirst, const double* aSecond, unsigned int aSize )
+{
+	// Two accumulators hide the latency of the fused multiply-add.
+	Simd::Vector first  = Simd::zero();
+	Simd::Vector second = Simd::zero();
+
+	unsigned int i = 0;
+
+	for ( ; i + 2 * Simd::width <= aSize; i += 2 * Simd::width )
+	{
+		Simd::Vector firstDifference  = Simd::sub( Simd::load( aFirst + i ), Simd::load( aSecond + i ) );
+		Simd::Vector secondDifference = Simd::sub( Simd::load( aFirst + i + Simd::width ), Simd::load( aSecond + i + Simd::width ) );
+
+		first  = Simd::multiplyAdd( firstDifference, firstDifference, first );
+		second = Simd::multiplyAdd( secondDifference, secondDifference, second );
+	}
+
+	for ( ; i + Simd::width <= aSize; i += Simd::width )
+	{
+		Simd::Vector difference = Simd::sub( Simd::load( aFirst + i ), Simd::load( aSecond + i ) );
+
+		first = Simd::multiplyAdd( difference, difference, first );
+	}
+
+	double result = Simd::sum( Simd::add( first, second ) );
+
+	for ( ; i < aSize; ++i )
+	{
+		double difference = aFirst[ i ] - aSecond[ i ];
+		result += difference * difference;
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+double manhattan( const double* aFirst, const double* aSecond, unsigned int aSize )
+{
+	Simd::Vector accumulator = Simd::zero();
+
+	unsigned int i = 0;
+
+	for ( ; i + Simd::width <= aSize; i += Simd::width )
+	{
+		accumulator = Simd::add( accumulator, Simd::abs( Simd::sub( Simd::load( aFirst + i ), Simd::load( aSecond + i ) ) ) );
+	}
+
+	double result = Simd::sum( accumulator );
+
+	for ( ; i < aSize; ++i )
+	{
+		result += std::abs( aFirst[ i ] - aSecond[ i ] );
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+void dotProducts( const double* aFirst, const double* aSecond, unsigned int aSize, double& aFirstSecond, double& aFirstFirst, double& aSecondSecond )
+{
+	Simd::Vector firstSecond   = Simd::zero();
+	Simd::Vector firstFirst    = Simd::zero();
+	Simd::Vector secondSecond  = Simd::zero();
+
+	unsigned int i = 0;
+
+	for ( ; i + Simd::width <= aSize; i += Simd::width )
+	{
+		Simd::Vector first  = Simd::load( aFirst + i );
+		Simd::Vector second = Simd::load( aSecond + i );
+
+		firstSecond  = Simd::multiplyAdd( first, second, firstSecond );
+		firstFirst   = Simd::multiplyAdd( first, first, firstFirst );
+		secondSecond = Simd::multiplyAdd( second, second, secondSecond );
+	}
+
+	aFirstSecond  = Simd::sum( firstSecond );
+	aFirstFirst   = Simd::sum( firstFirst );
+	aSecondSecond = Simd::sum( secondSecond );
+
+	for ( ; i < aSize; ++i )
+	{
+		aFirstSecond  += aFirst[ i ] * aSecond[ i ];
+		aFirstFirst   += aFirst[ i ] * aFirst[ i ];
+		aSecondSecond += aSecond[ i ] * aSecond[ i ];
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void interpolate( const double* aFirst, const double* aSecond, double aFactor, unsigned int aSize, double* aResult )
+{
+	Simd::Vector factor = Simd::broadcast( aFactor );
+
+	unsigned int i = 0;
+
+	for ( ; i + Simd::width <= aSize; i += Simd::width )
+	{
+		Simd::Vector first = Simd::load( aFirst + i );
+
+		Simd::store( aResult + i, Simd::multiplyAdd( factor, Simd::sub( Simd::load( aSecond + i ), first ), first ) );
+	}
+
+	for ( ; i < aSize; ++i )
+	{
+		aResult[ i ] = aFirst[ i ] + aFactor * ( aSecond[ i ] - aFirst[ i ] );
+	}
+}
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,640 @@
+/*!
+* \file
+* Member function definitions for HnswIndex class. This file is part of DataRepresentation module.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#include <DataRepresentation/HnswIndex.h>
+#include <DataRepresentation/DistanceKernels.h>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <omp.h>
+
+namespace lpmldata
+{
+
+namespace
+{
+	const int kMaximumLevel = 16;  // Layer count limit, reached only with a vanishing probability.
+}
+
+//-----------------------------------------------------------------------------
+
+struct HnswIndex::BuildLocks
+{
+	QVector< omp_lock_t > samples;
+	omp_lock_t            entry;
+
+	explicit BuildLocks( int aSampleCount )
+	:
+		samples( aSampleCount )
+	{
+		for ( auto& lock : samples ) omp_init_lock( &lock );
+		omp_init_lock( &entry );
+	}
+
+	~BuildLocks()
+	{
+		for ( auto& lock : samples ) omp_destroy_lock( &lock );
+		omp_destroy_lock( &entry );
+	}
+};
+
+//-----------------------------------------------------------------------------
+
+HnswIndex::HnswIndex()
+:
+	mKeys(),
+	mIndices(),
+	mColumns(),
+	mDimension( 0 ),
+	mConnectionCount( 16 ),
+	mConstructionBreadth( 200 ),
+	mSearchBreadth( 64 ),
+	mPoints(),
+	mLevels(),
+	mBaseLinks(),
+	mUpperLinks(),
+	mUpperOffsets(),
+	mEntryPoint( -1 ),
+	mTopLevel( -1 )
+{
+}
+
+//-----------------------------------------------------------------------------
+
+HnswIndex::HnswIndex( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys, const QVector< double >& aFeatureMask, unsigned int aConnectionCount, unsigned int aConstructionBreadth, unsigned int aSeed )
+:
+	HnswIndex()
+{
+	build( aFeatureDatabase, aKeys, aFeatureMask, aConnectionCount, aConstructionBreadth, aSeed );
+}
+
+//-----------------------------------------------------------------------------
+
+void HnswIndex::build( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys, const QVector< double >& aFeatureMask, unsigned int aConnectionCount, unsigned int aConstructionBreadth, unsigned int aSeed )
+{
+	mConnectionCount     = std::max( aConnectionCount, 2u );
+	mConstructionBreadth = std::max( aConstructionBreadth, mConnectionCount );
+	mKeys.clear();
+	mIndices.clear();
+	mColumns.clear();
+	mLevels.clear();
+	mBaseLinks.clear();
+	mUpperLinks.clear();
+	mUpperOffsets.clear();
+	mEntryPoint = -1;
+	mTopLevel   = -1;
+
+	// The sample order must not depend on the hash order of the table.
+	QStringList keys = aKeys;
+	if ( keys.isEmpty() )
+	{
+		keys = aFeatureDatabase.keys();
+	}
+	keys.sort();
+
+	for ( auto& key : keys )
+	{
+		if ( aFeatureDatabase.table().contains( key ) && !mIndices.contains( key ) )
+		{
+			mIndices.insert( key, mKeys.size() );
+			mKeys.push_back( key );
+		}
+	}
+
+	int columnCount = aFeatureDatabase.columnCount();
+	bool isMasked   = aFeatureMask.size() == columnCount;
+
+	for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+	{
+		if ( !isMasked || aFeatureMask.at( columnIndex ) > 0.0 )
+		{
+			mColumns.push_back( columnIndex );
+		}
+	}
+
+	mDimension = mColumns.size();
+	mPoints    = points( aFeatureDatabase, mKeys );
+
+	int sampleCount = mKeys.size();
+	if ( sampleCount == 0 )
+	{
+		return;
+	}
+
+	// Exponentially decaying layer probabilities, the expected link count stays constant on every layer.
+	std::mt19937 generator( aSeed );
+	std::uniform_real_distribution< double > uniform( 0.0, 1.0 );
+	double levelFactor = 1.0 / std::log( double( mConnectionCount ) );
+	int upperBlockCount = 0;
+
+	mLevels.resize( sampleCount );
+	mUpperOffsets.resize( sampleCount );
+
+	for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		double random = std::max( uniform( generator ), std::numeric_limits< double >::min() );
+		int level     = std::min( int( -std::log( random ) * levelFactor ), kMaximumLevel );
+
+		mLevels[ sampleIndex ]       = level;
+		mUpperOffsets[ sampleIndex ] = upperBlockCount;
+		upperBlockCount             += level;
+	}
+
+	mBaseLinks.fill( 0, sampleCount * ( 2 * mConnectionCount + 1 ) );
+	mUpperLinks.fill( 0, upperBlockCount * ( mConnectionCount + 1 ) );
+
+	mEntryPoint = 0;
+	mTopLevel   = mLevels.at( 0 );
+
+	BuildLocks locks( sampleCount );
+	QVector< VisitedList > visitedLists( omp_get_max_threads() );
+
+	#pragma omp parallel for schedule( dynamic, 16 )
+	for ( int sampleIndex = 1; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		insert( sampleIndex, locks, visitedLists[ omp_get_thread_num() ] );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+double HnswIndex::squaredDistance( const double* aPoint, unsigned int aIndex ) const
+{
+	return DistanceKernels::squaredEuclidean( aPoint, point( aIndex ), mDimension );
+}
+
+//-----------------------------------------------------------------------------
+
+const unsigned int* HnswIndex::links( unsigned int aIndex, int aLevel ) const
+{
+	if ( aLevel == 0 )
+	{
+		return mBaseLinks.constData() + ulint( aIndex ) * ( 2 * mConnectionCount + 1 );
+	}
+
+	return mUpperLinks.constData() + ulint( mUpperOffsets.at( aIndex ) + aLevel - 1 ) * ( mConnectionCount + 1 );
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int* HnswIndex::links( unsigned int aIndex, int aLevel )
+{
+	// The containers are never shared while the graph is built, data() does not copy.
+	if ( aLevel == 0 )
+	{
+		return mBaseLinks.data() + ulint( aIndex ) * ( 2 * mConnectionCount + 1 );
+	}
+
+	return mUpperLinks.data() + ulint( mUpperOffsets.at( aIndex ) + aLevel - 1 ) * ( mConnectionCount + 1 );
+}
+
+//-----------------------------------------------------------------------------
+
+void HnswIndex::copyLinks( unsigned int aIndex, int aLevel, BuildLocks* aLocks, QVector< unsigned int >& aLinks ) const
+{
+	if ( aLocks != nullptr ) omp_set_lock( &aLocks->samples[ aIndex ] );
+
+	const unsigned int* block = links( aIndex, aLevel );
+	aLinks.resize( block[ 0 ] );
+	std::copy( block + 1, block + 1 + block[ 0 ], aLinks.begin() );
+
+	if ( aLocks != nullptr ) omp_unset_lock( &aLocks->samples[ aIndex ] );
+}
+
+//-----------------------------------------------------------------------------
+
+HnswIndex::Neighbour HnswIndex::searchClosest( const double* aPoint, Neighbour aEntry, int aLevel, BuildLocks* aLocks ) const
+{
+	QVector< unsigned int > neighbours;
+	bool isChanged = true;
+
+	while ( isChanged )
+	{
+		isChanged = false;
+		copyLinks( aEntry.second, aLevel, aLocks, neighbours );
+
+		for ( auto neighbour : neighbours )
+		{
+			Neighbour candidate( squaredDistance( aPoint, neighbour ), neighbour );
+
+			if ( candidate < aEntry )
+			{
+				aEntry    = candidate;
+				isChanged = true;
+			}
+		}
+	}
+
+	return aEntry;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< HnswIndex::Neighbour > HnswIndex::searchLayer( const double* aPoint, const QVector< Neighbour >& aEntries, unsigned int aBreadth, int aLevel, BuildLocks* aLocks, VisitedList& aVisited ) const
+{
+	// Min-heap of the samples to expand and max-heap of the best samples so far.
+	QVector< Neighbour > candidates;
+	QVector< Neighbour > results;
+	QVector< unsigned int > neighbours;
+	auto isFurther = []( const Neighbour& aFirst, const Neighbour& aSecond ) { return aSecond < aFirst; };
+
+	aVisited.reset( mKeys.size() );
+
+	for ( auto& entry : aEntries )
+	{
+		if ( !aVisited.visit( entry.second ) ) continue;
+
+		candidates.push_back( entry );
+		std::push_heap( candidates.begin(), candidates.end(), isFurther );
+		results.push_back( entry );
+		std::push_heap( results.begin(), results.end() );
+	}
+
+	while ( unsigned( results.size() ) > aBreadth )
+	{
+		std::pop_heap( results.begin(), results.end() );
+		results.pop_back();
+	}
+
+	while ( !candidates.isEmpty() )
+	{
+		std::pop_heap( candidates.begin(), candidates.end(), isFurther );
+		Neighbour closest = candidates.back();
+		candidates.pop_back();
+
+		// Every remaining candidate is further than the worst result.
+		if ( unsigned( results.size() ) >= aBreadth && closest.first > results.front().first )
+		{
+			break;
+		}
+
+		copyLinks( closest.second, aLevel, aLocks, neighbours );
+
+		for ( auto neighbour : neighbours )
+		{
+			if ( !aVisited.visit( neighbour ) ) continue;
+
+			Neighbour candidate( squaredDistance( aPoint, neighbour ), neighbour );
+
+			if ( unsigned( results.size() ) < aBreadth || candidate < results.front() )
+			{
+				candidates.push_back( candidate );
+				std::push_heap( candidates.begin(), candidates.end(), isFurther );
+				results.push_back( candidate );
+				std::push_heap( results.begin(), results.end() );
+
+				if ( unsigned( results.size() ) > aBreadth )
+				{
+					std::pop_heap( results.begin(), results.end() );
+					results.pop_back();
+				}
+			}
+		}
+	}
+
+	std::sort_heap( results.begin(), results.end() );
+
+	return results;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< unsigned int > HnswIndex::selectNeighbours( const QVector< Neighbour >& aCandidates, unsigned int aCount ) const
+{
+	QVector< unsigned int > selected;
+	QVector< unsigned int > skipped;
+	selected.reserve( aCount );
+
+	for ( auto& candidate : aCandidates )
+	{
+		if ( unsigned( selected.size() ) >= aCount ) break;
+
+		// A candidate closer to a selected sample than to the base is reached through that sample.
+		bool isDiverse = true;
+		for ( auto selectedIndex : selected )
+		{
+			if ( squaredDistance( point( candidate.second ), selectedIndex ) < candidate.first )
+			{
+				isDiverse = false;
+				break;
+			}
+		}
+
+		if ( isDiverse )
+		{
+			selected.push_back( candidate.second );
+		}
+		else
+		{
+			skipped.push_back( candidate.second );
+		}
+	}
+
+	// Free slots are filled with the closest skipped candidates, it keeps clustered samples connected.
+	for ( int skippedIndex = 0; skippedIndex < skipped.size() && unsigned( selected.size() ) < aCount; ++skippedIndex )
+	{
+		selected.push_back( skipped.at( skippedIndex ) );
+	}
+
+	return selected;
+}
+
+//-----------------------------------------------------------------------------
+
+void HnswIndex::insert( unsigned int aIndex, BuildLocks& aLocks, VisitedList& aVisited )
+{
+	const double* samplePoint = point( aIndex );
+	int level                 = mLevels.at( aIndex );
+
+	omp_set_lock( &aLocks.entry );
+	int entryPoint = mEntryPoint;
+	int topLevel   = mTopLevel;
+	omp_unset_lock( &aLocks.entry );
+
+	Neighbour entry( squaredDistance( samplePoint, entryPoint ), entryPoint );
+
+	for ( int currentLevel = topLevel; currentLevel > level; --currentLevel )
+	{
+		entry = searchClosest( samplePoint, entry, currentLevel, &aLocks );
+	}
+
+	QVector< Neighbour > entries;
+	entries.push_back( entry );
+
+	for ( int currentLevel = std::min( level, topLevel ); currentLevel >= 0; --currentLevel )
+	{
+		QVector< Neighbour > candidates = searchLayer( samplePoint, entries, mConstructionBreadth, currentLevel, &aLocks, aVisited );
+		QVector< unsigned int > selected = selectNeighbours( candidates, mConnectionCount );
+
+		unsigned int maximumCount = maximumLinkCount( currentLevel );
+
+		// Concurrent inserts may have linked to this sample on the layer already, their links are kept.
+		omp_set_lock( &aLocks.samples[ aIndex ] );
+		unsigned int* block              = links( aIndex, currentLevel );
+		QVector< unsigned int > ownLinks = selected;
+
+		for ( unsigned int linkIndex = 1; linkIndex <= block[ 0 ]; ++linkIndex )
+		{
+			if ( !ownLinks.contains( block[ linkIndex ] ) ) ownLinks.push_back( block[ linkIndex ] );
+		}
+
+		if ( unsigned( ownLinks.size() ) > maximumCount )
+		{
+			QVector< Neighbour > ownCandidates;
+			for ( auto link : ownLinks )
+			{
+				ownCandidates.push_back( Neighbour( squaredDistance( samplePoint, link ), link ) );
+			}
+
+			std::sort( ownCandidates.begin(), ownCandidates.end() );
+			ownLinks = selectNeighbours( ownCandidates, maximumCount );
+		}
+
+		block[ 0 ] = ownLinks.size();
+		std::copy( ownLinks.constBegin(), ownLinks.constEnd(), block + 1 );
+		omp_unset_lock( &aLocks.samples[ aIndex ] );
+
+		// Backward links, a full neighbour list is reselected with the heuristic.
+
+		for ( auto neighbour : selected )
+		{
+			omp_set_lock( &aLocks.samples[ neighbour ] );
+			unsigned int* neighbourBlock = links( neighbour, currentLevel );
+
+			if ( neighbourBlock[ 0 ] < maximumCount )
+			{
+				neighbourBlock[ 1 + neighbourBlock[ 0 ] ] = aIndex;
+				++neighbourBlock[ 0 ];
+			}
+			else
+			{
+				const double* neighbourPoint = point( neighbour );
+				QVector< Neighbour > neighbourCandidates;
+				neighbourCandidates.reserve( maximumCount + 1 );
+				neighbourCandidates.push_back( Neighbour( squaredDistance( neighbourPoint, aIndex ), aIndex ) );
+
+				for ( unsigned int linkIndex = 1; linkIndex <= neighbourBlock[ 0 ]; ++linkIndex )
+				{
+					neighbourCandidates.push_back( Neighbour( squaredDistance( neighbourPoint, neighbourBlock[ linkIndex ] ), neighbourBlock[ linkIndex ] ) );
+				}
+
+				std::sort( neighbourCandidates.begin(), neighbourCandidates.end() );
+				QVector< unsigned int > kept = selectNeighbours( neighbourCandidates, maximumCount );
+
+				neighbourBlock[ 0 ] = kept.size();
+				std::copy( kept.constBegin(), kept.constEnd(), neighbourBlock + 1 );
+			}
+
+			omp_unset_lock( &aLocks.samples[ neighbour ] );
+		}
+
+		entries = candidates;
+	}
+
+	if ( level > topLevel )
+	{
+		omp_set_lock( &aLocks.entry );
+		if ( level > mTopLevel )
+		{
+			mEntryPoint = aIndex;
+			mTopLevel   = level;
+		}
+		omp_unset_lock( &aLocks.entry );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< HnswIndex::Neighbour > HnswIndex::search( const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex, unsigned int aSearchBreadth, VisitedList& aVisited ) const
+{
+	QVector< Neighbour > neighbours;
+
+	if ( mEntryPoint < 0 || aNeighbourCount == 0 )
+	{
+		return neighbours;
+	}
+
+	// One more candidate is needed if the excluded sample is found.
+	unsigned int wantedCount = aNeighbourCount + ( aExcludedIndex >= 0 ? 1 : 0 );
+	unsigned int breadth     = std::max( aSearchBreadth == 0 ? mSearchBreadth : aSearchBreadth, wantedCount );
+
+	Neighbour entry( squaredDistance( aPoint, mEntryPoint ), mEntryPoint );
+
+	for ( int level = mTopLevel; level > 0; --level )
+	{
+		entry = searchClosest( aPoint, entry, level, nullptr );
+	}
+
+	QVector< Neighbour > entries;
+	entries.push_back( entry );
+
+	QVector< Neighbour > candidates = searchLayer( aPoint, entries, breadth, 0, nullptr, aVisited );
+
+	neighbours.reserve( aNeighbourCount );
+	for ( auto& candidate : candidates )
+	{
+		if ( int( candidate.second ) == aExcludedIndex ) continue;
+		if ( unsigned( neighbours.size() ) >= aNeighbourCount ) break;
+
+		neighbours.push_back( Neighbour( std::sqrt( candidate.first ), candidate.second ) );
+	}
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< HnswIndex::Neighbour > HnswIndex::nearestNeighbours( const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex, unsigned int aSearchBreadth ) const
+{
+	VisitedList visited;
+	return search( aPoint, aNeighbourCount, aExcludedIndex, aSearchBreadth, visited );
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< QVector< HnswIndex::Neighbour > > HnswIndex::nearestNeighbours( const lpmldata::Array2D< double >& aPoints, unsigned int aNeighbourCount, const QVector< int >& aExcludedIndices, unsigned int aSearchBreadth ) const
+{
+	int pointCount = aPoints.rowCount();
+	QVector< QVector< Neighbour > > neighbours( pointCount );
+
+	if ( aPoints.columnCount() != mDimension )
+	{
+		return neighbours;
+	}
+
+	// The graph is read-only during the queries, only the visited lists belong to the threads.
+	QVector< VisitedList > visitedLists( omp_get_max_threads() );
+
+	#pragma omp parallel for schedule( dynamic, 16 )
+	for ( int pointIndex = 0; pointIndex < pointCount; ++pointIndex )
+	{
+		int excludedIndex = pointIndex < aExcludedIndices.size() ? aExcludedIndices.at( pointIndex ) : -1;
+		neighbours[ pointIndex ] = search( aPoints.data() + ulint( pointIndex ) * aPoints.rowStride(), aNeighbourCount, excludedIndex, aSearchBreadth, visitedLists[ omp_get_thread_num() ] );
+	}
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< QVector< HnswIndex::Neighbour > > HnswIndex::allNearestNeighbours( unsigned int aNeighbourCount, unsigned int aSearchBreadth ) const
+{
+	int sampleCount = mKeys.size();
+	QVector< QVector< Neighbour > > neighbours( sampleCount );
+	QVector< VisitedList > visitedLists( omp_get_max_threads() );
+
+	#pragma omp parallel for schedule( dynamic, 16 )
+	for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		neighbours[ sampleIndex ] = search( point( sampleIndex ), aNeighbourCount, sampleIndex, aSearchBreadth, visitedLists[ omp_get_thread_num() ] );
+	}
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+double HnswIndex::recall( const lpmldata::NearestNeighbourIndex& aExactIndex, unsigned int aNeighbourCount, unsigned int aSearchBreadth, unsigned int aProbeCount ) const
+{
+	if ( aExactIndex.keys() != mKeys || aExactIndex.dimension() != mDimension )
+	{
+		return -1.0;
+	}
+
+	int sampleCount = mKeys.size();
+	int probeCount  = std::min( int( aProbeCount ), sampleCount );
+
+	if ( probeCount == 0 || aNeighbourCount == 0 )
+	{
+		return 1.0;
+	}
+
+	QVector< double > probeRecalls( probeCount, 1.0 );
+
+	#pragma omp parallel for schedule( dynamic )
+	for ( int probeIndex = 0; probeIndex < probeCount; ++probeIndex )
+	{
+		unsigned int sampleIndex = unsigned( ulint( probeIndex ) * sampleCount / probeCount );
+		auto exact               = aExactIndex.nearestNeighbours( sampleIndex, aNeighbourCount );
+		auto approximate         = nearestNeighbours( sampleIndex, aNeighbourCount, aSearchBreadth );
+
+		if ( exact.isEmpty() ) continue;
+
+		double threshold = exact.last().first * ( 1.0 + 1e-12 );
+		int foundCount   = 0;
+
+		for ( auto& neighbour : approximate )
+		{
+			if ( neighbour.first <= threshold ) ++foundCount;
+		}
+
+		probeRecalls[ probeIndex ] = double( std::min( foundCount, exact.size() ) ) / exact.size();
+	}
+
+	double sum = 0.0;
+	for ( auto probeRecall : probeRecalls )
+	{
+		sum += probeRecall;
+	}
+
+	return sum / probeCount;
+}
+
+//-----------------------------------------------------------------------------
+
+unsigned int HnswIndex::searchBreadthForRecall( const lpmldata::NearestNeighbourIndex& aExactIndex, unsigned int aNeighbourCount, double aTargetRecall, unsigned int aInitialBreadth, unsigned int aProbeCount ) const
+{
+	unsigned int sampleCount = mKeys.size();
+	unsigned int breadth     = std::max( aInitialBreadth == 0 ? mSearchBreadth : aInitialBreadth, std::max( aNeighbourCount, 1u ) );
+
+	while ( breadth < sampleCount )
+	{
+		double currentRecall = recall( aExactIndex, aNeighbourCount, breadth, aProbeCount );
+
+		if ( currentRecall < 0.0 || currentRecall >= aTargetRecall )
+		{
+			return breadth;
+		}
+
+		breadth *= 2;
+	}
+
+	return std::max( sampleCount, 1u );
+}
+
+//-----------------------------------------------------------------------------
+
+lpmldata::Array2D< double > HnswIndex::points( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys ) const
+{
+	Array2D< double > rows( aKeys.size(), mDimension, Array2DLayout::RowMajor );
+
+	for ( int keyIndex = 0; keyIndex < aKeys.size(); ++keyIndex )
+	{
+		auto iterator = aFeatureDatabase.table().constFind( aKeys.at( keyIndex ) );
+
+		if ( iterator == aFeatureDatabase.table().constEnd() ) continue;
+
+		const QVariantList& values = iterator.value();
+		double* row                = rows.data() + ulint( keyIndex ) * mDimension;
+
+		for ( unsigned int dimension = 0; dimension < mDimension; ++dimension )
+		{
+			int column = mColumns.at( dimension );
+			row[ dimension ] = column < values.size() ? values.at( column ).toDouble() : 0.0;
+		}
+	}
+
+	return rows;
+}
+
+//-----------------------------------------------------------------------------
+
+}
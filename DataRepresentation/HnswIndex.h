@@ -0,0 +1,231 @@
+/*!
+* \file
+* HnswIndex class definition. This file is part of DataRepresentation module.
+* The HnswIndex is a hierarchical navigable small world graph over the dense feature rows of a set of samples. It answers approximate k nearest neighbour
+* queries with Euclidean distance, its cost grows with the logarithm of the sample count and does not degrade with the dimension like the k-d tree.
+* The search breadth (efSearch) trades recall for speed, recall() measures it against the exact NearestNeighbourIndex.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <DataRepresentation/Export.h>
+#include <DataRepresentation/Types.h>
+#include <DataRepresentation/TabularData.h>
+#include <DataRepresentation/Array2D.h>
+#include <DataRepresentation/NearestNeighbourIndex.h>
+#include <QVector>
+#include <QStringList>
+#include <QHash>
+#include <QPair>
+
+namespace lpmldata
+{
+
+//-----------------------------------------------------------------------------
+
+class DataRepresentation_API HnswIndex
+{
+
+public:
+
+	typedef QPair< double, unsigned int > Neighbour;  //!< Euclidean distance and sample index.
+
+	/*!
+	* \brief Constructor of an empty index.
+	*/
+	HnswIndex();
+
+	/*!
+	* \brief Builds the graph over samples of a feature table.
+	* \param [in] aFeatureDatabase The feature table, each key is a sample.
+	* \param [in] aKeys The samples to index, all samples of the table if empty. Keys missing from the table are skipped.
+	* \param [in] aFeatureMask Optional mask, only features with a positive mask value are used. Ignored if its size does not match the column count.
+	* \param [in] aConnectionCount Links of a sample on the upper layers (M), the bottom layer keeps twice as many.
+	* \param [in] aConstructionBreadth Candidate list size while linking a new sample (efConstruction).
+	* \param [in] aSeed Seed of the layer assignment.
+	*/
+	HnswIndex( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys = QStringList(), const QVector< double >& aFeatureMask = QVector< double >(),
+		unsigned int aConnectionCount = 16, unsigned int aConstructionBreadth = 200, unsigned int aSeed = 1 );
+
+	/*!
+	* \brief Destructor.
+	*/
+	~HnswIndex() {}
+
+	/*!
+	* \brief Rebuilds the graph, see the constructor. The samples are inserted in parallel, the links may differ between runs.
+	*/
+	void build( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys = QStringList(), const QVector< double >& aFeatureMask = QVector< double >(),
+		unsigned int aConnectionCount = 16, unsigned int aConstructionBreadth = 200, unsigned int aSeed = 1 );
+
+	/*!
+	* \brief The approximate k nearest samples of a point ordered by distance.
+	* \param [in] aPoint dimension() values, e.g. a row of points().
+	* \param [in] aNeighbourCount The number of neighbours.
+	* \param [in] aExcludedIndex A sample that is not returned, typically the query sample itself. -1 excludes nothing.
+	* \param [in] aSearchBreadth Candidate list size of the search (efSearch), searchBreadth() if 0. At least aNeighbourCount is used.
+	*/
+	QVector< Neighbour > nearestNeighbours( const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex = -1, unsigned int aSearchBreadth = 0 ) const;
+
+	/*!
+	* \brief The approximate k nearest samples of an indexed sample, the sample itself is excluded.
+	*/
+	QVector< Neighbour > nearestNeighbours( unsigned int aIndex, unsigned int aNeighbourCount, unsigned int aSearchBreadth = 0 ) const { return nearestNeighbours( point( aIndex ), aNeighbourCount, aIndex, aSearchBreadth ); }
+
+	/*!
+	* \brief Parallel batch of approximate k nearest neighbour queries.
+	* \param [in] aPoints Row-major block of query points with dimension() columns.
+	* \param [in] aNeighbourCount The number of neighbours of each point.
+	* \param [in] aExcludedIndices Optional excluded sample of each query point, -1 excludes nothing.
+	* \param [in] aSearchBreadth Candidate list size of the search, searchBreadth() if 0.
+	*/
+	QVector< QVector< Neighbour > > nearestNeighbours( const lpmldata::Array2D< double >& aPoints, unsigned int aNeighbourCount, const QVector< int >& aExcludedIndices = QVector< int >(), unsigned int aSearchBreadth = 0 ) const;
+
+	/*!
+	* \brief Parallel approximate k nearest neighbour query of every indexed sample, each sample excludes itself.
+	*/
+	QVector< QVector< Neighbour > > allNearestNeighbours( unsigned int aNeighbourCount, unsigned int aSearchBreadth = 0 ) const;
+
+	/*!
+	* \brief Mean fraction of the exact k nearest neighbours found by the graph, measured on evenly spaced indexed samples.
+	* \details A neighbour at the distance of the exact k-th neighbour counts as found, ties may be resolved differently.
+	* \param [in] aExactIndex Exact index over the same samples and features.
+	* \param [in] aNeighbourCount The number of neighbours.
+	* \param [in] aSearchBreadth Candidate list size of the search, searchBreadth() if 0.
+	* \param [in] aProbeCount The number of query samples, all samples if it exceeds the sample count.
+	* \return The recall in [0, 1], -1 if the exact index holds different samples.
+	*/
+	double recall( const lpmldata::NearestNeighbourIndex& aExactIndex, unsigned int aNeighbourCount, unsigned int aSearchBreadth = 0, unsigned int aProbeCount = 200 ) const;
+
+	/*!
+	* \brief The smallest search breadth out of b, 2 * b, 4 * b ... that reaches a recall target on the probe samples, b is aInitialBreadth or searchBreadth() if 0.
+	* \details The sample count is returned if the target is not reached before, there the search visits the whole bottom layer.
+	*/
+	unsigned int searchBreadthForRecall( const lpmldata::NearestNeighbourIndex& aExactIndex, unsigned int aNeighbourCount, double aTargetRecall, unsigned int aInitialBreadth = 0, unsigned int aProbeCount = 200 ) const;
+
+	/*!
+	* \brief Gathers the rows of the given samples of a feature table with the column selection of the index, unknown keys give zero rows.
+	*/
+	lpmldata::Array2D< double > points( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys ) const;
+
+	/*!
+	* \brief The indexed row of a sample.
+	*/
+	const double* point( unsigned int aIndex ) const { return mPoints.data() + ulint( aIndex ) * mDimension; }
+
+	/*!
+	* \brief Index of a sample key, -1 if the key is not indexed.
+	*/
+	int indexOf( const QString& aKey ) const { return mIndices.value( aKey, -1 ); }
+
+	const QStringList& keys() const { return mKeys; }
+
+	const QString& key( unsigned int aIndex ) const { return mKeys.at( aIndex ); }
+
+	unsigned int sampleCount() const { return mKeys.size(); }
+
+	unsigned int dimension() const { return mDimension; }
+
+	bool isEmpty() const { return mKeys.isEmpty(); }
+
+	unsigned int connectionCount() const { return mConnectionCount; }
+
+	unsigned int constructionBreadth() const { return mConstructionBreadth; }
+
+	/*!
+	* \brief Default candidate list size of the queries (efSearch).
+	*/
+	unsigned int searchBreadth() const { return mSearchBreadth; }
+
+	void setSearchBreadth( unsigned int aSearchBreadth ) { mSearchBreadth = std::max( aSearchBreadth, 1u ); }
+
+private:
+
+	/*!
+	* \brief Marks the visited samples of one search, reset in constant time by advancing the tag.
+	*/
+	struct VisitedList
+	{
+		QVector< unsigned int > marks;
+		unsigned int            tag = 0;
+
+		void reset( int aSampleCount )
+		{
+			if ( marks.size() != aSampleCount || ++tag == 0 )
+			{
+				marks.fill( 0, aSampleCount );
+				tag = 1;
+			}
+		}
+
+		bool visit( unsigned int aIndex )
+		{
+			if ( marks[ aIndex ] == tag ) return false;
+			marks[ aIndex ] = tag;
+			return true;
+		}
+	};
+
+	struct BuildLocks;  //!< Per sample locks of the parallel build, no locks are taken by the queries.
+
+	double squaredDistance( const double* aPoint, unsigned int aIndex ) const;
+
+	/*!
+	* \brief Link block of a sample on a layer, the first element is the link count.
+	*/
+	const unsigned int* links( unsigned int aIndex, int aLevel ) const;
+	unsigned int* links( unsigned int aIndex, int aLevel );
+
+	unsigned int maximumLinkCount( int aLevel ) const { return aLevel == 0 ? 2 * mConnectionCount : mConnectionCount; }
+
+	/*!
+	* \brief Copies the links of a sample, under its lock while the graph is built.
+	*/
+	void copyLinks( unsigned int aIndex, int aLevel, BuildLocks* aLocks, QVector< unsigned int >& aLinks ) const;
+
+	/*!
+	* \brief Greedy descent to the closest sample on a layer.
+	*/
+	Neighbour searchClosest( const double* aPoint, Neighbour aEntry, int aLevel, BuildLocks* aLocks ) const;
+
+	/*!
+	* \brief Best first search of a layer, returns up to aBreadth samples ordered by squared distance.
+	*/
+	QVector< Neighbour > searchLayer( const double* aPoint, const QVector< Neighbour >& aEntries, unsigned int aBreadth, int aLevel, BuildLocks* aLocks, VisitedList& aVisited ) const;
+
+	/*!
+	* \brief Neighbour selection heuristic, prefers candidates that are closer to the base than to the already selected ones.
+	* \param [in] aCandidates Candidates ordered by squared distance to the base.
+	*/
+	QVector< unsigned int > selectNeighbours( const QVector< Neighbour >& aCandidates, unsigned int aCount ) const;
+
+	void insert( unsigned int aIndex, BuildLocks& aLocks, VisitedList& aVisited );
+
+	QVector< Neighbour > search( const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex, unsigned int aSearchBreadth, VisitedList& aVisited ) const;
+
+private:
+
+	QStringList                   mKeys;                 //!< Sorted sample keys, the position is the sample index.
+	QHash< QString, int >         mIndices;              //!< Sample key to index.
+	QVector< int >                mColumns;              //!< Used feature columns.
+	unsigned int                  mDimension;
+	unsigned int                  mConnectionCount;
+	unsigned int                  mConstructionBreadth;
+	unsigned int                  mSearchBreadth;
+	lpmldata::Array2D< double >   mPoints;               //!< Row-major rows in sample index order.
+	QVector< int >                mLevels;               //!< Top layer of each sample.
+	QVector< unsigned int >       mBaseLinks;            //!< Bottom layer link blocks of 2 * M + 1 elements per sample.
+	QVector< unsigned int >       mUpperLinks;           //!< Upper layer link blocks of M + 1 elements, mLevels[ i ] blocks per sample.
+	QVector< int >                mUpperOffsets;         //!< First upper block of each sample.
+	int                           mEntryPoint;           //!< Sample on the top layer, -1 if empty.
+	int                           mTopLevel;
+};
+
+//-----------------------------------------------------------------------------
+
+}
@@ -0,0 +1,361 @@
+/*!
+* \file
+* Member function definitions for NearestNeighbourIndex class. This file is part of DataRepresentation module.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#include <DataRepresentation/NearestNeighbourIndex.h>
+#include <DataRepresentation/DistanceKernels.h>
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+namespace lpmldata
+{
+
+//-----------------------------------------------------------------------------
+
+NearestNeighbourIndex::NearestNeighbourIndex()
+:
+	mKeys(),
+	mIndices(),
+	mColumns(),
+	mDimension( 0 ),
+	mLeafSize( 16 ),
+	mPoints(),
+	mSampleIndices(),
+	mPositions(),
+	mNodes()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+NearestNeighbourIndex::NearestNeighbourIndex( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys, const QVector< double >& aFeatureMask, unsigned int aLeafSize )
+:
+	NearestNeighbourIndex()
+{
+	build( aFeatureDatabase, aKeys, aFeatureMask, aLeafSize );
+}
+
+//-----------------------------------------------------------------------------
+
+void NearestNeighbourIndex::build( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys, const QVector< double >& aFeatureMask, unsigned int aLeafSize )
+{
+	mLeafSize = std::max( aLeafSize, 1u );
+	mKeys.clear();
+	mIndices.clear();
+	mColumns.clear();
+	mNodes.clear();
+
+	// The sample order must not depend on the hash order of the table.
+	QStringList keys = aKeys;
+	if ( keys.isEmpty() )
+	{
+		keys = aFeatureDatabase.keys();
+	}
+	keys.sort();
+
+	for ( auto& key : keys )
+	{
+		if ( aFeatureDatabase.table().contains( key ) && !mIndices.contains( key ) )
+		{
+			mIndices.insert( key, mKeys.size() );
+			mKeys.push_back( key );
+		}
+	}
+
+	int columnCount = aFeatureDatabase.columnCount();
+	bool isMasked   = aFeatureMask.size() == columnCount;
+
+	for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+	{
+		if ( !isMasked || aFeatureMask.at( columnIndex ) > 0.0 )
+		{
+			mColumns.push_back( columnIndex );
+		}
+	}
+
+	mDimension = mColumns.size();
+
+	Array2D< double > rows = points( aFeatureDatabase, mKeys );
+	unsigned int sampleCount = mKeys.size();
+
+	QVector< unsigned int > order( sampleCount );
+	for ( unsigned int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		order[ sampleIndex ] = sampleIndex;
+	}
+
+	if ( sampleCount > 0 )
+	{
+		buildNode( 0, sampleCount, order, rows );
+	}
+
+	// Store the rows in tree order, a leaf scan reads one contiguous block.
+	mPoints        = Array2D< double >( sampleCount, mDimension, Array2DLayout::RowMajor );
+	mSampleIndices = order;
+	mPositions.resize( sampleCount );
+
+	for ( unsigned int position = 0; position < sampleCount; ++position )
+	{
+		std::copy( rows.data() + ulint( order.at( position ) ) * mDimension, rows.data() + ulint( order.at( position ) + 1 ) * mDimension, mPoints.data() + ulint( position ) * mDimension );
+		mPositions[ order.at( position ) ] = position;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int NearestNeighbourIndex::buildNode( unsigned int aBegin, unsigned int aEnd, QVector< unsigned int >& aOrder, const lpmldata::Array2D< double >& aRows )
+{
+	int nodeIndex = mNodes.size();
+	mNodes.push_back( { aBegin, aEnd, -1, 0.0, -1, -1 } );
+
+	if ( aEnd - aBegin <= mLeafSize || mDimension == 0 )
+	{
+		return nodeIndex;
+	}
+
+	// Split the dimension with the largest spread at the median.
+	int splitDimension = 0;
+	double largestSpread = -1.0;
+
+	for ( unsigned int dimension = 0; dimension < mDimension; ++dimension )
+	{
+		double minimum = aRows( aOrder.at( aBegin ), dimension );
+		double maximum = minimum;
+
+		for ( unsigned int position = aBegin + 1; position < aEnd; ++position )
+		{
+			double value = aRows( aOrder.at( position ), dimension );
+			minimum = std::min( minimum, value );
+			maximum = std::max( maximum, value );
+		}
+
+		if ( maximum - minimum > largestSpread )
+		{
+			largestSpread  = maximum - minimum;
+			splitDimension = dimension;
+		}
+	}
+
+	if ( largestSpread <= 0.0 )
+	{
+		return nodeIndex;  // All samples are identical.
+	}
+
+	unsigned int middle = aBegin + ( aEnd - aBegin ) / 2;
+
+	std::nth_element( aOrder.begin() + aBegin, aOrder.begin() + middle, aOrder.begin() + aEnd,
+		[ &aRows, splitDimension ]( unsigned int aFirst, unsigned int aSecond ) { return aRows( aFirst, splitDimension ) < aRows( aSecond, splitDimension ); } );
+
+	double splitValue = aRows( aOrder.at( middle ), splitDimension );
+	int left          = buildNode( aBegin, middle, aOrder, aRows );
+	int right         = buildNode( middle, aEnd, aOrder, aRows );
+
+	// The vector may have been reallocated by the children.
+	mNodes[ nodeIndex ].splitDimension = splitDimension;
+	mNodes[ nodeIndex ].splitValue     = splitValue;
+	mNodes[ nodeIndex ].left           = left;
+	mNodes[ nodeIndex ].right          = right;
+
+	return nodeIndex;
+}
+
+//-----------------------------------------------------------------------------
+
+void NearestNeighbourIndex::searchNearest( int aNode, const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex, QVector< Neighbour >& aHeap ) const
+{
+	const Node& node = mNodes.at( aNode );
+
+	if ( node.splitDimension < 0 )
+	{
+		// Max-heap of the best candidates so far, the front is the worst of them.
+		for ( unsigned int position = node.begin; position < node.end; ++position )
+		{
+			unsigned int sampleIndex = mSampleIndices.at( position );
+
+			if ( int( sampleIndex ) == aExcludedIndex ) continue;
+
+			Neighbour candidate( DistanceKernels::squaredEuclidean( aPoint, mPoints.data() + ulint( position ) * mDimension, mDimension ), sampleIndex );
+
+			if ( unsigned( aHeap.size() ) < aNeighbourCount )
+			{
+				aHeap.push_back( candidate );
+				std::push_heap( aHeap.begin(), aHeap.end() );
+			}
+			else if ( candidate < aHeap.front() )
+			{
+				std::pop_heap( aHeap.begin(), aHeap.end() );
+				aHeap.back() = candidate;
+				std::push_heap( aHeap.begin(), aHeap.end() );
+			}
+		}
+
+		return;
+	}
+
+	double difference = aPoint[ node.splitDimension ] - node.splitValue;
+	int nearChild     = difference < 0.0 ? node.left : node.right;
+	int farChild      = difference < 0.0 ? node.right : node.left;
+
+	searchNearest( nearChild, aPoint, aNeighbourCount, aExcludedIndex, aHeap );
+
+	// Equal distances are visited as well, ties are resolved by index.
+	if ( unsigned( aHeap.size() ) < aNeighbourCount || difference * difference <= aHeap.front().first )
+	{
+		searchNearest( farChild, aPoint, aNeighbourCount, aExcludedIndex, aHeap );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void NearestNeighbourIndex::searchRadius( int aNode, const double* aPoint, double aSquaredRadius, int aExcludedIndex, QVector< Neighbour >& aNeighbours ) const
+{
+	const Node& node = mNodes.at( aNode );
+
+	if ( node.splitDimension < 0 )
+	{
+		for ( unsigned int position = node.begin; position < node.end; ++position )
+		{
+			unsigned int sampleIndex = mSampleIndices.at( position );
+
+			if ( int( sampleIndex ) == aExcludedIndex ) continue;
+
+			double squaredDistance = DistanceKernels::squaredEuclidean( aPoint, mPoints.data() + ulint( position ) * mDimension, mDimension );
+
+			if ( squaredDistance <= aSquaredRadius )
+			{
+				aNeighbours.push_back( Neighbour( squaredDistance, sampleIndex ) );
+			}
+		}
+
+		return;
+	}
+
+	double difference = aPoint[ node.splitDimension ] - node.splitValue;
+
+	searchRadius( difference < 0.0 ? node.left : node.right, aPoint, aSquaredRadius, aExcludedIndex, aNeighbours );
+
+	if ( difference * difference <= aSquaredRadius )
+	{
+		searchRadius( difference < 0.0 ? node.right : node.left, aPoint, aSquaredRadius, aExcludedIndex, aNeighbours );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< NearestNeighbourIndex::Neighbour > NearestNeighbourIndex::nearestNeighbours( const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex ) const
+{
+	QVector< Neighbour > neighbours;
+
+	if ( mNodes.isEmpty() || aNeighbourCount == 0 )
+	{
+		return neighbours;
+	}
+
+	neighbours.reserve( aNeighbourCount );
+	searchNearest( 0, aPoint, aNeighbourCount, aExcludedIndex, neighbours );
+	std::sort_heap( neighbours.begin(), neighbours.end() );
+
+	for ( auto& neighbour : neighbours )
+	{
+		neighbour.first = std::sqrt( neighbour.first );
+	}
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< QVector< NearestNeighbourIndex::Neighbour > > NearestNeighbourIndex::nearestNeighbours( const lpmldata::Array2D< double >& aPoints, unsigned int aNeighbourCount, const QVector< int >& aExcludedIndices ) const
+{
+	int pointCount = aPoints.rowCount();
+	QVector< QVector< Neighbour > > neighbours( pointCount );
+
+	if ( aPoints.columnCount() != mDimension )
+	{
+		return neighbours;
+	}
+
+	// The tree is read-only during the queries.
+	#pragma omp parallel for schedule( dynamic, 16 )
+	for ( int pointIndex = 0; pointIndex < pointCount; ++pointIndex )
+	{
+		int excludedIndex = pointIndex < aExcludedIndices.size() ? aExcludedIndices.at( pointIndex ) : -1;
+		neighbours[ pointIndex ] = nearestNeighbours( aPoints.data() + ulint( pointIndex ) * aPoints.rowStride(), aNeighbourCount, excludedIndex );
+	}
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< QVector< NearestNeighbourIndex::Neighbour > > NearestNeighbourIndex::allNearestNeighbours( unsigned int aNeighbourCount ) const
+{
+	int sampleCount = mKeys.size();
+	QVector< QVector< Neighbour > > neighbours( sampleCount );
+
+	#pragma omp parallel for schedule( dynamic, 16 )
+	for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		neighbours[ sampleIndex ] = nearestNeighbours( sampleIndex, aNeighbourCount );
+	}
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< NearestNeighbourIndex::Neighbour > NearestNeighbourIndex::radiusNeighbours( const double* aPoint, double aRadius, int aExcludedIndex ) const
+{
+	QVector< Neighbour > neighbours;
+
+	if ( mNodes.isEmpty() || aRadius < 0.0 )
+	{
+		return neighbours;
+	}
+
+	searchRadius( 0, aPoint, aRadius * aRadius, aExcludedIndex, neighbours );
+	std::sort( neighbours.begin(), neighbours.end() );
+
+	for ( auto& neighbour : neighbours )
+	{
+		neighbour.first = std::sqrt( neighbour.first );
+	}
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+lpmldata::Array2D< double > NearestNeighbourIndex::points( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys ) const
+{
+	Array2D< double > rows( aKeys.size(), mDimension, Array2DLayout::RowMajor );
+
+	for ( int keyIndex = 0; keyIndex < aKeys.size(); ++keyIndex )
+	{
+		auto iterator = aFeatureDatabase.table().constFind( aKeys.at( keyIndex ) );
+
+		if ( iterator == aFeatureDatabase.table().constEnd() ) continue;
+
+		const QVariantList& values = iterator.value();
+		double* row                = rows.data() + ulint( keyIndex ) * mDimension;
+
+		for ( unsigned int dimension = 0; dimension < mDimension; ++dimension )
+		{
+			int column = mColumns.at( dimension );
+			row[ dimension ] = column < values.size() ? values.at( column ).toDouble() : 0.0;
+		}
+	}
+
+	return rows;
+}
+
+//-----------------------------------------------------------------------------
+
+}
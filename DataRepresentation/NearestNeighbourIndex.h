@@ -0,0 +1,149 @@
+/*!
+* \file
+* NearestNeighbourIndex class definition. This file is part of DataRepresentation module.
+* The NearestNeighbourIndex is a k-d tree over the dense feature rows of a set of samples. It answers k nearest neighbour and radius queries with Euclidean distance,
+* single queries use a bounded heap, batches of queries are distributed between threads.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <DataRepresentation/Export.h>
+#include <DataRepresentation/Types.h>
+#include <DataRepresentation/TabularData.h>
+#include <DataRepresentation/Array2D.h>
+#include <QVector>
+#include <QStringList>
+#include <QHash>
+#include <QPair>
+
+namespace lpmldata
+{
+
+//-----------------------------------------------------------------------------
+
+class DataRepresentation_API NearestNeighbourIndex
+{
+
+public:
+
+	typedef QPair< double, unsigned int > Neighbour;  //!< Euclidean distance and sample index.
+
+	/*!
+	* \brief Constructor of an empty index.
+	*/
+	NearestNeighbourIndex();
+
+	/*!
+	* \brief Builds the index over samples of a feature table.
+	* \param [in] aFeatureDatabase The feature table, each key is a sample.
+	* \param [in] aKeys The samples to index, all samples of the table if empty. Keys missing from the table are skipped.
+	* \param [in] aFeatureMask Optional mask, only features with a positive mask value are used. Ignored if its size does not match the column count.
+	* \param [in] aLeafSize Maximum number of samples in a leaf, leaves are scanned linearly.
+	*/
+	NearestNeighbourIndex( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys = QStringList(), const QVector< double >& aFeatureMask = QVector< double >(), unsigned int aLeafSize = 16 );
+
+	/*!
+	* \brief Destructor.
+	*/
+	~NearestNeighbourIndex() {}
+
+	/*!
+	* \brief Rebuilds the index, see the constructor.
+	*/
+	void build( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys = QStringList(), const QVector< double >& aFeatureMask = QVector< double >(), unsigned int aLeafSize = 16 );
+
+	/*!
+	* \brief The k nearest samples of a point ordered by distance, ties are resolved by index.
+	* \param [in] aPoint dimension() values, e.g. a row of points().
+	* \param [in] aNeighbourCount The number of neighbours.
+	* \param [in] aExcludedIndex A sample that is not returned, typically the query sample itself. -1 excludes nothing.
+	*/
+	QVector< Neighbour > nearestNeighbours( const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex = -1 ) const;
+
+	/*!
+	* \brief The k nearest samples of an indexed sample, the sample itself is excluded.
+	*/
+	QVector< Neighbour > nearestNeighbours( unsigned int aIndex, unsigned int aNeighbourCount ) const { return nearestNeighbours( point( aIndex ), aNeighbourCount, aIndex ); }
+
+	/*!
+	* \brief Parallel batch of k nearest neighbour queries.
+	* \param [in] aPoints Row-major block of query points with dimension() columns.
+	* \param [in] aNeighbourCount The number of neighbours of each point.
+	* \param [in] aExcludedIndices Optional excluded sample of each query point, -1 excludes nothing.
+	*/
+	QVector< QVector< Neighbour > > nearestNeighbours( const lpmldata::Array2D< double >& aPoints, unsigned int aNeighbourCount, const QVector< int >& aExcludedIndices = QVector< int >() ) const;
+
+	/*!
+	* \brief Parallel k nearest neighbour query of every indexed sample, each sample excludes itself.
+	*/
+	QVector< QVector< Neighbour > > allNearestNeighbours( unsigned int aNeighbourCount ) const;
+
+	/*!
+	* \brief All samples within aRadius (inclusive) of a point ordered by distance.
+	*/
+	QVector< Neighbour > radiusNeighbours( const double* aPoint, double aRadius, int aExcludedIndex = -1 ) const;
+
+	/*!
+	* \brief Gathers the rows of the given samples of a feature table with the column selection of the index, unknown keys give zero rows.
+	*/
+	lpmldata::Array2D< double > points( const lpmldata::TabularData& aFeatureDatabase, const QStringList& aKeys ) const;
+
+	/*!
+	* \brief The indexed row of a sample.
+	*/
+	const double* point( unsigned int aIndex ) const { return mPoints.data() + ulint( mPositions.at( aIndex ) ) * mDimension; }
+
+	/*!
+	* \brief Index of a sample key, -1 if the key is not indexed.
+	*/
+	int indexOf( const QString& aKey ) const { return mIndices.value( aKey, -1 ); }
+
+	const QStringList& keys() const { return mKeys; }
+
+	const QString& key( unsigned int aIndex ) const { return mKeys.at( aIndex ); }
+
+	unsigned int sampleCount() const { return mKeys.size(); }
+
+	unsigned int dimension() const { return mDimension; }
+
+	bool isEmpty() const { return mKeys.isEmpty(); }
+
+private:
+
+	struct Node
+	{
+		unsigned int  begin;           //!< First tree position of the node.
+		unsigned int  end;             //!< One past the last tree position.
+		int           splitDimension;  //!< -1 for leaves.
+		double        splitValue;
+		int           left;
+		int           right;
+	};
+
+	int buildNode( unsigned int aBegin, unsigned int aEnd, QVector< unsigned int >& aOrder, const lpmldata::Array2D< double >& aRows );
+
+	void searchNearest( int aNode, const double* aPoint, unsigned int aNeighbourCount, int aExcludedIndex, QVector< Neighbour >& aHeap ) const;
+
+	void searchRadius( int aNode, const double* aPoint, double aSquaredRadius, int aExcludedIndex, QVector< Neighbour >& aNeighbours ) const;
+
+private:
+
+	QStringList                   mKeys;          //!< Sorted sample keys, the position is the sample index.
+	QHash< QString, int >         mIndices;       //!< Sample key to index.
+	QVector< int >                mColumns;       //!< Used feature columns.
+	unsigned int                  mDimension;
+	unsigned int                  mLeafSize;
+	lpmldata::Array2D< double >   mPoints;        //!< Row-major rows in tree order, leaves are contiguous.
+	QVector< unsigned int >       mSampleIndices; //!< Tree position to sample index.
+	QVector< unsigned int >       mPositions;     //!< Sample index to tree position.
+	QVector< Node >               mNodes;         //!< Flat tree, the root is the first node.
+};
+
+//-----------------------------------------------------------------------------
+
+}
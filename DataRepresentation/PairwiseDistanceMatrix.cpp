@@ -0,0 +1,259 @@
+/*!
+* \file
+* Member function definitions for PairwiseDistanceMatrix class. This file is part of DataRepresentation module.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#include <DataRepresentation/PairwiseDistanceMatrix.h>
+#include <DataRepresentation/Array2D.h>
+#include <QDebug>
+#include <limits>
+#include <omp.h>
+
+namespace lpmldata
+{
+
+namespace
+{
+	const unsigned int kBlockSize = 64;  // Rows of a block, the two row blocks of a tile stay in cache.
+	const ulint kMaximumStorageSize = ulint( std::numeric_limits< int >::max() ) - 64;  // Bytes of a Qt 5 container, its header included.
+}
+
+//-----------------------------------------------------------------------------
+
+PairwiseDistanceMatrix::PairwiseDistanceMatrix()
+:
+	mSampleCount( 0 ),
+	mPrecision( DistancePrecision::Double ),
+	mMetric( DistanceMetric::Euclidean ),
+	mKeys(),
+	mIndices(),
+	mDoubleDistances(),
+	mSingleDistances(),
+	mIsOnDemand( false ),
+	mRows()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+PairwiseDistanceMatrix::PairwiseDistanceMatrix( const lpmldata::TabularData& aFeatureDatabase, DistancePrecision aPrecision, const QVector< double >& aFeatureMask, DistanceMetric aMetric )
+:
+	PairwiseDistanceMatrix()
+{
+	compute( aFeatureDatabase, aPrecision, aFeatureMask, aMetric );
+}
+
+//-----------------------------------------------------------------------------
+
+void PairwiseDistanceMatrix::compute( const lpmldata::TabularData& aFeatureDatabase, DistancePrecision aPrecision, const QVector< double >& aFeatureMask, DistanceMetric aMetric )
+{
+	mPrecision = aPrecision;
+	mMetric    = aMetric;
+	mKeys      = aFeatureDatabase.keys();
+	mKeys.sort();
+	mIndices.clear();
+	mDoubleDistances.clear();
+	mSingleDistances.clear();
+	mRows = Array2D< double >();
+
+	mSampleCount = mKeys.size();
+
+	ulint pairCount = ulint( mSampleCount ) * ( mSampleCount > 0 ? mSampleCount - 1 : 0 ) / 2;
+	ulint pairSize  = mPrecision == DistancePrecision::Single ? sizeof( float ) : sizeof( double );
+	mIsOnDemand     = pairCount * pairSize > kMaximumStorageSize;
+
+	if ( mIsOnDemand )
+	{
+		qDebug() << "PairwiseDistanceMatrix - Warning: The condensed matrix of" << mSampleCount << "samples is too large to be stored, the distances are computed on demand";
+	}
+
+	for ( unsigned int sampleIndex = 0; sampleIndex < mSampleCount; ++sampleIndex )
+	{
+		mIndices.insert( mKeys.at( sampleIndex ), sampleIndex );
+	}
+
+	// Gather the used features once into dense rows.
+	int columnCount = aFeatureDatabase.columnCount();
+	bool isMasked   = aFeatureMask.size() == columnCount;
+
+	QVector< int > columns;
+	for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+	{
+		if ( !isMasked || aFeatureMask.at( columnIndex ) > 0.0 )
+		{
+			columns.push_back( columnIndex );
+		}
+	}
+
+	unsigned int featureCount = columns.size();
+	Array2D< double > rows( mSampleCount, featureCount, Array2DLayout::RowMajor );
+
+	for ( unsigned int sampleIndex = 0; sampleIndex < mSampleCount; ++sampleIndex )
+	{
+		const QVariantList& values = aFeatureDatabase.value( mKeys.at( sampleIndex ) );
+		double* row                = rows.data() + ulint( sampleIndex ) * featureCount;
+
+		for ( unsigned int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+		{
+			int column = columns.at( featureIndex );
+			row[ featureIndex ] = column < values.size() ? values.at( column ).toDouble() : 0.0;
+		}
+	}
+
+	if ( mIsOnDemand )
+	{
+		mRows = std::move( rows );
+		return;
+	}
+
+	if ( mPrecision == DistancePrecision::Single )
+	{
+		mSingleDistances.resize( int( pairCount ) );
+	}
+	else
+	{
+		mDoubleDistances.resize( int( pairCount ) );
+	}
+
+	// Upper triangular tiles of kBlockSize x kBlockSize sample pairs, distributed between the threads.
+	int blockCount = ( mSampleCount + kBlockSize - 1 ) / kBlockSize;
+
+	QVector< QPair< int, int > > tiles;
+	tiles.reserve( blockCount * ( blockCount + 1 ) / 2 );
+	for ( int firstBlock = 0; firstBlock < blockCount; ++firstBlock )
+	{
+		for ( int secondBlock = firstBlock; secondBlock < blockCount; ++secondBlock )
+		{
+			tiles.push_back( qMakePair( firstBlock, secondBlock ) );
+		}
+	}
+
+	const double* data = rows.data();
+	double* doubleDistances = mDoubleDistances.data();
+	float* singleDistances  = mSingleDistances.data();
+	int tileCount           = tiles.size();
+	bool isSingle           = mPrecision == DistancePrecision::Single;
+
+	#pragma omp parallel for schedule( dynamic )
+	for ( int tileIndex = 0; tileIndex < tileCount; ++tileIndex )
+	{
+		unsigned int firstBegin  = tiles.at( tileIndex ).first * kBlockSize;
+		unsigned int secondBegin = tiles.at( tileIndex ).second * kBlockSize;
+		unsigned int firstEnd    = std::min( firstBegin + kBlockSize, mSampleCount );
+		unsigned int secondEnd   = std::min( secondBegin + kBlockSize, mSampleCount );
+
+		for ( unsigned int first = firstBegin; first < firstEnd; ++first )
+		{
+			const double* firstRow = data + ulint( first ) * featureCount;
+
+			for ( unsigned int second = std::max( secondBegin, first + 1 ); second < secondEnd; ++second )
+			{
+				double distance = DistanceKernels::distance( mMetric, firstRow, data + ulint( second ) * featureCount, featureCount );
+				int index       = condensedIndex( first, second );
+
+				if ( isSingle )
+				{
+					singleDistances[ index ] = float( distance );
+				}
+				else
+				{
+					doubleDistances[ index ] = distance;
+				}
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+double PairwiseDistanceMatrix::distance( const QString& aFirstKey, const QString& aSecondKey ) const
+{
+	int firstIndex  = indexOf( aFirstKey );
+	int secondIndex = indexOf( aSecondKey );
+
+	if ( firstIndex < 0 || secondIndex < 0 )
+	{
+		return -1.0;
+	}
+
+	return distance( unsigned( firstIndex ), unsigned( secondIndex ) );
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< unsigned int > PairwiseDistanceMatrix::indicesOf( const QStringList& aKeys ) const
+{
+	QVector< unsigned int > indices;
+	indices.reserve( aKeys.size() );
+
+	for ( auto& key : aKeys )
+	{
+		int index = indexOf( key );
+
+		if ( index >= 0 )
+		{
+			indices.push_back( index );
+		}
+	}
+
+	return indices;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< QPair< double, unsigned int > > PairwiseDistanceMatrix::nearestNeighbours( unsigned int aIndex, const QVector< unsigned int >& aCandidates, unsigned int aNeighbourCount ) const
+{
+	QVector< QPair< double, unsigned int > > neighbours;
+	neighbours.reserve( aCandidates.size() );
+
+	for ( auto candidate : aCandidates )
+	{
+		if ( candidate != aIndex )
+		{
+			neighbours.push_back( qMakePair( distance( aIndex, candidate ), candidate ) );
+		}
+	}
+
+	// Only the first aNeighbourCount have to be ordered.
+	int count = std::min( int( aNeighbourCount ), neighbours.size() );
+	std::partial_sort( neighbours.begin(), neighbours.begin() + count, neighbours.end() );
+	neighbours.resize( count );
+
+	return neighbours;
+}
+
+//-----------------------------------------------------------------------------
+
+bool PairwiseDistanceMatrix::isMatching( const lpmldata::TabularData& aFeatureDatabase ) const
+{
+	if ( aFeatureDatabase.rowCount() != mSampleCount )
+	{
+		return false;
+	}
+
+	for ( auto iterator = aFeatureDatabase.table().constBegin(); iterator != aFeatureDatabase.table().constEnd(); ++iterator )
+	{
+		if ( !mIndices.contains( iterator.key() ) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+ulint PairwiseDistanceMatrix::memorySize() const
+{
+	return ulint( mDoubleDistances.size() ) * sizeof( double ) + ulint( mSingleDistances.size() ) * sizeof( float ) + ulint( mRows.rowCount() ) * mRows.columnCount() * sizeof( double );
+}
+
+//-----------------------------------------------------------------------------
+
+}
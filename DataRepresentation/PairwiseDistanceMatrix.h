@@ -0,0 +1,168 @@
+/*!
+* \file
+* PairwiseDistanceMatrix class definition. This file is part of DataRepresentation module.
+* The PairwiseDistanceMatrix holds the distances between every pair of samples of a feature table in condensed (upper triangular) form.
+* It is computed once in parallel blocks, afterwards the resampling methods only look up the distances.
+* Cohorts whose condensed matrix does not fit into a Qt container keep only the dense feature rows and compute each distance on request.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <DataRepresentation/Export.h>
+#include <DataRepresentation/Types.h>
+#include <DataRepresentation/TabularData.h>
+#include <DataRepresentation/Array2D.h>
+#include <DataRepresentation/DistanceKernels.h>
+#include <QVector>
+#include <QStringList>
+#include <QHash>
+#include <QPair>
+#include <algorithm>
+
+namespace lpmldata
+{
+
+//-----------------------------------------------------------------------------
+
+/*!
+* \brief Storage precision of the condensed distances.
+*/
+enum class DistancePrecision
+{
+	Double = 0,  //!< 8 bytes per pair.
+	Single       //!< 4 bytes per pair, halves the memory of large cohorts.
+};
+
+//-----------------------------------------------------------------------------
+
+class DataRepresentation_API PairwiseDistanceMatrix
+{
+
+public:
+
+	/*!
+	* \brief Constructor of an empty matrix.
+	*/
+	PairwiseDistanceMatrix();
+
+	/*!
+	* \brief Computes the distances between all samples of a feature table.
+	* \param [in] aFeatureDatabase The feature table, each key is a sample.
+	* \param [in] aPrecision Storage precision of the distances.
+	* \param [in] aFeatureMask Optional mask, only features with a positive mask value are used. Ignored if its size does not match the column count.
+	* \param [in] aMetric The distance metric.
+	*/
+	PairwiseDistanceMatrix( const lpmldata::TabularData& aFeatureDatabase, DistancePrecision aPrecision = DistancePrecision::Double, const QVector< double >& aFeatureMask = QVector< double >(), DistanceMetric aMetric = DistanceMetric::Euclidean );
+
+	/*!
+	* \brief Destructor.
+	*/
+	~PairwiseDistanceMatrix() {}
+
+	/*!
+	* \brief Recomputes the matrix for a new feature table.
+	*/
+	void compute( const lpmldata::TabularData& aFeatureDatabase, DistancePrecision aPrecision = DistancePrecision::Double, const QVector< double >& aFeatureMask = QVector< double >(), DistanceMetric aMetric = DistanceMetric::Euclidean );
+
+	/*!
+	* \brief Distance of two samples by index, 0 on the diagonal.
+	*/
+	double distance( unsigned int aFirstIndex, unsigned int aSecondIndex ) const
+	{
+		if ( aFirstIndex == aSecondIndex ) return 0.0;
+		if ( aFirstIndex > aSecondIndex ) std::swap( aFirstIndex, aSecondIndex );
+
+		if ( mIsOnDemand )
+		{
+			unsigned int featureCount = mRows.columnCount();
+			double distance           = DistanceKernels::distance( mMetric, mRows.data() + ulint( aFirstIndex ) * featureCount, mRows.data() + ulint( aSecondIndex ) * featureCount, featureCount );
+
+			return mPrecision == DistancePrecision::Single ? double( float( distance ) ) : distance;
+		}
+
+		int index = condensedIndex( aFirstIndex, aSecondIndex );
+
+		return mPrecision == DistancePrecision::Single ? double( mSingleDistances.constData()[ index ] ) : mDoubleDistances.constData()[ index ];
+	}
+
+	/*!
+	* \brief Distance of two samples by key, -1 if any of the keys is unknown.
+	*/
+	double distance( const QString& aFirstKey, const QString& aSecondKey ) const;
+
+	/*!
+	* \brief Index of a sample key, -1 if the key is unknown.
+	*/
+	int indexOf( const QString& aKey ) const { return mIndices.value( aKey, -1 ); }
+
+	/*!
+	* \brief Indices of the given keys, unknown keys are skipped.
+	*/
+	QVector< unsigned int > indicesOf( const QStringList& aKeys ) const;
+
+	/*!
+	* \brief The k nearest candidates of a sample ordered by distance, the sample itself is excluded. Ties are resolved by index.
+	* \param [in] aIndex The index of the sample.
+	* \param [in] aCandidates Indices of the candidate neighbours.
+	* \param [in] aNeighbourCount The number of neighbours to return.
+	* \return Pairs of distance and index.
+	*/
+	QVector< QPair< double, unsigned int > > nearestNeighbours( unsigned int aIndex, const QVector< unsigned int >& aCandidates, unsigned int aNeighbourCount ) const;
+
+	/*!
+	* \brief True if the matrix was computed from a table with exactly the given sample keys.
+	*/
+	bool isMatching( const lpmldata::TabularData& aFeatureDatabase ) const;
+
+	const QStringList& keys() const { return mKeys; }
+
+	const QString& key( unsigned int aIndex ) const { return mKeys.at( aIndex ); }
+
+	unsigned int sampleCount() const { return mSampleCount; }
+
+	bool isEmpty() const { return mSampleCount == 0; }
+
+	DistancePrecision precision() const { return mPrecision; }
+
+	DistanceMetric metric() const { return mMetric; }
+
+	/*!
+	* \brief True if the distances are computed on each request instead of being stored.
+	*/
+	bool isOnDemand() const { return mIsOnDemand; }
+
+	/*!
+	* \brief Size of the distance storage in bytes, or of the feature rows if the distances are computed on demand.
+	*/
+	ulint memorySize() const;
+
+private:
+
+	int condensedIndex( unsigned int aRow, unsigned int aColumn ) const
+	{
+		// Row aRow holds the pairs ( aRow, aRow + 1 ) ... ( aRow, n - 1 ).
+		ulint row = aRow;
+		return int( row * ( 2 * ulint( mSampleCount ) - row - 1 ) / 2 + ( aColumn - aRow - 1 ) );
+	}
+
+private:
+
+	unsigned int               mSampleCount;
+	DistancePrecision          mPrecision;
+	DistanceMetric             mMetric;
+	QStringList                mKeys;             //!< Sorted sample keys, the position is the sample index.
+	QHash< QString, int >      mIndices;          //!< Sample key to index.
+	QVector< double >          mDoubleDistances;  //!< Condensed distances, used with DistancePrecision::Double.
+	QVector< float >           mSingleDistances;  //!< Condensed distances, used with DistancePrecision::Single.
+	bool                       mIsOnDemand;       //!< True if the condensed matrix is too large for a Qt container.
+	Array2D< double >          mRows;             //!< Row-major feature rows of the samples, kept only if mIsOnDemand.
+};
+
+//-----------------------------------------------------------------------------
+
+}
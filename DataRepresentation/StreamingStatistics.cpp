@@ -0,0 +1,489 @@
+/*!
+* \file
+* Member function definitions for StreamingStatistics class. This file is part of DataRepresentation module.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#include <DataRepresentation/StreamingStatistics.h>
+#include <QDebug>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <omp.h>
+
+namespace lpmldata
+{
+
+//-----------------------------------------------------------------------------
+
+StreamingStatistics::StreamingStatistics( unsigned int aColumnCount, bool aIsCovarianceEnabled )
+:
+	mCount( 0 ),
+	mCounts(),
+	mColumnCount( 0 ),
+	mIsCovarianceEnabled( false ),
+	mMeans(),
+	mSquareSums(),
+	mMins(),
+	mMaxs(),
+	mCoMoments(),
+	mPairMeans(),
+	mPairCounts(),
+	mColumnNames()
+{
+	reset( aColumnCount, aIsCovarianceEnabled );
+}
+
+//-----------------------------------------------------------------------------
+
+void StreamingStatistics::reset( unsigned int aColumnCount, bool aIsCovarianceEnabled )
+{
+	mCount               = 0;
+	mColumnCount         = aColumnCount;
+	mIsCovarianceEnabled = aIsCovarianceEnabled;
+
+	mCounts.fill( 0, aColumnCount );
+	mMeans.fill( 0.0, aColumnCount );
+	mSquareSums.fill( 0.0, aColumnCount );
+	mMins.fill( DBL_MAX, aColumnCount );
+	mMaxs.fill( -DBL_MAX, aColumnCount );
+
+	if ( aIsCovarianceEnabled )
+	{
+		mCoMoments.fill( 0.0, aColumnCount * aColumnCount );
+	}
+	else
+	{
+		mCoMoments.clear();
+	}
+
+	mPairMeans.clear();
+	mPairCounts.clear();
+	mColumnNames.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+void StreamingStatistics::addChunk( const double* aRows, unsigned int aRowCount )
+{
+	if ( aRowCount == 0 || mColumnCount == 0 )
+	{
+		return;
+	}
+
+	// Small chunks are not worth the thread start-up.
+	const unsigned int minimumRowsPerThread = 256;
+
+#ifdef _OPENMP
+	// Chunks accumulated by the threads of an enclosing region are not split further.
+	int maxThreadCount = omp_in_parallel() ? 1 : omp_get_max_threads();
+#else
+	int maxThreadCount = 1;
+#endif
+
+	int threadCount = std::max( 1, std::min( maxThreadCount, int( aRowCount / minimumRowsPerThread ) ) );
+
+	if ( threadCount == 1 )
+	{
+		accumulate( aRows, aRowCount );
+		return;
+	}
+
+	// Every thread summarizes a contiguous block of rows, the partial results are merged in order.
+	QVector< StreamingStatistics > partials( threadCount, StreamingStatistics( mColumnCount, mIsCovarianceEnabled ) );
+	StreamingStatistics* partialData = partials.data();
+
+	#pragma omp parallel for num_threads( threadCount )
+	for ( int threadIndex = 0; threadIndex < threadCount; ++threadIndex )
+	{
+		ulint beginRow = ulint( aRowCount ) * threadIndex / threadCount;
+		ulint endRow   = ulint( aRowCount ) * ( threadIndex + 1 ) / threadCount;
+
+		partialData[ threadIndex ].accumulate( aRows + beginRow * mColumnCount, static_cast< unsigned int >( endRow - beginRow ) );
+	}
+
+	for ( const auto& partial : partials )
+	{
+		merge( partial );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void StreamingStatistics::accumulate( const double* aRows, unsigned int aRowCount )
+{
+	// Two-pass statistics of the chunk itself, then a pairwise merge into the running statistics.
+	StreamingStatistics chunk( mColumnCount, mIsCovarianceEnabled );
+	chunk.mCount = aRowCount;
+
+	ulint* counts      = chunk.mCounts.data();
+	double* means      = chunk.mMeans.data();
+	double* squareSums = chunk.mSquareSums.data();
+	double* mins       = chunk.mMins.data();
+	double* maxs       = chunk.mMaxs.data();
+	bool isComplete    = true;
+
+	for ( unsigned int rowIndex = 0; rowIndex < aRowCount; ++rowIndex )
+	{
+		const double* row = aRows + ulint( rowIndex ) * mColumnCount;
+
+		for ( unsigned int columnIndex = 0; columnIndex < mColumnCount; ++columnIndex )
+		{
+			double value = row[ columnIndex ];
+
+			if ( value != value )
+			{
+				isComplete = false;
+				continue;
+			}
+
+			++counts[ columnIndex ];
+			means[ columnIndex ] += value;
+			if ( value < mins[ columnIndex ] ) mins[ columnIndex ] = value;
+			if ( value > maxs[ columnIndex ] ) maxs[ columnIndex ] = value;
+		}
+	}
+
+	for ( unsigned int columnIndex = 0; columnIndex < mColumnCount; ++columnIndex )
+	{
+		if ( counts[ columnIndex ] > 0 )
+		{
+			means[ columnIndex ] /= counts[ columnIndex ];
+		}
+	}
+
+	// With missing values every column pair is centered on its own means, over the rows where both columns are present.
+	double* pairMeans = nullptr;
+
+	if ( mIsCovarianceEnabled && !isComplete )
+	{
+		chunk.mPairMeans.fill( 0.0, mColumnCount * mColumnCount );
+		chunk.mPairCounts.fill( 0, mColumnCount * mColumnCount );
+
+		pairMeans         = chunk.mPairMeans.data();
+		ulint* pairCounts = chunk.mPairCounts.data();
+
+		for ( unsigned int rowIndex = 0; rowIndex < aRowCount; ++rowIndex )
+		{
+			const double* row = aRows + ulint( rowIndex ) * mColumnCount;
+
+			for ( unsigned int i = 0; i < mColumnCount; ++i )
+			{
+				if ( row[ i ] != row[ i ] ) continue;
+
+				ulint rowOffset = ulint( i ) * mColumnCount;
+
+				for ( unsigned int j = 0; j < mColumnCount; ++j )
+				{
+					if ( row[ j ] != row[ j ] ) continue;
+
+					pairMeans[ rowOffset + j ] += row[ i ];
+					++pairCounts[ rowOffset + j ];
+				}
+			}
+		}
+
+		for ( ulint pairIndex = 0; pairIndex < ulint( mColumnCount ) * mColumnCount; ++pairIndex )
+		{
+			if ( pairCounts[ pairIndex ] > 0 )
+			{
+				pairMeans[ pairIndex ] /= pairCounts[ pairIndex ];
+			}
+		}
+	}
+
+	QVector< double > centered( mColumnCount );
+	double* centeredData = centered.data();
+	double* coMoments    = chunk.mCoMoments.data();
+
+	for ( unsigned int rowIndex = 0; rowIndex < aRowCount; ++rowIndex )
+	{
+		const double* row = aRows + ulint( rowIndex ) * mColumnCount;
+
+		for ( unsigned int columnIndex = 0; columnIndex < mColumnCount; ++columnIndex )
+		{
+			centeredData[ columnIndex ] = row[ columnIndex ] - means[ columnIndex ];
+
+			if ( centeredData[ columnIndex ] == centeredData[ columnIndex ] )
+			{
+				squareSums[ columnIndex ] += centeredData[ columnIndex ] * centeredData[ columnIndex ];
+			}
+		}
+
+		if ( mIsCovarianceEnabled && isComplete )
+		{
+			// Upper triangle only, mirrored below.
+			for ( unsigned int i = 0; i < mColumnCount; ++i )
+			{
+				double left = centeredData[ i ];
+				double* coMomentRow = coMoments + ulint( i ) * mColumnCount;
+
+				for ( unsigned int j = i; j < mColumnCount; ++j )
+				{
+					coMomentRow[ j ] += left * centeredData[ j ];
+				}
+			}
+		}
+		else if ( mIsCovarianceEnabled )
+		{
+			for ( unsigned int i = 0; i < mColumnCount; ++i )
+			{
+				if ( row[ i ] != row[ i ] ) continue;
+
+				double* coMomentRow = coMoments + ulint( i ) * mColumnCount;
+
+				for ( unsigned int j = i; j < mColumnCount; ++j )
+				{
+					if ( row[ j ] != row[ j ] ) continue;
+
+					coMomentRow[ j ] += ( row[ i ] - pairMeans[ ulint( i ) * mColumnCount + j ] ) * ( row[ j ] - pairMeans[ ulint( j ) * mColumnCount + i ] );
+				}
+			}
+		}
+	}
+
+	if ( mIsCovarianceEnabled )
+	{
+		for ( unsigned int i = 0; i < mColumnCount; ++i )
+		{
+			for ( unsigned int j = 0; j < i; ++j )
+			{
+				coMoments[ ulint( i ) * mColumnCount + j ] = coMoments[ ulint( j ) * mColumnCount + i ];
+			}
+		}
+	}
+
+	merge( chunk );
+}
+
+//-----------------------------------------------------------------------------
+
+void StreamingStatistics::expandPairs()
+{
+	if ( !mIsCovarianceEnabled || !isComplete() )
+	{
+		return;
+	}
+
+	mPairMeans.resize( mColumnCount * mColumnCount );
+	mPairCounts.fill( mCount, mColumnCount * mColumnCount );
+
+	for ( unsigned int i = 0; i < mColumnCount; ++i )
+	{
+		std::fill( mPairMeans.begin() + ulint( i ) * mColumnCount, mPairMeans.begin() + ulint( i + 1 ) * mColumnCount, mMeans.at( i ) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void StreamingStatistics::merge( const StreamingStatistics& aOther )
+{
+	if ( aOther.mCount == 0 )
+	{
+		return;
+	}
+
+	if ( aOther.mColumnCount != mColumnCount || aOther.mIsCovarianceEnabled != mIsCovarianceEnabled )
+	{
+		qDebug() << "StreamingStatistics - Error: Cannot merge statistics with different column layout";
+		return;
+	}
+
+	if ( mCount == 0 )
+	{
+		mCount      = aOther.mCount;
+		mCounts     = aOther.mCounts;
+		mMeans      = aOther.mMeans;
+		mSquareSums = aOther.mSquareSums;
+		mMins       = aOther.mMins;
+		mMaxs       = aOther.mMaxs;
+		mCoMoments  = aOther.mCoMoments;
+		mPairMeans  = aOther.mPairMeans;
+		mPairCounts = aOther.mPairCounts;
+		return;
+	}
+
+	if ( mIsCovarianceEnabled && ( !isComplete() || !aOther.isComplete() ) )
+	{
+		// Before the means change, the pairs start from them.
+		expandPairs();
+
+		double* coMoments            = mCoMoments.data();
+		const double* otherCoMoments = aOther.mCoMoments.constData();
+
+		for ( unsigned int i = 0; i < mColumnCount; ++i )
+		{
+			for ( unsigned int j = i; j < mColumnCount; ++j )
+			{
+				ulint pairIndex   = ulint( i ) * mColumnCount + j;
+				ulint mirrorIndex = ulint( j ) * mColumnCount + i;
+
+				double firstCount  = double( mPairCounts.at( pairIndex ) );
+				double secondCount = double( aOther.pairCount( i, j ) );
+
+				if ( secondCount == 0.0 )
+				{
+					continue;
+				}
+
+				double totalCount = firstCount + secondCount;
+				double leftDelta  = aOther.pairMean( i, j ) - mPairMeans.at( pairIndex );
+				double rightDelta = aOther.pairMean( j, i ) - mPairMeans.at( mirrorIndex );
+
+				coMoments[ pairIndex ]   += otherCoMoments[ pairIndex ] + leftDelta * rightDelta * firstCount * secondCount / totalCount;
+				coMoments[ mirrorIndex ]  = coMoments[ pairIndex ];
+
+				mPairMeans[ pairIndex ] += leftDelta * secondCount / totalCount;
+				if ( i != j )
+				{
+					mPairMeans[ mirrorIndex ] += rightDelta * secondCount / totalCount;
+				}
+
+				mPairCounts[ pairIndex ]   = static_cast< ulint >( totalCount );
+				mPairCounts[ mirrorIndex ] = static_cast< ulint >( totalCount );
+			}
+		}
+	}
+	else if ( mIsCovarianceEnabled )
+	{
+		// Chan et al. pairwise update, every column has all rows.
+		double factor = double( mCount ) * double( aOther.mCount ) / double( mCount + aOther.mCount );
+
+		QVector< double > deltas( mColumnCount );
+
+		for ( unsigned int columnIndex = 0; columnIndex < mColumnCount; ++columnIndex )
+		{
+			deltas[ columnIndex ] = aOther.mMeans.at( columnIndex ) - mMeans.at( columnIndex );
+		}
+
+		double* coMoments            = mCoMoments.data();
+		const double* otherCoMoments = aOther.mCoMoments.constData();
+
+		for ( unsigned int i = 0; i < mColumnCount; ++i )
+		{
+			double leftDelta = deltas.at( i ) * factor;
+			ulint rowOffset  = ulint( i ) * mColumnCount;
+
+			for ( unsigned int j = 0; j < mColumnCount; ++j )
+			{
+				coMoments[ rowOffset + j ] += otherCoMoments[ rowOffset + j ] + leftDelta * deltas.at( j );
+			}
+		}
+	}
+
+	// Chan et al. pairwise update of each column over its present values.
+	for ( unsigned int columnIndex = 0; columnIndex < mColumnCount; ++columnIndex )
+	{
+		double firstCount  = double( mCounts.at( columnIndex ) );
+		double secondCount = double( aOther.mCounts.at( columnIndex ) );
+
+		if ( secondCount == 0.0 )
+		{
+			continue;
+		}
+
+		double totalCount = firstCount + secondCount;
+		double delta      = aOther.mMeans.at( columnIndex ) - mMeans.at( columnIndex );
+
+		mMeans[ columnIndex ]      += delta * secondCount / totalCount;
+		mSquareSums[ columnIndex ] += aOther.mSquareSums.at( columnIndex ) + delta * delta * firstCount * secondCount / totalCount;
+		mMins[ columnIndex ]        = std::min( mMins.at( columnIndex ), aOther.mMins.at( columnIndex ) );
+		mMaxs[ columnIndex ]        = std::max( mMaxs.at( columnIndex ), aOther.mMaxs.at( columnIndex ) );
+		mCounts[ columnIndex ]     += aOther.mCounts.at( columnIndex );
+	}
+
+	mCount += aOther.mCount;
+}
+
+//-----------------------------------------------------------------------------
+
+double StreamingStatistics::variance( unsigned int aColumnIndex ) const
+{
+	if ( mCounts.at( aColumnIndex ) == 0 )
+	{
+		return 0.0;
+	}
+
+	return mSquareSums.at( aColumnIndex ) / mCounts.at( aColumnIndex );
+}
+
+//-----------------------------------------------------------------------------
+
+double StreamingStatistics::deviation( unsigned int aColumnIndex ) const
+{
+	return std::sqrt( variance( aColumnIndex ) );
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< double > StreamingStatistics::deviations() const
+{
+	QVector< double > deviations( mColumnCount );
+
+	for ( unsigned int columnIndex = 0; columnIndex < mColumnCount; ++columnIndex )
+	{
+		deviations[ columnIndex ] = deviation( columnIndex );
+	}
+
+	return deviations;
+}
+
+//-----------------------------------------------------------------------------
+
+double StreamingStatistics::covariance( unsigned int aFirstIndex, unsigned int aSecondIndex ) const
+{
+	if ( !mIsCovarianceEnabled )
+	{
+		qDebug() << "StreamingStatistics - Error: Covariance accumulation is not enabled";
+		return 0.0;
+	}
+
+	ulint count = pairCount( aFirstIndex, aSecondIndex );
+
+	if ( count == 0 )
+	{
+		return 0.0;
+	}
+
+	return mCoMoments.at( aFirstIndex * mColumnCount + aSecondIndex ) / count;
+}
+
+//-----------------------------------------------------------------------------
+
+double StreamingStatistics::correlation( unsigned int aFirstIndex, unsigned int aSecondIndex ) const
+{
+	if ( !mIsCovarianceEnabled )
+	{
+		qDebug() << "StreamingStatistics - Error: Covariance accumulation is not enabled";
+		return 0.0;
+	}
+
+	if ( isComplete() )
+	{
+		double denominator = std::sqrt( mCoMoments.at( aFirstIndex * mColumnCount + aFirstIndex ) * mCoMoments.at( aSecondIndex * mColumnCount + aSecondIndex ) );
+
+		if ( denominator == 0.0 )
+		{
+			return 0.0;
+		}
+
+		return mCoMoments.at( aFirstIndex * mColumnCount + aSecondIndex ) / denominator;
+	}
+
+	double denominator = deviation( aFirstIndex ) * deviation( aSecondIndex );
+
+	if ( denominator == 0.0 )
+	{
+		return 0.0;
+	}
+
+	return std::max( -1.0, std::min( 1.0, covariance( aFirstIndex, aSecondIndex ) / denominator ) );
+}
+
+//-----------------------------------------------------------------------------
+
+}
@@ -0,0 +1,155 @@
+/*!
+* \file
+* StreamingStatistics class definition. This file is part of DataRepresentation module.
+* The StreamingStatistics accumulates column means, deviations, minimums, maximums and optionally the covariance of numeric rows in a single pass.
+* Rows are fed in chunks, partial results of separate chunks can be merged (Welford update with Chan's pairwise merge), so the data never has to be materialized.
+* Missing values are passed as NaN and skipped cell by cell: every column has its own count, every column pair its own co-moment over the rows where both are present.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <DataRepresentation/Export.h>
+#include <DataRepresentation/Types.h>
+#include <QVector>
+#include <QStringList>
+
+namespace lpmldata
+{
+
+//-----------------------------------------------------------------------------
+
+class DataRepresentation_API StreamingStatistics
+{
+
+public:
+
+	/*!
+	* \brief Constructor.
+	* \param [in] aColumnCount The number of numeric columns in each row.
+	* \param [in] aIsCovarianceEnabled If true, the full co-moment matrix is accumulated as well.
+	*/
+	StreamingStatistics( unsigned int aColumnCount = 0, bool aIsCovarianceEnabled = false );
+
+	/*!
+	* \brief Destructor.
+	*/
+	~StreamingStatistics() {}
+
+	/*!
+	* \brief Clears the accumulated statistics and sets a new column layout.
+	* \param [in] aColumnCount The number of numeric columns in each row.
+	* \param [in] aIsCovarianceEnabled If true, the full co-moment matrix is accumulated as well.
+	*/
+	void reset( unsigned int aColumnCount, bool aIsCovarianceEnabled );
+
+	/*!
+	* \brief Adds one row.
+	* \param [in] aRow Pointer to columnCount() values, NaN for the missing ones.
+	*/
+	void addRow( const double* aRow ) { addChunk( aRow, 1 ); }
+
+	/*!
+	* \brief Adds a chunk of rows. Large chunks are split between threads and the partial statistics are merged.
+	* \param [in] aRows Row-major block of aRowCount x columnCount() values, NaN for the missing ones.
+	* \param [in] aRowCount The number of rows in the block.
+	*/
+	void addChunk( const double* aRows, unsigned int aRowCount );
+
+	/*!
+	* \brief Merges the statistics accumulated by an other instance with the same column layout.
+	* \param [in] aOther The statistics to merge.
+	*/
+	void merge( const StreamingStatistics& aOther );
+
+	/*!
+	* \brief The number of accumulated rows, including the ones with missing values.
+	*/
+	ulint count() const { return mCount; }
+
+	/*!
+	* \brief The number of present (not NaN) values of a column.
+	*/
+	ulint count( unsigned int aColumnIndex ) const { return mCounts.at( aColumnIndex ); }
+
+	unsigned int columnCount() const { return mColumnCount; }
+
+	bool isCovarianceEnabled() const { return mIsCovarianceEnabled; }
+
+	QStringList& columnNames() { return mColumnNames; }
+
+	const QStringList& columnNames() const { return mColumnNames; }
+
+	double mean( unsigned int aColumnIndex ) const { return mMeans.at( aColumnIndex ); }
+
+	double min( unsigned int aColumnIndex ) const { return mMins.at( aColumnIndex ); }
+
+	double max( unsigned int aColumnIndex ) const { return mMaxs.at( aColumnIndex ); }
+
+	/*!
+	* \brief Population variance of a column.
+	*/
+	double variance( unsigned int aColumnIndex ) const;
+
+	/*!
+	* \brief Population standard deviation of a column, same definition as TabularData::deviation().
+	*/
+	double deviation( unsigned int aColumnIndex ) const;
+
+	/*!
+	* \brief Population covariance of two columns over the rows where both are present. Requires covariance accumulation.
+	*/
+	double covariance( unsigned int aFirstIndex, unsigned int aSecondIndex ) const;
+
+	/*!
+	* \brief Pearson correlation of two columns, 0 if any of them is constant. Requires covariance accumulation.
+	* \details With missing values the pairwise covariance is scaled by the deviations of the columns, the result is clipped to [-1, 1].
+	*/
+	double correlation( unsigned int aFirstIndex, unsigned int aSecondIndex ) const;
+
+	const QVector< double >& means() const { return mMeans; }
+
+	const QVector< double >& mins() const { return mMins; }
+
+	const QVector< double >& maxs() const { return mMaxs; }
+
+	QVector< double > deviations() const;
+
+private:
+
+	void accumulate( const double* aRows, unsigned int aRowCount );
+
+	/*!
+	* \brief Switches the co-moments to per pair counts and means, used from the first missing value on.
+	*/
+	void expandPairs();
+
+	bool isComplete() const { return mPairCounts.isEmpty(); }
+
+	double pairMean( unsigned int aFirstIndex, unsigned int aSecondIndex ) const { return isComplete() ? mMeans.at( aFirstIndex ) : mPairMeans.at( aFirstIndex * mColumnCount + aSecondIndex ); }
+
+	ulint pairCount( unsigned int aFirstIndex, unsigned int aSecondIndex ) const { return isComplete() ? mCount : mPairCounts.at( aFirstIndex * mColumnCount + aSecondIndex ); }
+
+private:
+
+	ulint              mCount;                 //!< The number of accumulated rows.
+	QVector< ulint >   mCounts;                //!< The number of present values of each column.
+	unsigned int       mColumnCount;           //!< The number of columns.
+	bool               mIsCovarianceEnabled;   //!< True if the co-moment matrix is accumulated.
+	QVector< double >  mMeans;                 //!< Running means of the columns.
+	QVector< double >  mSquareSums;            //!< Sum of squared differences from the mean of each column.
+	QVector< double >  mMins;                  //!< Minimum of each column.
+	QVector< double >  mMaxs;                  //!< Maximum of each column.
+	QVector< double >  mCoMoments;             //!< Row-major columnCount x columnCount co-moment matrix, empty if disabled.
+	QVector< double >  mPairMeans;             //!< Element (i, j) is the mean of column i over the rows where column j is present. Empty while no value is missing.
+	QVector< ulint >   mPairCounts;            //!< The number of rows where both columns are present. Empty while no value is missing.
+	QStringList        mColumnNames;           //!< Optional names of the columns.
+};
+
+//-----------------------------------------------------------------------------
+
+}
@@ -10,17 +10,29 @@
 
 #include <DataRepresentation/TabularData.h>
 #include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <limits>
+#include <omp.h>
 
 namespace lpmldata
 {
 
+namespace
+{
+	std::atomic< quint64 > lastVersion( 0 );
+}
+
 //-----------------------------------------------------------------------------
 
 TabularData::TabularData()
 	:
 	mTable(),
 	mHeader(),
-	mName()
+	mName(),
+	mVersion( ++lastVersion ),
+	mColumnStatistics()
 {
 }
 
@@ -30,7 +42,9 @@ TabularData::TabularData( const QString& aName )
 :
 	mTable(),
 	mHeader(),
-	mName( aName )
+	mName( aName ),
+	mVersion( ++lastVersion ),
+	mColumnStatistics()
 {
 }
 
@@ -40,7 +54,9 @@ TabularData::TabularData( const TabularData& aOther )
 : 
 	mTable( aOther.mTable ),
 	mHeader( aOther.mHeader ),
-	mName( aOther.mName ) 
+	mName( aOther.mName ),
+	mVersion( aOther.mVersion.load() ),
+	mColumnStatistics( std::atomic_load( &aOther.mColumnStatistics ) )
 {
 }
 
@@ -50,8 +66,11 @@ TabularData::TabularData( TabularData&& aOther )
 : 
 	mTable( std::move( aOther.mTable ) ),
 	mHeader( aOther.mHeader ),
-	mName( aOther.mName )
+	mName( aOther.mName ),
+	mVersion( aOther.mVersion.load() ),
+	mColumnStatistics( std::atomic_load( &aOther.mColumnStatistics ) )
 {
+	aOther.touch();
 }
 
 //-----------------------------------------------------------------------------
@@ -78,6 +97,7 @@ void TabularData::setHeader( QStringList aHeaderNames )
 	}
 
 	mHeader = header;
+	touch();
 }
 
 //-----------------------------------------------------------------------------
@@ -92,6 +112,7 @@ void TabularData::setHeader( QString aHeaderName )
 	header.insert( QString::number( 0 ), headerValue );	
 
 	mHeader = header;
+	touch();
 }
 
 //-----------------------------------------------------------------------------
@@ -138,122 +159,142 @@ const QStringList TabularData::headerNames() const
 
 //-----------------------------------------------------------------------------
 
-double TabularData::mean( unsigned int aColumnIndex )
+void TabularData::touch()
 {
-	QVariantList col = column( aColumnIndex );
-
-	double mean = 0.0;
-
-	for ( int rowIndex = 0; rowIndex < col.size(); ++rowIndex )
-	{
-		mean += col.at( rowIndex ).toDouble();
-	}
-
-	return mean / col.size();
+	mVersion.store( ++lastVersion );
 }
 
 //-----------------------------------------------------------------------------
 
-double TabularData::deviation( unsigned int aColumnIndex )
+lpmldata::StreamingStatistics TabularData::columnStatistics() const
 {
-	QVariantList col = column( aColumnIndex );
-	double deviation = 0.0;
-	double meanOfColumn = mean( aColumnIndex );
+	// Tables shared between threads may be asked at the same time, the cache is only swapped as a whole.
+	std::shared_ptr< const ColumnStatisticsCache > cache = std::atomic_load( &mColumnStatistics );
+	quint64 version = mVersion.load();
 
-	for ( int rowIndex = 0; rowIndex < col.size(); ++rowIndex )
+	if ( cache == nullptr || cache->version != version )
 	{
-		deviation += ( col.at( rowIndex ).toDouble() - meanOfColumn ) * ( col.at( rowIndex ).toDouble() - meanOfColumn );
+		auto computed        = std::make_shared< ColumnStatisticsCache >();
+		computed->version    = version;
+		computed->statistics = statistics( false );
+
+		cache = computed;
+		std::atomic_store( &mColumnStatistics, cache );
 	}
 
-	return sqrt( deviation / col.size() );
+	return cache->statistics;
 }
 
 //-----------------------------------------------------------------------------
 
-double TabularData::min( unsigned int aColumnIndex )
+QVector< double > TabularData::mins() const
 {
-	QVariantList col = column( aColumnIndex );
-	double min = DBL_MAX;
+	return columnStatistics().mins();
+}
 
-	for ( int rowIndex = 0; rowIndex < col.size(); ++rowIndex )
-	{
-		double actVal = col.at( rowIndex ).toDouble();
-		if ( actVal < min ) min = actVal;
-	}
+//-----------------------------------------------------------------------------
 
-	return min;
+QVector< double > TabularData::maxs() const
+{
+	return columnStatistics().maxs();
 }
 
 //-----------------------------------------------------------------------------
 
-double TabularData::max( unsigned int aColumnIndex )
+QVariantList TabularData::means() const
 {
-	QVariantList col = column( aColumnIndex );
-	double max = -DBL_MAX;
+	QVariantList meanList;
 
-	for ( int rowIndex = 0; rowIndex < col.size(); ++rowIndex )
+	for ( double mean : columnStatistics().means() )
 	{
-		double actVal = col.at( rowIndex ).toDouble();
-		if ( actVal > max ) max = actVal;
+		meanList.push_back( mean );
 	}
 
-	return max;
+	return meanList;
 }
 
 //-----------------------------------------------------------------------------
 
-QVector< double > TabularData::mins()
+QVariantList TabularData::deviations() const
 {
-	QVector< double > mins;
+	QVariantList deviationList;
 
-	for ( int colIndex = 0; colIndex < columnCount(); ++colIndex )
+	for ( double deviation : columnStatistics().deviations() )
 	{
-		mins.push_back( this->min( colIndex ) );
+		deviationList.push_back( deviation );
 	}
 
-	return mins;
+	return deviationList;
 }
 
 //-----------------------------------------------------------------------------
 
-QVector< double > TabularData::maxs()
+lpmldata::StreamingStatistics TabularData::statistics( bool aIsCovarianceEnabled, unsigned int aChunkRowCount ) const
 {
-	QVector< double > maxs;
+	unsigned int columnCount = this->columnCount();
 
-	for ( int colIndex = 0; colIndex < columnCount(); ++colIndex )
+	if ( aChunkRowCount == 0 )
 	{
-		maxs.push_back( this->max( colIndex ) );
+		aChunkRowCount = 1;
 	}
 
-	return maxs;
-}
+	QVector< const QVariantList* > rows;
+	rows.reserve( mTable.size() );
 
-//-----------------------------------------------------------------------------
+	for ( auto rowIterator = mTable.constBegin(); rowIterator != mTable.constEnd(); ++rowIterator )
+	{
+		rows.push_back( &rowIterator.value() );
+	}
 
-QVariantList TabularData::means()
-{
-	QVariantList meanList;
+	const double missing = std::numeric_limits< double >::quiet_NaN();
+	int rowCount         = rows.size();
+	int chunkCount       = ( rowCount + aChunkRowCount - 1 ) / aChunkRowCount;
 
-	for ( unsigned int headerIndex = 0; headerIndex < mHeader.size(); ++headerIndex )
+	// Every thread packs and accumulates a contiguous range of chunks, the partial statistics are merged in row order.
+	int threadCount = std::max( 1, std::min( omp_get_max_threads(), chunkCount ) );
+	QVector< lpmldata::StreamingStatistics > partials( threadCount, lpmldata::StreamingStatistics( columnCount, aIsCovarianceEnabled ) );
+	lpmldata::StreamingStatistics* partialData = partials.data();
+
+	#pragma omp parallel num_threads( threadCount )
 	{
-		meanList.push_back( mean( headerIndex ) );
-	}
+		lpmldata::StreamingStatistics& partial = partialData[ omp_get_thread_num() ];
+		QVector< double > chunk( aChunkRowCount * columnCount );
 
-	return meanList;
-}
+		#pragma omp for schedule( static )
+		for ( int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex )
+		{
+			int beginRow = chunkIndex * aChunkRowCount;
+			int endRow   = std::min( beginRow + int( aChunkRowCount ), rowCount );
 
-//-----------------------------------------------------------------------------
+			for ( int rowIndex = beginRow; rowIndex < endRow; ++rowIndex )
+			{
+				const QVariantList& row = *rows.at( rowIndex );
+				double* chunkRow        = chunk.data() + ulint( rowIndex - beginRow ) * columnCount;
 
-QVariantList TabularData::deviations()
-{
-	QVariantList deviationList;
+				// Missing, non-numeric cells and the cells beyond a short row are passed as NaN, the statistics skip them.
+				for ( unsigned int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+				{
+					bool isNumber = false;
+					double value  = columnIndex < unsigned( row.size() ) ? row.at( columnIndex ).toDouble( &isNumber ) : missing;
+
+					chunkRow[ columnIndex ] = isNumber ? value : missing;
+				}
+			}
 
-	for ( unsigned int headerIndex = 0; headerIndex < mHeader.size(); ++headerIndex )
+			partial.addChunk( chunk.constData(), endRow - beginRow );
+		}
+	}
+
+	lpmldata::StreamingStatistics statistics( columnCount, aIsCovarianceEnabled );
+
+	for ( const auto& partial : partials )
 	{
-		deviationList.push_back( deviation( headerIndex ) );
+		statistics.merge( partial );
 	}
 
-	return deviationList;
+	statistics.columnNames() = headerNames();
+
+	return statistics;
 }
 
 //-----------------------------------------------------------------------------
@@ -285,6 +326,35 @@ void TabularData::mergeRecords( lpmldata::TabularData& aTabularData )
 
 //-----------------------------------------------------------------------------
 
+void TabularData::appendRows( const QStringList& aKeys, const lpmldata::Array2D< double >& aRows )
+{
+	int rowCount    = std::min( aKeys.size(), int( aRows.rowCount() ) );
+	int columnCount = aRows.columnCount();
+	QVector< QVariantList > rows( rowCount );
+
+	#pragma omp parallel for schedule( static )
+	for ( int rowIndex = 0; rowIndex < rowCount; ++rowIndex )
+	{
+		QVariantList& row = rows[ rowIndex ];
+		row.reserve( columnCount );
+
+		for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+		{
+			row.push_back( aRows( rowIndex, columnIndex ) );
+		}
+	}
+
+	touch();
+	mTable.reserve( mTable.size() + rowCount );
+
+	for ( int rowIndex = 0; rowIndex < rowCount; ++rowIndex )
+	{
+		mTable.insert( aKeys.at( rowIndex ), rows.at( rowIndex ) );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 lpmldata::TabularData TabularData::mergeFeatures( QList< lpmldata::TabularData > aTabularDatas, TabularDataMerge aMerge )
 {
 	lpmldata::TabularData mergedTabularData;
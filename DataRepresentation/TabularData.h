@@ -12,6 +12,8 @@
 
 #include <DataRepresentation/Export.h>
 #include <DataRepresentation/Types.h>
+#include <DataRepresentation/StreamingStatistics.h>
+#include <DataRepresentation/Array2D.h>
 #include <QString>
 #include <QVariant>
 #include <QHash>
@@ -19,6 +21,9 @@
 #include <QFile>
 #include <QDataStream>
 #include <QVector>
+#include <memory>
+#include <atomic>
+#include <cmath>
 
 namespace lpmldata
 {
@@ -77,7 +82,7 @@ public:
 	* \brief Returns with the hash representing the table itself.
 	* \return The Qhash containing the table.
 	*/
-	TabularDataTable& table() { return mTable; }
+	TabularDataTable& table() { touch(); return mTable; }
 
 	const TabularDataTable& table() const { return mTable; }
 
@@ -85,7 +90,7 @@ public:
 	* \brief Returns with the map representing the table header.
 	* \return The QMap containing the header.
 	*/
-	TabularDataHeader& header() { return mHeader; }
+	TabularDataHeader& header() { touch(); return mHeader; }
 
 	const TabularDataHeader& header() const { return mHeader; }
 
@@ -104,15 +109,17 @@ public:
 	*/
 	const QVariantList value( const QString& aKey ) const { return mTable.value( aKey ); }
 
-	QVariantList& value( const QString& aKey ) { return mTable[ aKey ]; }
+	QVariantList& value( const QString& aKey ) { touch(); return mTable[ aKey ]; }
 
-	QVariantList& operator[]( const QString& aKey ) { return mTable[ aKey ]; }
+	QVariantList& operator[]( const QString& aKey ) { touch(); return mTable[ aKey ]; }
 
 	lpmldata::TabularData& operator=(const lpmldata::TabularData& aRight)
 	{
-		mTable  = aRight.mTable;
-		mHeader = aRight.mHeader;
-		mName   = aRight.mName;
+		mTable             = aRight.mTable;
+		mHeader            = aRight.mHeader;
+		mName              = aRight.mName;
+		mVersion           = aRight.mVersion.load();
+		mColumnStatistics  = std::atomic_load( &aRight.mColumnStatistics );
 		return *this;
 	}
 
@@ -124,21 +131,21 @@ public:
 	*/
 	const QVariant valueAt( QString aKey, int aColumnIndex ) const { return mTable.value( aKey ).at( aColumnIndex ); }
 
-	QVariant& valueAt( QString aKey, int aColumnIndex ) { return mTable[ aKey ][ aColumnIndex ]; }
+	QVariant& valueAt( QString aKey, int aColumnIndex ) { touch(); return mTable[ aKey ][ aColumnIndex ]; }
 
 	/*!
 	* \brief Inserts a new value identified with the key.
 	* \param [in] aKey The key of the value to insert.
 	* \param [in] aValue the value of the key to insert.
 	*/
-	void insert( const QString& aKey, const QVariantList& aValue ) { mTable.insert( aKey, aValue ); }	
+	void insert( const QString& aKey, const QVariantList& aValue ) { touch(); mTable.insert( aKey, aValue ); }	
 
 	/*!
 	* \brief Removes all values associated with the input key.
 	* \param [in] aKey The key of the value to remove.
 	* \return The number of values removed.
 	*/
-	int remove( const QString& aKey ) { return mTable.remove( aKey ); }
+	int remove( const QString& aKey ) { touch(); return mTable.remove( aKey ); }
 
 	/*!
 	* \brief Returns with the unique keys located in the table.
@@ -155,7 +162,7 @@ public:
 	/*!
 	* \brief Clears the table.
 	*/
-	void clear() { mTable.clear(); }
+	void clear() { touch(); mTable.clear(); }
 
 	unsigned int rowCount() const { return mTable.count(); }
 
@@ -167,28 +174,56 @@ public:
 
 
 	/*!
-	* \brief ...
-	* \param [in] ...
+	* \brief Returns with the version of the table, a new one is assigned by every member that changes the table or hands out a non-const reference to it.
+	* \details The non-const table(), header(), value(), operator[] and valueAt() assign it before returning the reference.
 	*/
-	double mean( unsigned int aColumnIndex );
+	quint64 version() const { return mVersion.load(); }
 
 	/*!
-	* \brief ...
-	* \param [in] ...
+	* \brief Returns with the statistics of all columns, the result of statistics() without covariance. They are computed on first use and kept until the table changes.
+	* \details A reference taken from a non-const accessor before this call and written after it goes unnoticed, take it again after computing the statistics.
 	*/
-	double deviation( unsigned int aColumnIndex );
+	lpmldata::StreamingStatistics columnStatistics() const;
 
-	double min( unsigned int aColumnIndex );
-	double max( unsigned int aColumnIndex );
+	/*!
+	* \brief Mean of the numeric values of a column.
+	* \param [in] aColumnIndex The column index.
+	*/
+	double mean( unsigned int aColumnIndex ) const { return columnStatistics().mean( aColumnIndex ); }
+
+	/*!
+	* \brief Population standard deviation of the numeric values of a column.
+	* \param [in] aColumnIndex The column index.
+	*/
+	double deviation( unsigned int aColumnIndex ) const { return columnStatistics().deviation( aColumnIndex ); }
+
+	double min( unsigned int aColumnIndex ) const { return columnStatistics().min( aColumnIndex ); }
+	double max( unsigned int aColumnIndex ) const { return columnStatistics().max( aColumnIndex ); }
 
-	QVector< double > mins();
-	QVector< double > maxs();
+	QVector< double > mins() const;
+	QVector< double > maxs() const;
 
-	QVariantList means();
+	QVariantList means() const;
 
-	QVariantList deviations();
+	QVariantList deviations() const;
+
+	/*!
+	* \brief Computes the column statistics in one pass over the rows, packed into dense chunks. The chunks are distributed between the threads.
+	* \details Missing and non-numeric values, and the values missing from short rows, are skipped cell by cell.
+	* \param [in] aIsCovarianceEnabled If true, the covariance of the columns is accumulated as well.
+	* \param [in] aChunkRowCount The number of rows packed and accumulated at once.
+	* \return The accumulated statistics, with the header names as column names.
+	*/
+	lpmldata::StreamingStatistics statistics( bool aIsCovarianceEnabled = false, unsigned int aChunkRowCount = 4096 ) const;
 
 	void mergeRecords( lpmldata::TabularData& aTabularData );
+
+	/*!
+	* \brief Appends a dense block of rows in one operation, the rows are converted in parallel and the table grows once.
+	* \param [in] aKeys The keys of the rows, existing keys are overwritten.
+	* \param [in] aRows One row per key with columnCount() values.
+	*/
+	void appendRows( const QStringList& aKeys, const lpmldata::Array2D< double >& aRows );
 	static lpmldata::TabularData mergeFeatures( QList< lpmldata::TabularData > aTabularDatas, TabularDataMerge aMerge );
 
 	friend QDataStream& TabularData::operator<<( QDataStream &out, TabularData& aTabularData )
@@ -206,6 +241,8 @@ public:
 			>> aTabularData.mHeader
 			>> aTabularData.mName;
 
+		aTabularData.touch();
+
 		return in;
 	}
 
@@ -223,10 +260,26 @@ public:
 	}
 
 
+private:
+
+	/*!
+	* \brief Assigns a new version, called by the members that change the table or hand out a non-const reference to it.
+	*/
+	void touch();
+
+	struct ColumnStatisticsCache
+	{
+		quint64                        version;     //!< The version of the table the statistics belong to.
+		lpmldata::StreamingStatistics  statistics;
+	};
+
 private:
 	lpmldata::TabularDataTable   mTable;        //!< The table containing the key and a respective variant list.
 	lpmldata::TabularDataHeader  mHeader;       //!< The table header containing the names and types of the columns. Key column is not taken into account.
 	QString                      mName;         //!< The name of the tabular data.
+	std::atomic< quint64 >       mVersion;      //!< Unique among all tables, changes on every modification and non-const access.
+
+	mutable std::shared_ptr< const ColumnStatisticsCache >  mColumnStatistics;  //!< Lazily computed, copies of the table share it until they change. Swapped atomically.
 
 };
 
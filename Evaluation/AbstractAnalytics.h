@@ -20,6 +20,8 @@ public:
 
 	virtual double evaluate( lpmleval::AbstractModel* aModel ) = 0;
 
+	virtual AbstractAnalytics* clone() const { return nullptr; }  // Independent copy that can evaluate in another thread, owned by the caller. nullptr if not supported.
+
 	virtual ~AbstractAnalytics();
 
 	virtual void setDataPackage( lpmldata::DataPackage* aDataPackage ) { /*mDataPackage = aDataPackage;*/ }
@@ -32,6 +32,14 @@ public:
 
 	virtual int inputCount() = 0;
 
+	virtual QVector< int > discreteIndices( const QVector< double >& aParameters ) const { return QVector< int >(); }  // Discrete configuration the parameters map to, empty for continuous models.
+
+	virtual QVector< int > discreteRanges() const { return QVector< int >(); }  // Number of values of each input of a discrete model, empty for continuous models.
+
+	virtual void setDiscrete( const QVector< int >& aIndices ) {}  // Sets the discrete configuration, one index per entry of discreteRanges().
+
+	virtual AbstractModel* clone() const { return nullptr; }  // Independent copy that can be set and evaluated in another thread, owned by the caller. nullptr if not supported.
+
 	virtual ~AbstractModel();
 
 	const QList< QString >& featureNames() const { return mFeatureNames; }
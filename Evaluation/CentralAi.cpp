@@ -2,6 +2,11 @@
 #include <Evaluation/NelderMeadOptimizer.h>
 #include <Evaluation/PipelineModel.h>
 #include <Evaluation/PipelineAnalytics.h>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
 
 namespace dkeval
 {
@@ -11,13 +16,37 @@ namespace dkeval
 
 void CentralAi::execute()
 {	
-	//Initialize population
-	initializePopulation( mOffspringCount );
+	//Continue an interrupted run from its checkpoint, otherwise initialize population
+	int completedCount = 0;
+
+	if ( !mIsResumed || !loadCheckpoint( completedCount ) )
+	{
+		initializePopulation( mOffspringCount );
+		saveCheckpoint( 0 );
+	}
 
 	//Iterate population in order to find the fittest pipeline + hyperparameter combination over training data
-	for ( int i = 0; i < mIterationCount; ++i )
+	if ( mIsSteadyState )
 	{
-		iteratePopulation();	
+		//Same number of evaluations as the generations, but each offspring is merged as soon as it is evaluated
+		iterateSteadyState( mOffspringCount * mIterationCount, completedCount );
+	}
+	else
+	{
+		for ( int i = completedCount; i < mIterationCount; ++i )
+		{
+			iteratePopulation();	
+
+			if ( mMigrationChannel != nullptr && ( i + 1 ) % mMigrationInterval == 0 )
+			{
+				migrate();
+			}
+
+			if ( mCheckpointInterval > 0 && ( i + 1 ) % mCheckpointInterval == 0 )
+			{
+				saveCheckpoint( i + 1 );
+			}
+		}
 	}
 
 	//Validate models
@@ -29,12 +58,14 @@ void CentralAi::execute()
 void CentralAi::iteratePopulation()
 {
 	Population offsprings;
+	QVector< Creature > candidates;  //Offsprings waiting for the race
+	QSet< Creature > bredOffsprings; //Offsprings and candidates of this generation
 
 	int populationSize                = mPopulation.size();
 	int attemptToCreateOffspringMax   = populationSize;
 	int attemptToCreateOffspringCount = 0;
 
-	while ( offsprings.size() < mPopulation.size() )
+	while ( offsprings.size() + candidates.size() < mPopulation.size() )
 	{
 		if ( attemptToCreateOffspringCount > attemptToCreateOffspringMax )
 		{
@@ -54,69 +85,299 @@ void CentralAi::iteratePopulation()
 		}
 		else
 		{
-			if ( mPopulation.values().contains( offspring ) )  // Is Offspring a clone?
+			if ( mPopulation.contains( offspring ) || bredOffsprings.contains( offspring ) )  // Is Offspring a clone?
 			{
 				++attemptToCreateOffspringCount;
 			}
+			else if ( mIsRacing )
+			{
+				attemptToCreateOffspringCount = 0;
+				candidates.push_back( offspring );
+				bredOffsprings.insert( offspring );
+			}
 			else
 			{
 				double fitness = calculateFitness( offspring, true );
 
 				attemptToCreateOffspringCount = 0;
-				offsprings.insertMulti( fitness, offspring );
+				offsprings.insert( fitness, offspring );
+				bredOffsprings.insert( offspring );
 			}
 		}
 	}
 
-	// Merge population and ofsprings and clear ofsprings
-	Population mergedPopulation;
-	mergedPopulation = mPopulation;
+	if ( mIsRacing )
+	{
+		offsprings = race( candidates );
+	}
 
+	// Merge population and ofsprings
 	for ( int i = 0; i < offsprings.size(); ++i )
 	{
-		auto key   = offsprings.keys().at( i );
-		auto value = offsprings.values().at( i );
-
-		mergedPopulation.insertMulti( key, value );
+		mPopulation.insert( offsprings.fitness( i ), offsprings.creature( i ) );
 	}
 
 	// Remove N least fitt creatures.
-	mPopulation.clear();
+	mPopulation.truncate( populationSize );
+}
+
+//-----------------------------------------------------------------------------
+
+void CentralAi::iterateSteadyState( int aEvaluationCount, int aCompletedCount )
+{
+	int populationSize                = mPopulation.size();
+	int attemptToCreateOffspringMax   = populationSize;
+	int attemptToCreateOffspringCount = 0;
+	int startedCount                  = aCompletedCount;  //A resumed run breeds the offsprings again that were under evaluation at the checkpoint
+	int mergedCount                   = aCompletedCount;
+	int checkpointEvaluationCount     = mCheckpointInterval * populationSize;
+	QSet< Creature > pendingOffsprings;   //Offsprings under evaluation, their clones are rejected as well
+
+	//Every worker pulls the next breed and evaluate step until the budget is used up, so no worker waits for the slowest pipeline
+	#pragma omp parallel
+	{
+		while ( true )
+		{
+			Creature offspring;
+			bool isStarted  = false;
+			bool isFinished = false;
+
+			#pragma omp critical( CentralAiPopulation )
+			{
+				if ( startedCount >= aEvaluationCount )
+				{
+					isFinished = true;
+				}
+				else
+				{
+					if ( attemptToCreateOffspringCount > attemptToCreateOffspringMax )
+					{
+						//Extreme the mutation rate
+						mMutationRate = 0.6;
+					}
+
+					auto parents = this->parents( mPopulation );
+					offspring    = this->offspring( parents.first, parents.second );
+
+					if ( !mTree->isValidPath( offspring ) )
+					{
+						qDebug() << "Error - Not valid offspring!";
+
+						std::exit( EXIT_SUCCESS );
+					}
+
+					if ( mPopulation.contains( offspring ) || pendingOffsprings.contains( offspring ) )  // Is Offspring a clone?
+					{
+						++attemptToCreateOffspringCount;
+					}
+					else
+					{
+						attemptToCreateOffspringCount = 0;
+						++startedCount;
+						pendingOffsprings.insert( offspring );
+						isStarted = true;
+					}
+				}
+			}
+
+			if ( isFinished )
+			{
+				break;
+			}
+
+			if ( !isStarted )
+			{
+				continue;
+			}
+
+			double fitness = calculateFitness( offspring, true );
+
+			//Merge the offspring immediately, it replaces the least fit creature
+			#pragma omp critical( CentralAiPopulation )
+			{
+				pendingOffsprings.remove( offspring );
+				mPopulation.insert( fitness, offspring );
+				mPopulation.truncate( populationSize );
+
+				++mergedCount;
+				if ( mMigrationChannel != nullptr && mergedCount % ( mMigrationInterval * populationSize ) == 0 )
+				{
+					migrate();
+				}
+
+				if ( checkpointEvaluationCount > 0 && mergedCount % checkpointEvaluationCount == 0 )
+				{
+					saveCheckpoint( mergedCount );
+				}
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void CentralAi::migrate()
+{
+	int populationSize = mPopulation.size();
+
+	//Send copies of the fittest creatures to the next island
+	Population emigrants;
+	for ( int i = 0; i < mMigrantCount && i < mPopulation.size(); ++i )
+	{
+		emigrants.insert( mPopulation.fitness( i ), mPopulation.creature( i ) );
+	}
+	mMigrationChannel->post( mIslandId, emigrants );
+
+	//Immigrants keep the fitness of their island, as the islands train on the same data, and replace the least fit creatures
+	auto immigrants = mMigrationChannel->immigrants( mIslandId );
+	for ( int i = 0; i < immigrants.size(); ++i )
+	{
+		if ( !mPopulation.contains( immigrants.creature( i ) ) )
+		{
+			mPopulation.insert( immigrants.fitness( i ), immigrants.creature( i ) );
+		}
+	}
+
+	mPopulation.truncate( populationSize );
+}
+
+//-----------------------------------------------------------------------------
 
-	for ( int i = 0; i < populationSize; ++i )
+Population CentralAi::race( const QVector< Creature >& aCandidates )
+{
+	QVector< Creature > survivors = aCandidates;
+
+	//Successive halving, every rung evaluates the survivors on a larger budget and promotes the best of them
+	for ( int rung = 0; rung < mRacingBudgets.size() && survivors.size() > 1; ++rung )
 	{
-		auto key   = mergedPopulation.keys().at( i );
-		auto value = mergedPopulation.values().at( i );
+		EvaluationBudget budget = mRacingBudgets.at( rung );
+
+		//All creatures of a rung see the same subsample
+		if ( budget.sampleFraction < 1.0 )
+		{
+			budget.trainingData = std::make_shared< lpmldata::DataPackage >( trainingSubsample( budget.sampleFraction ) );
+		}
 
-		mPopulation.insertMulti( key, value );
-	}	    	
+		int candidateCount = survivors.size();
+		QVector< double > fitnesses( candidateCount );
+
+		#pragma omp parallel for schedule( dynamic, 1 )
+		for ( int candidateIndex = 0; candidateIndex < candidateCount; ++candidateIndex )
+		{
+			fitnesses[ candidateIndex ] = calculateFitness( survivors.at( candidateIndex ), true, budget );
+		}
+
+		Population ranking;
+		for ( int candidateIndex = 0; candidateIndex < candidateCount; ++candidateIndex )
+		{
+			ranking.insert( fitnesses.at( candidateIndex ), survivors.at( candidateIndex ) );
+		}
+
+		int promotedCount = std::max( 1, int( std::ceil( candidateCount * mPromotionFraction ) ) );
+		survivors         = ranking.creatures().mid( 0, promotedCount );
+	}
+
+	//Only the promoted creatures get the full evaluation, their fitness is comparable with the population
+	int survivorCount = survivors.size();
+	QVector< double > fitnesses( survivorCount );
+
+	#pragma omp parallel for schedule( dynamic, 1 )
+	for ( int survivorIndex = 0; survivorIndex < survivorCount; ++survivorIndex )
+	{
+		fitnesses[ survivorIndex ] = calculateFitness( survivors.at( survivorIndex ), true );
+	}
+
+	Population offsprings;
+	for ( int survivorIndex = 0; survivorIndex < survivorCount; ++survivorIndex )
+	{
+		offsprings.insert( fitnesses.at( survivorIndex ), survivors.at( survivorIndex ) );
+	}
+
+	return offsprings;
+}
+
+//-----------------------------------------------------------------------------
+
+lpmldata::DataPackage CentralAi::trainingSubsample( double aFraction )
+{
+	const auto& LDB = mTrainingData.labelDatabase();
+	int labelIndex  = mTrainingData.activeLabelIndex();
+	auto keys       = mTrainingData.commonKeys();
+	keys.sort();
+
+	//The same fraction of every label group is kept, at least two samples of each
+	QMap< QString, QStringList > keysByLabel;
+	for ( auto& key : keys )
+	{
+		keysByLabel[ LDB.valueAt( key, labelIndex ).toString() ].push_back( key );
+	}
+
+	QStringList subsampleKeys;
+	for ( auto& labelKeys : keysByLabel )
+	{
+		std::shuffle( labelKeys.begin(), labelKeys.end(), *mRng );
+
+		int keptCount = std::min( labelKeys.size(), std::max( 2, int( std::ceil( labelKeys.size() * aFraction ) ) ) );
+		subsampleKeys.append( labelKeys.mid( 0, keptCount ) );
+	}
+
+	return lpmldata::DataPackage( mTrainingData.sampleDatabaseSubset( subsampleKeys ), mTrainingData.labelDatabaseSubset( subsampleKeys ) );
 }
 
 //-----------------------------------------------------------------------------
 
-double CentralAi::calculateFitness( Creature aCreature, bool aIsTraining )
+double CentralAi::calculateFitness( const Creature& aCreature, bool aIsTraining, const EvaluationBudget& aBudget )
 {
 	if ( aIsTraining )
 	{
-		auto pipelineModel     = new dkeval::PipelineModel( mSettings, aCreature, mTrainingData );
+		//Every evaluation works on its own copy of the training data, so creatures can be evaluated in parallel
+		lpmldata::DataPackage trainingData = aBudget.trainingData != nullptr ? *aBudget.trainingData : mTrainingData;
+
+		auto pipelineModel     = new dkeval::PipelineModel( mSettings, mTree->algorithmNames( aCreature ), trainingData );
 		pipelineModel->setFoldId( mFoldId );
+		pipelineModel->setTreeFraction( aBudget.treeFraction );
 
-		auto pipelineAnalytics = new dkeval::PipelineAnalytics( mSettings, &mTrainingData, pipelineModel );
+		auto pipelineAnalytics = new dkeval::PipelineAnalytics( mSettings, &trainingData, pipelineModel );
 		auto inputCount        = pipelineModel->inputCount(); //number of parameters
 
-		//Generate initial and scale vectors for NelderMeadOptimizer constructor arguments
-		QVector< double > init;
-		init.resize( inputCount );
-		init.fill( 0.0 );
-		init[ 0 ] = 1.0;
+		QString termination; //Why the Nelder-Mead search stopped
 
-		QVector< double > scale;
-		scale.resize( inputCount );
-		scale.fill( 10.0 );
-
-		//Optimize parameters with Nelder-Mead
-		auto optimizer = lpmleval::NelderMeadOptimizer( pipelineModel, pipelineAnalytics, init, scale, 0.00001, 100, true );		
-		optimizer.build();	
+		if ( mIsSurrogateSearch )
+		{
+			//The racing budgets scale the evaluations like the Nelder-Mead iterations
+			int evaluationCount = std::max( 2, int( std::ceil( mSurrogateEvaluationCount * std::min( 1.0, aBudget.iterationCount / double( aBudget.fullIterationCount ) ) ) ) );
+
+			//Optimize parameters with the surrogate model, the pipeline model is left in the best configuration
+			auto optimizer = lpmleval::SurrogateOptimizer( pipelineModel, pipelineAnalytics, evaluationCount );
+			optimizer.setInitialEvaluationCount( mSurrogateInitialCount );
+			optimizer.setBatchSize( mSurrogateBatchSize );
+			optimizer.setCandidateCount( mSurrogateCandidateCount );
+			optimizer.setGoodFraction( mSurrogateGoodFraction );
+			optimizer.build();
+		}
+		else
+		{
+			//Generate initial and scale vectors for NelderMeadOptimizer constructor arguments
+			QVector< double > init;
+			init.resize( inputCount );
+			init.fill( 0.0 );
+			init[ 0 ] = 1.0;
+
+			QVector< double > scale;
+			scale.resize( inputCount );
+			scale.fill( 10.0 );
+
+			//Optimize parameters with Nelder-Mead
+			auto optimizer = lpmleval::NelderMeadOptimizer( pipelineModel, pipelineAnalytics, init, scale, 0.00001, aBudget.iterationCount, true );		
+			optimizer.setEvaluationMode( mSimplexEvaluation );  //Falls back to serial when the creatures themselves are evaluated in parallel
+			optimizer.setStagnationIterationCount( mSimplexStagnationCount );
+			optimizer.setMaximumEvaluationCount( mSimplexMaxEvaluations );
+			optimizer.setTimeLimit( qint64( mSimplexTimeLimit * 1000.0 ) );
+			optimizer.setStopOnCollapse( mIsSimplexStopOnCollapse );  //Heuristic, a reflection or expansion may still leave the shared configuration
+			optimizer.build();	
+
+			termination = lpmleval::NelderMeadOptimizer::terminationName( optimizer.terminationCode() );
+		}
 
 		auto fitness = pipelineModel->fitness(); // ROC distance 	
 
@@ -126,51 +387,49 @@ double CentralAi::calculateFitness( Creature aCreature, bool aIsTraining )
 		}
 
 		
-		//Store fittest model information 		
-		if ( mPopulation.isEmpty() ) //initial creature evaluation 
+		//Store fittest model information, reduced budgets only rank the creatures of a race
+		bool isFittest = false;
+
+		#pragma omp critical( CentralAiPopulation )
 		{
-			if ( !mTBPAction.isEmpty() )
+			mSimplexLookupCount += pipelineModel->cacheLookupCount();
+			mSimplexHitCount    += pipelineModel->cacheHitCount();
+			if ( !termination.isEmpty() )
 			{
-				qDebug() << "Warning - mTBPAction is not empty in initialization!!!";
-
-				//Clear TBPAaction in CentralAI 
-				for ( auto& action : mTBPAction )
-				{
-					action = nullptr;
-				}
-				mTBPAction.clear();
+				++mSimplexTerminations[ termination ];
 			}
 
-			if ( fitness <= 0.1 )
+			if ( !aBudget.isFull() )
 			{
-				pipelineAnalytics->setDataPackage( &mTrainingData ); //Apply preprocessing steps	
-				mTBPAction = pipelineModel->dpactions(); //best pre-processing algorithm pipeline
-
-				dkeval::PreprocessedPackage preprocessedData;
-				preprocessedData.preprocessedDataPackage = pipelineAnalytics->preProcessedDataPackage();
-				preprocessedData.tbpActions              = mTBPAction;
-
-				mPreprocessedDatasets.push_back( preprocessedData );
-			}			
-		}
-		else if ( mPopulation.firstKey() == fitness || fitness < mPopulation.firstKey() )
-		{
-			//Clear TBPAaction in CentralAI 
-			for ( auto& action : mTBPAction )
+				isFittest = false;
+			}
+			else if ( mPopulation.isEmpty() ) //initial creature evaluation 
 			{
-				action = nullptr;
+				isFittest = fitness <= 0.1;
 			}
-			mTBPAction.clear();
+			else
+			{
+				isFittest = mPopulation.bestFitness() == fitness || fitness < mPopulation.bestFitness();
+			}
+		}
 
-			pipelineAnalytics->setDataPackage( &mTrainingData ); //Apply preprocessing steps	
-			mTBPAction = pipelineModel->dpactions(); //best pre-processing algorithm pipeline
+		if ( isFittest )
+		{
+			pipelineAnalytics->setDataPackage( &trainingData ); //Apply preprocessing steps	
 
 			dkeval::PreprocessedPackage preprocessedData;
 			preprocessedData.preprocessedDataPackage = pipelineAnalytics->preProcessedDataPackage();
-			preprocessedData.tbpActions = mTBPAction;
+			preprocessedData.tbpActions              = pipelineModel->dpactions();
+			preprocessedData.creature                = aCreature;
+			preprocessedData.fitness                 = fitness;
+			preprocessedData.configuration           = pipelineModel->discreteConfiguration();
 
-			mPreprocessedDatasets.push_back( preprocessedData );			
-		}	
+			#pragma omp critical( CentralAiPopulation )
+			{
+				mTBPAction = preprocessedData.tbpActions; //best pre-processing algorithm pipeline
+				mPreprocessedDatasets.push_back( preprocessedData );
+			}
+		}
 
 		delete pipelineModel;
 		delete pipelineAnalytics;
@@ -185,10 +444,10 @@ double CentralAi::calculateFitness( Creature aCreature, bool aIsTraining )
 
 //-----------------------------------------------------------------------------
 
-Creature CentralAi::offspring( Creature aParent_1, Creature aParent_2 )
+Creature CentralAi::offspring( const Creature& aParent_1, const Creature& aParent_2 )
 {
 	QString chosenParent;
-	Creature nodePath;
+	Creature path;
 
 	//Check if parents are valid
 	auto isValidParent_1 = mTree->isValidPath( aParent_1 );
@@ -201,84 +460,32 @@ Creature CentralAi::offspring( Creature aParent_1, Creature aParent_2 )
 		std::exit( EXIT_SUCCESS );
 	}	
 
-	auto root           = mTree->treeRoot();	
-	auto algorithms_1   = mTree->algorithmNames( aParent_1 );
-	auto algorithms_2   = mTree->algorithmNames( aParent_2 );	
-	auto siblings       = mTree->children( root );	
+	int state           = mTree->rootState();
 	int chromosomeIndex = 0;
 	
-	while ( true )
+	//A parent that already ended passes on the artificial leaf, so the offspring may end at the same length
+	while ( !mTree->childIds( state ).isEmpty() )
 	{
-		int momChromosomeIndex = aParent_1.size() > chromosomeIndex ? chromosomeIndex : -1;
-		int dadChromosomeIndex = aParent_2.size() > chromosomeIndex ? chromosomeIndex : -1;	
-		auto mom               = momChromosomeIndex == -1 ? nullptr : aParent_1.at( chromosomeIndex );
-		auto dad               = dadChromosomeIndex == -1 ? nullptr : aParent_2.at( chromosomeIndex );
-
-		if ( mom != nullptr || dad != nullptr )
-		{
-			std::shared_ptr< Node > offspringNode = nullptr;
-
-			if ( mom != nullptr && dad != nullptr )
-			{				
-				chosenParent = this->chooseParent();
-			}
-			else if ( mom != nullptr )
-			{
-				chosenParent = "Mom";
-			}
-			else if ( dad != nullptr )
-			{
-				chosenParent = "Dad";
-			}
-			else
-			{
-				qDebug() << "Impossible!";
-			}
+		int mom = aParent_1.size() > chromosomeIndex ? aParent_1.at( chromosomeIndex ) : mTree->leafId();
+		int dad = aParent_2.size() > chromosomeIndex ? aParent_2.at( chromosomeIndex ) : mTree->leafId();
 
+		chosenParent = mom == dad ? "Mom" : this->chooseParent();
 
-			if ( chosenParent == "Mom" )
-			{
-				offspringNode = mom;
-			}
-			else if ( chosenParent == "Dad" )
-			{
-				offspringNode = dad;
-			}	
+		int offspringId = chosenParent == "Mom" ? mom : dad;
+		offspringId     = mutate( offspringId, mTree->childIds( state ) );
 
-
-			offspringNode = mutate( offspringNode, siblings );			
-			nodePath.push_back( offspringNode );
-
-
-			if ( mTree->isLeaf( offspringNode ) )
-			{			
-				break;
-			}
-			else
-			{
-				siblings = mTree->children( offspringNode );
-			}					
+		if ( offspringId == mTree->leafId() ) //the artificial leaf ends the pipeline and is not stored
+		{
+			break;
 		}
-		else
-		{			
-			std::shared_ptr< Node > offspringNode = mutate( nullptr, siblings );
-			nodePath.push_back( offspringNode );			
 
-
-			if ( mTree->isLeaf( offspringNode ) )
-			{
-				break;
-			}
-			else
-			{
-				siblings = mTree->children( offspringNode );
-			}			
-		}				
+		path.push_back( offspringId );
+		state = mTree->nextState( state, offspringId );
 
 		++chromosomeIndex; 
 	}
 
-	return nodePath; 
+	return path; 
 }
 
 //-----------------------------------------------------------------------------
@@ -339,78 +546,33 @@ int CentralAi::randomIndex( int aListSize )
 
 //-----------------------------------------------------------------------------
 
-std::shared_ptr< Node > CentralAi::nodeIfAlgContains( QVector< std::shared_ptr< Node > >& aSiblings, std::shared_ptr< Node > aNode )
+int CentralAi::mutate( int aOffspringId, const QVector< int >& aSiblingIds )
 {
-	for ( auto sibling : aSiblings )
-	{
-		QString nodeName = aNode == nullptr ? "NA" : aNode->element;
-
-		if ( sibling->element == nodeName )
-		{
-			return sibling;
-		}
-	}
-
-	return nullptr;
-}
-
-//-----------------------------------------------------------------------------
-
-std::shared_ptr< Node > CentralAi::mutate( std::shared_ptr< Node > aOffspring, QVector< std::shared_ptr< Node > >& aSiblings )
-{
-	if ( aSiblings.isEmpty() )
+	if ( aSiblingIds.isEmpty() )
 	{
 		qDebug() << "Error - siblings is empty in mutate! ";
+
+		return -1;
 	}
 
 	auto mutationChance = randomPercentage();
+	auto offspringIndex = aSiblingIds.indexOf( aOffspringId );
 
-	if ( aOffspring == nullptr )
+	if ( offspringIndex < 0 ) //the inherited algorithm may not follow the pipeline of the offspring
 	{
-		auto index = randomIndex( aSiblings.size() );
+		auto index = randomIndex( aSiblingIds.size() );
 
-		return aSiblings.at( index );
+		return aSiblingIds.at( index );
 	}
-	else
-	{
-		auto nodeInSiblings = nodeIfAlgContains( aSiblings, aOffspring );
-
-		if ( nodeInSiblings == nullptr )
-		{
-			auto index = randomIndex( aSiblings.size() );
-
-			return aSiblings.at( index );
-		}
-
-		if ( mutationChance < mMutationRate )  // Mutation
-		{
-			QVector< std::shared_ptr< Node > > otherSiblings;
-			for ( auto sibling : aSiblings )
-			{
-				if ( sibling != nodeInSiblings )
-				{
-					otherSiblings.push_back( sibling );
-				}
-			}
 
-			if ( otherSiblings.isEmpty() )  // No other siblings.
-			{
-				return nodeInSiblings;
-			}
-			else
-			{
-				auto index = randomIndex( otherSiblings.size() );
+	if ( mutationChance < mMutationRate && aSiblingIds.size() > 1 )  // Mutation to one of the other siblings
+	{
+		auto index = randomIndex( aSiblingIds.size() - 1 );
 
-				return otherSiblings.at( index );
-			}
-		}
-		else
-		{
-			return nodeInSiblings;
-		}
+		return aSiblingIds.at( index < offspringIndex ? index : index + 1 );
 	}
 
-	return nullptr;
+	return aOffspringId;
 }
 
 //-----------------------------------------------------------------------------
@@ -441,7 +603,7 @@ void CentralAi::initializePopulation( const int& aNumberOfCreatures )
 
 		double fitness = calculateFitness( randomCreature, true );
 
-		mPopulation.insertMulti( fitness, randomCreature ); //insert into mPopulation directly
+		mPopulation.insert( fitness, randomCreature ); //insert into mPopulation directly
 	}
 }
 
@@ -450,30 +612,24 @@ void CentralAi::initializePopulation( const int& aNumberOfCreatures )
 QPair< Creature, Creature > CentralAi::parents( const Population& aPopulation )
 {
 	QPair< Creature, Creature > parents;
-	Population group_1;
-	Population group_2;
 
-	auto shuffledCreatures = aPopulation.values();
+	//The shuffled creatures are split into two alternating groups and the fittest of each group is a parent,
+	//the population is ordered by fitness, so the fittest creature of a group has the lowest index
+	QVector< int > shuffledIndices( aPopulation.size() );
+	std::iota( shuffledIndices.begin(), shuffledIndices.end(), 0 );
+	std::shuffle( shuffledIndices.begin(), shuffledIndices.end(), *mRng );
 
-	std::random_shuffle( shuffledCreatures.begin(), shuffledCreatures.end() );
+	int fittest_1 = aPopulation.size() - 1;
+	int fittest_2 = aPopulation.size() - 1;
 
-	for ( int i = 0; i < shuffledCreatures.size(); ++i )
+	for ( int i = 0; i < shuffledIndices.size(); ++i )
  	{
-		auto shuffledCreature = shuffledCreatures.at( i );
-		auto keyOfCreature    = aPopulation.key( shuffledCreature );
-
-		if ( i % 2 == 0 )
-		{
-			group_1.insertMulti( keyOfCreature, shuffledCreature );
-		}
-		else
-		{
-			group_2.insertMulti( keyOfCreature, shuffledCreature );
-		}
+		int& fittest = i % 2 == 0 ? fittest_1 : fittest_2;
+		fittest      = std::min( fittest, shuffledIndices.at( i ) );
 	}
 
-	parents.first  = group_1.values().at( 0 );
-	parents.second = group_2.values().at( 0 );
+	parents.first  = aPopulation.creature( fittest_1 );
+	parents.second = aPopulation.creature( fittest_2 );
 
 	return parents;
 }
@@ -494,6 +650,187 @@ lpmldata::DataPackage CentralAi::preProcessData( const lpmldata::DataPackage& aD
 
 //-----------------------------------------------------------------------------
 
+void CentralAi::saveCheckpoint( int aCompletedCount )
+{
+	if ( mCheckpointPath.isEmpty() || mCheckpointInterval == 0 )
+	{
+		return;
+	}
+
+	//The file replaces the previous checkpoint only when it is complete
+	QSaveFile file( mCheckpointPath );
+
+	if ( !file.open( QIODevice::WriteOnly ) )
+	{
+		qDebug() << "CentralAi - Error: Cannot open" << mCheckpointPath;
+		return;
+	}
+
+	QDataStream out( &file );
+	out.setVersion( QDataStream::Qt_5_12 );
+
+	std::ostringstream rngState;
+	rngState << *mRng;
+
+	out << quint32( CheckpointMagic ) << quint32( CheckpointVersion )
+		<< qint32( mFoldId ) << qint32( mIsSteadyState ) << qint32( mOffspringCount ) << qint32( mIterationCount )
+		<< qint32( aCompletedCount ) << mMutationRate
+		<< QByteArray::fromStdString( rngState.str() ) << mTree->rngState()
+		<< qint32( mSimplexLookupCount ) << qint32( mSimplexHitCount ) << mSimplexTerminations;
+
+	out << qint32( mPopulation.size() );
+	for ( int i = 0; i < mPopulation.size(); ++i )
+	{
+		out << mPopulation.fitness( i ) << mPopulation.creature( i );
+	}
+
+	out << qint32( mPreprocessedDatasets.size() );
+	for ( auto& preprocessedData : mPreprocessedDatasets )
+	{
+		out << preprocessedData.creature << preprocessedData.fitness << preprocessedData.configuration;
+	}
+
+	if ( out.status() != QDataStream::Ok || !file.commit() )
+	{
+		qDebug() << "CentralAi - Error: Cannot write" << mCheckpointPath;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool CentralAi::loadCheckpoint( int& aCompletedCount )
+{
+	QFile file( mCheckpointPath );
+
+	if ( mCheckpointPath.isEmpty() || !file.exists() || !file.open( QIODevice::ReadOnly ) )
+	{
+		return false;
+	}
+
+	QDataStream in( &file );
+	in.setVersion( QDataStream::Qt_5_12 );
+
+	quint32 magic;
+	quint32 version;
+	qint32 foldId;
+	qint32 isSteadyState;
+	qint32 offspringCount;
+	qint32 iterationCount;
+	qint32 completedCount;
+	double mutationRate;
+	QByteArray rngState;
+	QByteArray treeRngState;
+	qint32 simplexLookupCount;
+	qint32 simplexHitCount;
+	QMap< QString, int > simplexTerminations;
+
+	in >> magic >> version;
+	if ( in.status() != QDataStream::Ok || magic != CheckpointMagic || version != CheckpointVersion )
+	{
+		qDebug() << "CentralAi - Warning: Unknown checkpoint format, fold" << mFoldId << "starts anew";
+		return false;
+	}
+
+	in >> foldId >> isSteadyState >> offspringCount >> iterationCount >> completedCount >> mutationRate
+	   >> rngState >> treeRngState >> simplexLookupCount >> simplexHitCount >> simplexTerminations;
+
+	//A checkpoint of other settings would continue a different search
+	if ( foldId != mFoldId || bool( isSteadyState ) != mIsSteadyState || offspringCount != mOffspringCount || iterationCount != mIterationCount )
+	{
+		qDebug() << "CentralAi - Warning: The checkpoint does not match the settings, fold" << mFoldId << "starts anew";
+		return false;
+	}
+
+	Population population;
+	qint32 populationSize;
+	in >> populationSize;
+
+	for ( int i = 0; i < populationSize && in.status() == QDataStream::Ok; ++i )
+	{
+		double fitness;
+		Creature creature;
+		in >> fitness >> creature;
+
+		if ( !mTree->isValidPath( creature ) )
+		{
+			in.setStatus( QDataStream::ReadCorruptData );
+		}
+
+		population.insert( fitness, creature );
+	}
+
+	QVector< dkeval::PreprocessedPackage > descriptors;
+	qint32 descriptorCount;
+	in >> descriptorCount;
+
+	for ( int i = 0; i < descriptorCount && in.status() == QDataStream::Ok; ++i )
+	{
+		dkeval::PreprocessedPackage descriptor;
+		in >> descriptor.creature >> descriptor.fitness >> descriptor.configuration;
+		descriptors.push_back( descriptor );
+	}
+
+	if ( in.status() != QDataStream::Ok || population.isEmpty() )
+	{
+		qDebug() << "CentralAi - Warning: Corrupt checkpoint, fold" << mFoldId << "starts anew";
+		return false;
+	}
+
+	aCompletedCount      = completedCount;
+	mMutationRate        = mutationRate;
+	mSimplexLookupCount  = simplexLookupCount;
+	mSimplexHitCount     = simplexHitCount;
+	mSimplexTerminations = simplexTerminations;
+	mPopulation          = population;
+
+	std::istringstream rngStream( rngState.toStdString() );
+	rngStream >> *mRng;
+	mTree->setRngState( treeRngState );
+
+	//The fitted actions are not stored, the packages are rebuilt from their pipeline configurations
+	mPreprocessedDatasets.resize( descriptors.size() );
+
+	#pragma omp parallel for schedule( dynamic, 1 )
+	for ( int descriptorIndex = 0; descriptorIndex < descriptors.size(); ++descriptorIndex )
+	{
+		mPreprocessedDatasets[ descriptorIndex ] = rebuildPreprocessedPackage( descriptors.at( descriptorIndex ) );
+	}
+
+	if ( !mPreprocessedDatasets.isEmpty() )
+	{
+		mTBPAction = mPreprocessedDatasets.last().tbpActions;
+	}
+
+	qInfo() << "Fold:" << mFoldId << "resumed after" << completedCount << ( mIsSteadyState ? "evaluations" : "generations" );
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+dkeval::PreprocessedPackage CentralAi::rebuildPreprocessedPackage( const dkeval::PreprocessedPackage& aDescriptor )
+{
+	lpmldata::DataPackage trainingData = mTrainingData;
+
+	auto pipelineModel = new dkeval::PipelineModel( mSettings, mTree->algorithmNames( aDescriptor.creature ), trainingData );
+	pipelineModel->setFoldId( mFoldId );
+	pipelineModel->setDiscrete( aDescriptor.configuration );
+
+	auto pipelineAnalytics = new dkeval::PipelineAnalytics( mSettings, &trainingData, pipelineModel );
+	pipelineAnalytics->setDataPackage( &trainingData ); //Apply preprocessing steps
+
+	dkeval::PreprocessedPackage preprocessedData = aDescriptor;
+	preprocessedData.preprocessedDataPackage     = pipelineAnalytics->preProcessedDataPackage();
+	preprocessedData.tbpActions                  = pipelineModel->dpactions();
+
+	delete pipelineModel;
+	delete pipelineAnalytics;
+
+	return preprocessedData;
+}
+
+//-----------------------------------------------------------------------------
+
 void CentralAi::saveFoldAt( QString aFoldPath )
 {
 	lpmlfio::TabularDataFileIo fileIo;	
@@ -502,6 +839,28 @@ void CentralAi::saveFoldAt( QString aFoldPath )
 	fileIo.save( aFoldPath + "/TLD.csv", mPreprocessedDataPackage.labelDatabase() );
 	fileIo.save( aFoldPath + "/VDS.csv", mValidationData.featureDatabase() );
 	fileIo.save( aFoldPath + "/VLD.csv", mValidationData.labelDatabase() );
+
+	//Store the fitted PCA transforms so they can be reapplied in an inference pipeline, PCA-<step>.bin by the 1-based step of the pipeline
+	for ( int step = 0; step < mTBPAction.size(); ++step )
+	{
+		auto pca = std::dynamic_pointer_cast< dkeval::PCA >( mTBPAction.at( step ) );
+
+		if ( pca != nullptr && pca->isFitted() )
+		{
+			QFile file( aFoldPath + "/PCA-" + QString::number( step + 1 ) + ".bin" );
+
+			if ( file.open( QIODevice::WriteOnly ) )
+			{
+				QDataStream out( &file );
+				pca->save( out );
+				file.close();
+			}
+			else
+			{
+				qDebug() << "CentralAi - Error: Cannot open" << file.fileName();
+			}
+		}
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -549,7 +908,16 @@ void CentralAi::savePipelineInfo( QString aFoldPath, QString aFileName )
 		textFile << QString::number( counter ).toStdString() << "->" << action->id().toStdString() << "\n";
 		counter++;
 	}
+	textFile << "\n";
 
+	textFile << "Pipeline cache hits: " << mSimplexHitCount << " of " << mSimplexLookupCount << " steps";
+	textFile << "\n";
+
+	for ( auto termination = mSimplexTerminations.constBegin(); termination != mSimplexTerminations.constEnd(); ++termination )
+	{
+		textFile << "Nelder-Mead " << termination.key().toStdString() << ": " << termination.value();
+		textFile << "\n";
+	}
 
 	textFile.close();
 }
@@ -648,9 +1016,9 @@ void CentralAi::evaluatePopulation()
 		{
 			for ( auto action : pipeline )
 			{
-				if ( action->id() == "FS" || action->id() == "PCA" )
+				if ( action->id() == "FS" || action->id() == "PCA" || action->id() == "CP" )
 				{
-					validationData = action->run( mValidationData );
+					validationData = action->run( validationData );
 				}
 			}
 		}
@@ -20,12 +20,18 @@
 #include <Evaluation/PCA.h>
 #include <Evaluation/IsolationForest.h>
 #include <Evaluation/Undersampling.h>
+#include <Evaluation/CorrelationPruning.h>
 #include <Evaluation/ConfusionMatrixAnalytics.h>
 #include <Evaluation/RandomForestModel.h>
 #include <Evaluation/RandomForestOptimizer.h>
+#include <Evaluation/NelderMeadOptimizer.h>
+#include <Evaluation/SurrogateOptimizer.h>
 #include <Evaluation/PatientFoldGenerator.h>
 #include <Evaluation/CMAnalytics.h>
 #include <FileIo/TabularDataFileIo.h>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
 #include <random>
 #include <fstream>
 
@@ -35,12 +41,141 @@ namespace dkeval
 
 //-----------------------------------------------------------------------------
 
-typedef QMap< double, Creature > Population;
+//Header of the binary fold checkpoints
+const quint32 CheckpointMagic   = 0x4d4c4450; //"MLDP"
+const quint32 CheckpointVersion = 1;
+
+/*!
+* \brief Creatures ordered by ascending fitness (best first), with a hash of the members for constant time clone detection
+*/
+class Population
+{
+
+public:
+
+	/*!
+	* \brief Inserts the creature before the creatures of equal fitness
+	*/
+	void insert( double aFitness, const Creature& aCreature )
+	{
+		auto position = std::lower_bound( mFitnesses.begin(), mFitnesses.end(), aFitness );
+		int index     = int( position - mFitnesses.begin() );
+
+		mFitnesses.insert( index, aFitness );
+		mCreatures.insert( index, aCreature );
+		++mCounts[ aCreature ];
+	}
+
+	/*!
+	* \brief Keeps the aSize fittest creatures
+	*/
+	void truncate( int aSize )
+	{
+		while ( mCreatures.size() > aSize )
+		{
+			auto count = mCounts.find( mCreatures.last() );
+			if ( --count.value() == 0 )
+			{
+				mCounts.erase( count );
+			}
+
+			mFitnesses.removeLast();
+			mCreatures.removeLast();
+		}
+	}
+
+	void clear() { mFitnesses.clear(); mCreatures.clear(); mCounts.clear(); }
+
+	bool contains( const Creature& aCreature ) const { return mCounts.contains( aCreature ); }
+	int size() const { return mCreatures.size(); }
+	bool isEmpty() const { return mCreatures.isEmpty(); }
+	double fitness( int aIndex ) const { return mFitnesses.at( aIndex ); }
+	const Creature& creature( int aIndex ) const { return mCreatures.at( aIndex ); }
+	const QVector< Creature >& creatures() const { return mCreatures; }
+	double bestFitness() const { return mFitnesses.first(); }
+
+private:
+
+	QVector< double > mFitnesses;
+	QVector< Creature > mCreatures;
+	QHash< Creature, int > mCounts;  //!< Number of copies of each member
+};
+
+/*!
+* \brief Exchange of the best creatures between the island populations of a run, the islands form a ring and every island receives the emigrants of its predecessor
+* \details The islands neither wait for each other nor for the emigrants, an island takes the latest post of its predecessor whenever it migrates.
+*/
+class MigrationChannel
+{
+
+public:
+
+	/*!
+	* \brief Constructor
+	* \param [in] aIslandCount Number of the islands in the ring
+	*/
+	MigrationChannel( int aIslandCount ) : mEmigrants( std::max( aIslandCount, 1 ) ) {}
+
+	/*!
+	* \brief Replaces the emigrants of the island
+	*/
+	void post( int aIslandId, const Population& aEmigrants )
+	{
+		#pragma omp critical( CentralAiMigration )
+		{
+			mEmigrants[ aIslandId ] = aEmigrants;
+		}
+	}
+
+	/*!
+	* \brief Latest emigrants of the predecessor of the island, empty until the predecessor posts
+	*/
+	Population immigrants( int aIslandId ) const
+	{
+		Population immigrants;
+
+		#pragma omp critical( CentralAiMigration )
+		{
+			immigrants = mEmigrants.at( ( aIslandId + mEmigrants.size() - 1 ) % mEmigrants.size() );
+		}
+
+		return immigrants;
+	}
+
+	int islandCount() const { return mEmigrants.size(); }
+
+private:
+
+	QVector< Population > mEmigrants;  //!< Latest emigrants of each island
+};
 
 struct PreprocessedPackage
 {
+	PreprocessedPackage() : tbpActions(), preprocessedDataPackage(), creature(), fitness( 0.0 ), configuration() {}
+
 	QVector< std::shared_ptr< dkeval::AbstractTBPAction > > tbpActions;
 	std::shared_ptr < lpmldata::DataPackage > preprocessedDataPackage;
+
+	//Descriptor of the package, a checkpoint stores only these and a resumed run rebuilds the package from them
+	Creature creature;
+	double fitness;
+	QVector< int > configuration;  //!< PipelineModel::discreteConfiguration()
+};
+
+/*!
+* \brief Resources of one creature evaluation, the default is the full evaluation
+*/
+struct EvaluationBudget
+{
+	explicit EvaluationBudget( int aFullIterationCount = 0 ) : iterationCount( aFullIterationCount ), fullIterationCount( aFullIterationCount ), treeFraction( 1.0 ), sampleFraction( 1.0 ), trainingData() {}
+
+	bool isFull() const { return iterationCount >= fullIterationCount && treeFraction >= 1.0 && trainingData == nullptr; }
+
+	int iterationCount;                                              //!< Nelder-Mead iterations
+	int fullIterationCount;                                          //!< Nelder-Mead iterations of the full evaluation, CentralAi/simplexIterationCount
+	double treeFraction;                                             //!< Fraction of Optimizer/NumberOfTrees
+	double sampleFraction;                                           //!< Fraction of the training samples per label group
+	std::shared_ptr< const lpmldata::DataPackage > trainingData;     //!< The subsample the creatures of a racing rung are evaluated on, all training data if nullptr
 };
 
 //-----------------------------------------------------------------------------
@@ -66,6 +201,32 @@ public:
 		mOffspringCount(),
 		mMutationRate(),
 		mIterationCount( 0 ),
+		mIsSteadyState( false ),
+		mIsRacing( false ),
+		mRacingBudgets(),
+		mPromotionFraction( 1.0 ),
+		mSimplexEvaluation( lpmleval::NelderMeadOptimizer::EvaluationMode::Serial ),
+		mSimplexLookupCount( 0 ),
+		mSimplexHitCount( 0 ),
+		mSimplexIterationCount( 100 ),
+		mSimplexStagnationCount( 0 ),
+		mSimplexMaxEvaluations( 0 ),
+		mSimplexTimeLimit( 0 ),
+		mIsSimplexStopOnCollapse( false ),
+		mSimplexTerminations(),
+		mIsSurrogateSearch( false ),
+		mSurrogateEvaluationCount( 30 ),
+		mSurrogateInitialCount( 8 ),
+		mSurrogateBatchSize( 4 ),
+		mSurrogateCandidateCount( 64 ),
+		mSurrogateGoodFraction( 0.25 ),
+		mCheckpointInterval( 1 ),
+		mCheckpointPath(),
+		mIsResumed( false ),
+		mMigrationChannel(),
+		mIslandId( 0 ),
+		mMigrationInterval( 5 ),
+		mMigrantCount( 1 ),
 		mPopulation(),
 		mTrainingData( aTrainingData ),
 		mValidationData( aValidationData ),
@@ -107,6 +268,160 @@ public:
 				qDebug() << "CentralAi - Error: Invalid parameter iterationCount";
 				mIsInitValid = false;
 			}
+
+			//Optional, the population is iterated generation by generation by default
+			auto mode = mSettings->value( "CentralAi/mode", "generational" ).toString();
+			if ( mode != "generational" && mode != "steadyState" )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter mode";
+				mIsInitValid = false;
+			}
+			mIsSteadyState = mode == "steadyState";
+
+			//Optional, the offsprings of a generation are raced on growing budgets and only the best are evaluated fully
+			auto evaluation = mSettings->value( "CentralAi/evaluation", "full" ).toString();
+			if ( evaluation != "full" && evaluation != "racing" )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter evaluation";
+				mIsInitValid = false;
+			}
+			mIsRacing = evaluation == "racing";
+
+			//Optional, the Nelder-Mead vertices of a creature are evaluated on cloned pipelines in parallel
+			auto simplexEvaluation = mSettings->value( "CentralAi/simplexEvaluation", "serial" ).toString();
+			if ( simplexEvaluation == "parallel" )
+			{
+				mSimplexEvaluation = lpmleval::NelderMeadOptimizer::EvaluationMode::Parallel;
+			}
+			else if ( simplexEvaluation == "speculative" )
+			{
+				mSimplexEvaluation = lpmleval::NelderMeadOptimizer::EvaluationMode::Speculative;
+			}
+			else if ( simplexEvaluation != "serial" )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter simplexEvaluation";
+				mIsInitValid = false;
+			}
+
+			//Optional, the Nelder-Mead iteration maximum of the full evaluation
+			bool isSimplexIterationCount;
+			mSimplexIterationCount = mSettings->value( "CentralAi/simplexIterationCount", 100 ).toInt( &isSimplexIterationCount );
+			if ( !isSimplexIterationCount || mSimplexIterationCount < 1 )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter simplexIterationCount";
+				mIsInitValid = false;
+			}
+
+			//Optional Nelder-Mead budgets, 0 disables them
+			bool isSimplexStagnationCount;
+			bool isSimplexMaxEvaluations;
+			bool isSimplexTimeLimit;
+			mSimplexStagnationCount = mSettings->value( "CentralAi/simplexStagnation", 0 ).toInt( &isSimplexStagnationCount );
+			mSimplexMaxEvaluations  = mSettings->value( "CentralAi/simplexMaxEvaluations", 0 ).toInt( &isSimplexMaxEvaluations );
+			mSimplexTimeLimit       = mSettings->value( "CentralAi/simplexTimeLimit", 0.0 ).toDouble( &isSimplexTimeLimit );
+
+			if ( !isSimplexStagnationCount || mSimplexStagnationCount < 0 || !isSimplexMaxEvaluations || mSimplexMaxEvaluations < 0 || !isSimplexTimeLimit || mSimplexTimeLimit < 0.0 )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter simplexStagnation, simplexMaxEvaluations or simplexTimeLimit";
+				mIsInitValid = false;
+			}
+
+			//Optional, stops Nelder-Mead once all vertices select the same discrete configuration
+			mIsSimplexStopOnCollapse = mSettings->value( "CentralAi/simplexStopOnCollapse", false ).toBool();
+
+			//Optional, the hyperparameters of a creature are searched with a surrogate model instead of Nelder-Mead
+			auto search = mSettings->value( "CentralAi/search", "nelderMead" ).toString();
+			if ( search != "nelderMead" && search != "surrogate" )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter search";
+				mIsInitValid = false;
+			}
+			mIsSurrogateSearch = search == "surrogate";
+
+			if ( mIsSurrogateSearch )
+			{
+				bool isEvaluationCount;
+				bool isInitialCount;
+				bool isBatchSize;
+				bool isCandidateCount;
+				bool isGoodFraction;
+				mSurrogateEvaluationCount = mSettings->value( "Surrogate/evaluationCount" ).toInt( &isEvaluationCount );
+				mSurrogateInitialCount    = mSettings->value( "Surrogate/initialCount" ).toInt( &isInitialCount );
+				mSurrogateBatchSize       = mSettings->value( "Surrogate/batchSize" ).toInt( &isBatchSize );
+				mSurrogateCandidateCount  = mSettings->value( "Surrogate/candidateCount" ).toInt( &isCandidateCount );
+				mSurrogateGoodFraction    = mSettings->value( "Surrogate/goodFraction" ).toDouble( &isGoodFraction );
+
+				if ( !isEvaluationCount || mSurrogateEvaluationCount < 1 || !isInitialCount || mSurrogateInitialCount < 1 || !isBatchSize || mSurrogateBatchSize < 1 ||
+					 !isCandidateCount || mSurrogateCandidateCount < 1 || !isGoodFraction || mSurrogateGoodFraction <= 0.0 || mSurrogateGoodFraction >= 1.0 )
+				{
+					qDebug() << "CentralAi - Error: Invalid Surrogate parameters";
+					mIsInitValid = false;
+				}
+			}
+
+			//Optional, generations between the checkpoints of a fold, 0 disables them
+			bool isCheckpointInterval;
+			mCheckpointInterval = mSettings->value( "CentralAi/checkpointInterval", 1 ).toInt( &isCheckpointInterval );
+			if ( !isCheckpointInterval || mCheckpointInterval < 0 )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter checkpointInterval";
+				mIsInitValid = false;
+			}
+
+			//Optional, only used when the population is an island of a run, see setIsland()
+			bool isMigrationInterval;
+			bool isMigrantCount;
+			mMigrationInterval = mSettings->value( "Island/migrationInterval", 5 ).toInt( &isMigrationInterval );
+			mMigrantCount      = mSettings->value( "Island/migrantCount", 1 ).toInt( &isMigrantCount );
+			if ( !isMigrationInterval || mMigrationInterval < 1 || !isMigrantCount || mMigrantCount < 1 )
+			{
+				qDebug() << "CentralAi - Error: Invalid parameter migrationInterval or migrantCount";
+				mIsInitValid = false;
+			}
+
+			if ( mIsRacing )
+			{
+				auto iterationCounts = mSettings->value( "Racing/iterationCounts" ).toStringList();
+				auto treeFractions   = mSettings->value( "Racing/treeFractions" ).toStringList();
+				auto sampleFractions = mSettings->value( "Racing/sampleFractions" ).toStringList();
+
+				if ( iterationCounts.isEmpty() || treeFractions.size() != iterationCounts.size() || sampleFractions.size() != iterationCounts.size() )
+				{
+					qDebug() << "CentralAi - Error: Racing/iterationCounts, Racing/treeFractions and Racing/sampleFractions must list the same number of rungs";
+					mIsInitValid = false;
+				}
+				else
+				{
+					for ( int rung = 0; rung < iterationCounts.size(); ++rung )
+					{
+						bool isIterationCount;
+						bool isTreeFraction;
+						bool isSampleFraction;
+
+						EvaluationBudget budget( mSimplexIterationCount );
+						budget.iterationCount = iterationCounts.at( rung ).trimmed().toInt( &isIterationCount );
+						budget.treeFraction   = treeFractions.at( rung ).trimmed().toDouble( &isTreeFraction );
+						budget.sampleFraction = sampleFractions.at( rung ).trimmed().toDouble( &isSampleFraction );
+
+						if ( !isIterationCount || budget.iterationCount < 1 || !isTreeFraction || budget.treeFraction <= 0.0 || budget.treeFraction > 1.0 ||
+							 !isSampleFraction || budget.sampleFraction <= 0.0 || budget.sampleFraction > 1.0 )
+						{
+							qDebug() << "CentralAi - Error: Invalid racing rung" << rung;
+							mIsInitValid = false;
+						}
+
+						mRacingBudgets.push_back( budget );
+					}
+				}
+
+				bool isPromotionFraction;
+				mPromotionFraction = mSettings->value( "Racing/promotionFraction" ).toDouble( &isPromotionFraction );
+				if ( !isPromotionFraction || mPromotionFraction <= 0.0 || mPromotionFraction > 1.0 )
+				{
+					qDebug() << "CentralAi - Error: Invalid parameter promotionFraction";
+					mIsInitValid = false;
+				}
+			}
 		}		
 
 		mTree = new dkeval::PipelineTree( aSettings );
@@ -161,21 +476,47 @@ public:
 	*/
 	void setFoldId( const int& aFoldId ) { mFoldId = aFoldId; };
 
+	/*!
+	* \brief Set the checkpoint file of the fold, the population is saved to it every CentralAi/checkpointInterval generations
+	* \param [in] aCheckpointPath The path of the checkpoint file
+	* \param [in] aIsResumed If true, execute() continues from the checkpoint when it exists
+	*/
+	void setCheckpoint( const QString& aCheckpointPath, bool aIsResumed ) { mCheckpointPath = aCheckpointPath; mIsResumed = aIsResumed; }
+
+	/*!
+	* \brief Makes the population an island of a run, it exchanges its best creatures over the channel every Island/migrationInterval generations
+	* \param [in] aMigrationChannel The channel shared by the islands of the run
+	* \param [in] aIslandId The index of the island in the ring
+	*/
+	void setIsland( std::shared_ptr< MigrationChannel > aMigrationChannel, int aIslandId ) { mMigrationChannel = aMigrationChannel; mIslandId = aIslandId; }
+
+	/*!
+	* \brief Get the validation ROC distance of the selected pipeline, valid after execute()
+	*/
+	double roc() const { return mROC; }
+
 private:
 	
 	CentralAi();
 	void iteratePopulation();
-	Creature offspring( Creature aParent_1, Creature aParent_2 );
+	void iterateSteadyState( int aEvaluationCount, int aCompletedCount );
+	Population race( const QVector< Creature >& aCandidates );
+	lpmldata::DataPackage trainingSubsample( double aFraction );
+	Creature offspring( const Creature& aParent_1, const Creature& aParent_2 );
 	QString chooseParent();
 	QString chooseChild( QList< QString >& aChildren );	
-	std::shared_ptr< Node > mutate( std::shared_ptr< Node > aOffspring, QVector< std::shared_ptr< Node > >& aSiblings );
+	int mutate( int aOffspringId, const QVector< int >& aSiblingIds );
 	void removeIfContains( QList< QString >& aList, QString aElement );
-	std::shared_ptr< Node > nodeIfAlgContains( QVector< std::shared_ptr< Node > >& aSiblings, std::shared_ptr< Node > aNode );
 	void initializePopulation( const int& aNumberOfCreatures );
 	QPair < Creature, Creature > parents( const Population& aPopulation );
-	double calculateFitness( Creature aCreature, bool aIsTraining );
+	double calculateFitness( const Creature& aCreature, bool aIsTraining ) { return calculateFitness( aCreature, aIsTraining, EvaluationBudget( mSimplexIterationCount ) ); }
+	double calculateFitness( const Creature& aCreature, bool aIsTraining, const EvaluationBudget& aBudget );
 	lpmldata::DataPackage preProcessData( const lpmldata::DataPackage& aData );
 	void evaluatePopulation();
+	void migrate();
+	void saveCheckpoint( int aCompletedCount );
+	bool loadCheckpoint( int& aCompletedCount );
+	dkeval::PreprocessedPackage rebuildPreprocessedPackage( const dkeval::PreprocessedPackage& aDescriptor );
 	int randomIndex( int aListSize );
 	double randomPercentage();
 
@@ -189,6 +530,32 @@ private:
 	int mOffspringCount;
 	double mMutationRate;
 	int mIterationCount;
+	bool mIsSteadyState;
+	bool mIsRacing;
+	QVector< EvaluationBudget > mRacingBudgets;
+	double mPromotionFraction;
+	lpmleval::NelderMeadOptimizer::EvaluationMode mSimplexEvaluation;
+	int mSimplexLookupCount;  //Nelder-Mead steps of all creature evaluations
+	int mSimplexHitCount;     //Nelder-Mead steps that revisited an already built configuration
+	int mSimplexIterationCount;  //Nelder-Mead iterations of the full creature evaluation
+	int mSimplexStagnationCount;
+	int mSimplexMaxEvaluations;
+	double mSimplexTimeLimit;  //Seconds per creature evaluation
+	bool mIsSimplexStopOnCollapse;
+	QMap< QString, int > mSimplexTerminations;  //Number of Nelder-Mead runs per termination reason
+	bool mIsSurrogateSearch;
+	int mSurrogateEvaluationCount;
+	int mSurrogateInitialCount;
+	int mSurrogateBatchSize;
+	int mSurrogateCandidateCount;
+	double mSurrogateGoodFraction;
+	int mCheckpointInterval;
+	QString mCheckpointPath;
+	bool mIsResumed;
+	std::shared_ptr< MigrationChannel > mMigrationChannel;  //Null if the population is not an island
+	int mIslandId;
+	int mMigrationInterval;
+	int mMigrantCount;
 	Population mPopulation;
 	lpmldata::DataPackage mTrainingData;
 	lpmldata::DataPackage mValidationData;
@@ -0,0 +1,259 @@
+#include <Evaluation/CorrelationPruning.h>
+#include <DataRepresentation/DistanceKernels.h>
+#include <algorithm>
+#include <cmath>
+
+namespace dkeval
+{
+
+namespace
+{
+	const int kBlockSize = 64;  // Kept features compared at once against the remaining ones.
+}
+
+//-----------------------------------------------------------------------------
+
+void CorrelationPruning::build( const lpmldata::DataPackage& aDataPackage )
+{
+	mSelectedFeatures.clear();
+
+	auto commonKeys  = aDataPackage.commonKeys();
+	const auto& FDB  = aDataPackage.featureDatabase();
+	auto headers     = FDB.headerNames();
+	int sampleCount  = commonKeys.size();
+	int featureCount = FDB.columnCount();
+
+	lpmldata::Array2D< double > rows( sampleCount, featureCount, lpmldata::Array2DLayout::RowMajor );
+
+	#pragma omp parallel for schedule( static )
+	for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		const QVariantList& values = FDB.table().constFind( commonKeys.at( sampleIndex ) ).value();
+		double* row                = rows.data() + ulint( sampleIndex ) * featureCount;
+
+		for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+		{
+			row[ featureIndex ] = featureIndex < values.size() ? values.at( featureIndex ).toDouble() : 0.0;
+		}
+	}
+
+	auto redundant = redundantColumns( rows, mIsLocal ? categoryGroups( headers ) : QVector< int >(), mThreshold );
+
+	for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+	{
+		if ( !redundant.at( featureIndex ) )
+		{
+			mSelectedFeatures.push_back( headers.at( featureIndex ) );
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+lpmldata::DataPackage CorrelationPruning::run( const lpmldata::DataPackage& aDataPackage )
+{
+	if ( !mIsInitValid )
+	{
+		lpmldata::DataPackage result( aDataPackage.featureDatabase(), aDataPackage.labelDatabase() );
+		return result;
+	}
+
+	lpmldata::TabularData updatedFDB = aDataPackage.featureDatabaseSubset( mSelectedFeatures );
+
+	lpmldata::DataPackage result( updatedFDB, aDataPackage.labelDatabase() );
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< bool > CorrelationPruning::redundantColumns( const lpmldata::Array2D< double >& aRows, const QVector< int >& aGroups, double aThreshold )
+{
+	int sampleCount  = aRows.rowCount();
+	int featureCount = aRows.columnCount();
+	QVector< bool > redundant( featureCount, false );
+
+	if ( sampleCount < 2 || featureCount < 2 )
+	{
+		return redundant;
+	}
+
+	// Centered columns stored contiguously, the correlation of two columns is their cosine similarity.
+	auto columns = aRows.clone( lpmldata::Array2DLayout::ColumnMajor );
+	QVector< double > deviations( featureCount, 0.0 );
+
+	#pragma omp parallel for schedule( static )
+	for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+	{
+		double* column = columns.data() + ulint( featureIndex ) * sampleCount;
+
+		double mean = 0.0;
+		for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+		{
+			mean += column[ sampleIndex ];
+		}
+		mean /= sampleCount;
+
+		double squares = 0.0;
+		for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+		{
+			column[ sampleIndex ] -= mean;
+			squares += column[ sampleIndex ] * column[ sampleIndex ];
+		}
+
+		deviations[ featureIndex ] = std::sqrt( squares / sampleCount );
+	}
+
+	auto isCorrelated = [ & ]( int aFirst, int aSecond )
+	{
+		// Constant columns have a cosine distance of 1, so they never correlate.
+		double distance = lpmldata::DistanceKernels::cosine( columns.data() + ulint( aFirst ) * sampleCount, columns.data() + ulint( aSecond ) * sampleCount, sampleCount );
+		return std::abs( 1.0 - distance ) > aThreshold;
+	};
+
+	// Columns by group, within a group by decreasing deviation, so each kept column is compared only with later ones.
+	QVector< int > order( featureCount );
+	for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+	{
+		order[ featureIndex ] = featureIndex;
+	}
+
+	// Columns with missing values have a NaN deviation, they are ordered last so the comparison stays a strict weak ordering.
+	QVector< double > sortDeviations( featureCount );
+	for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
+	{
+		sortDeviations[ featureIndex ] = std::isfinite( deviations.at( featureIndex ) ) ? deviations.at( featureIndex ) : -1.0;
+	}
+
+	bool isGrouped = aGroups.size() == featureCount;
+	std::sort( order.begin(), order.end(), [ & ]( int aFirst, int aSecond )
+	{
+		int firstGroup  = isGrouped ? aGroups.at( aFirst ) : 0;
+		int secondGroup = isGrouped ? aGroups.at( aSecond ) : 0;
+
+		if ( firstGroup != secondGroup ) return firstGroup < secondGroup;
+		if ( sortDeviations.at( aFirst ) != sortDeviations.at( aSecond ) ) return sortDeviations.at( aFirst ) > sortDeviations.at( aSecond );
+		return aFirst < aSecond;
+	} );
+
+	for ( int groupBegin = 0; groupBegin < featureCount; )
+	{
+		int groupEnd = groupBegin + 1;
+		while ( groupEnd < featureCount && ( !isGrouped || aGroups.at( order.at( groupEnd ) ) == aGroups.at( order.at( groupBegin ) ) ) )
+		{
+			++groupEnd;
+		}
+
+		// Columns of the group not yet decided, the processed blocks and the redundant columns are dropped after each block.
+		QVector< int > remaining = order.mid( groupBegin, groupEnd - groupBegin );
+
+		while ( !remaining.isEmpty() )
+		{
+			int blockSize = std::min( kBlockSize, remaining.size() );
+
+			// Inside the block the columns are decided in order.
+			QVector< int > kept;
+			for ( int position = 0; position < blockSize; ++position )
+			{
+				int column = remaining.at( position );
+
+				bool isRedundant = false;
+				for ( int keptColumn : kept )
+				{
+					if ( isCorrelated( keptColumn, column ) )
+					{
+						isRedundant = true;
+						break;
+					}
+				}
+
+				if ( isRedundant )
+				{
+					redundant[ column ] = true;
+				}
+				else
+				{
+					kept.push_back( column );
+				}
+			}
+
+			// The rest of the group against the kept columns of the block, a column is done at its first correlation.
+			int restCount = remaining.size() - blockSize;
+			QVector< char > isRestRedundant( restCount, 0 );
+
+			#pragma omp parallel for schedule( dynamic, 16 )
+			for ( int restIndex = 0; restIndex < restCount; ++restIndex )
+			{
+				int column = remaining.at( blockSize + restIndex );
+
+				for ( int keptColumn : kept )
+				{
+					if ( isCorrelated( keptColumn, column ) )
+					{
+						isRestRedundant[ restIndex ] = 1;
+						break;
+					}
+				}
+			}
+
+			QVector< int > rest;
+			rest.reserve( restCount );
+			for ( int restIndex = 0; restIndex < restCount; ++restIndex )
+			{
+				int column = remaining.at( blockSize + restIndex );
+
+				if ( isRestRedundant.at( restIndex ) )
+				{
+					redundant[ column ] = true;
+				}
+				else
+				{
+					rest.push_back( column );
+				}
+			}
+
+			remaining = rest;
+		}
+
+		groupBegin = groupEnd;
+	}
+
+	return redundant;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< int > CorrelationPruning::categoryGroups( const QStringList& aFeatureNames )
+{
+	// The names are parsed once, modalities and categories are interned to ids.
+	QHash< QString, int > modalities;
+	QHash< QString, int > categories;
+	QHash< quint64, int > groupIds;
+
+	QVector< int > groups;
+	groups.reserve( aFeatureNames.size() );
+
+	for ( auto& featureName : aFeatureNames )
+	{
+		auto parts       = featureName.split( "::" );
+		QString modality = parts.at( 0 );
+		QString category = parts.size() > 1 ? parts.at( 1 ) : QString();
+
+		int modalityId = modalities.value( modality, modalities.size() );
+		modalities.insert( modality, modalityId );
+
+		int categoryId = categories.value( category, categories.size() );
+		categories.insert( category, categoryId );
+
+		quint64 pair = ( quint64( modalityId ) << 32 ) | quint64( categoryId );
+		int groupId  = groupIds.value( pair, groupIds.size() );
+		groupIds.insert( pair, groupId );
+
+		groups.push_back( groupId );
+	}
+
+	return groups;
+}
+
+//-----------------------------------------------------------------------------
+
+}
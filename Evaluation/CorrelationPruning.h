@@ -0,0 +1,129 @@
+/*!
+* \file
+* CorrelationPruning class defitition. This file is part of Evaluation module.
+* The CorrelationPruning is a class for feature redundancy reduction. Of each highly correlating feature pair the feature with the larger deviation is kept.
+* The correlations are computed block by block and only against the features not yet found redundant, so the later blocks shrink.
+* With the Local scope only features of the same modality and category (the first two parts of the A::B::C feature names) are compared.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <Evaluation/Export.h>
+#include <Evaluation/AbstractTDPAction.h>
+#include <DataRepresentation/Array2D.h>
+#include <QDebug>
+#include <QHash>
+
+namespace dkeval
+{
+
+//-----------------------------------------------------------------------------
+
+/*!
+* \brief CorrelationPruning class for removing redundant features
+*/
+class Evaluation_API CorrelationPruning: public AbstractTBPAction
+{
+
+public:
+
+	/*!
+	* \brief Constructor to load settings parameters
+	* \param [in] aSettings The settigns file
+	*/
+	CorrelationPruning( QSettings* aSettings )
+	:
+		AbstractTBPAction( aSettings ),
+		mThreshold( 0.0 ),
+		mIsLocal( false ),
+		mSelectedFeatures(),
+		mParameters()
+	{
+		if ( mSettings == nullptr )
+		{
+			qDebug() << "CorrelationPruning - Error: Settings is a nullptr";
+			mIsInitValid = false;
+		}
+		else
+		{
+			bool isThreshold;
+			mThreshold = std::abs( mSettings->value( "CorrelationPruning/threshold" ).toDouble( &isThreshold ) );
+			if ( !isThreshold || mThreshold > 1.0 )
+			{
+				qDebug() << "CorrelationPruning - Error: Invalid parameter threshold";
+				mIsInitValid = false;
+			}
+
+			//Optional, features of all modalities and categories are compared by default
+			mIsLocal = mSettings->value( "CorrelationPruning/scope", "Global" ).toString() == "Local";
+
+			mParameters.insert( "CorrelationPruning/threshold", mThreshold );
+		}
+	}
+
+	/*!
+	* \brief Destructor
+	*/
+	~CorrelationPruning() {}
+
+	/*!
+	* \brief Builds the algorithm based on the input datapackage to find the redundant features
+	* \param [in] aDataPackage The package of feature and label data
+	*/
+	void build( const lpmldata::DataPackage& aDataPackage ) override;
+
+	/*!
+	* \brief Transforms the datapackage by removing the redundant features
+	* \param [in] aDataPackage The package of feature and label data
+	* \return lpmldata::DataPackage the transformed datapackage
+	*/
+	lpmldata::DataPackage run( const lpmldata::DataPackage& aDataPackage ) override;
+
+	/*!
+	* \brief Unique class ID
+	* \return QString of class ID
+	*/
+	QString id() override { return "CP"; }
+
+	/*!
+	* \brief Algorithm hyperparameters
+	* \return QMap < QString, QVariant > of hyperparameter names and values
+	*/
+	QMap < QString, QVariant > parameters() override { return mParameters; }
+
+	/*!
+	* \brief Kept features
+	* \return QStringList& names of kept features
+	*/
+	QStringList& getFeatureNames() { return mSelectedFeatures; }
+
+	/*!
+	* \brief Finds the redundant columns of a sample matrix.
+	* \param [in] aRows Row-major block with a sample in each row and a feature in each column.
+	* \param [in] aGroups Group id of each column, only columns of the same group are compared. All columns are compared if empty.
+	* \param [in] aThreshold Columns with an absolute Pearson correlation above the threshold are redundant.
+	* \return True for each redundant column.
+	*/
+	static QVector< bool > redundantColumns( const lpmldata::Array2D< double >& aRows, const QVector< int >& aGroups, double aThreshold );
+
+	/*!
+	* \brief Group id of each feature name by its modality and category, the first two parts of A::B::C names.
+	*/
+	static QVector< int > categoryGroups( const QStringList& aFeatureNames );
+
+private:
+
+	double mThreshold;
+	bool mIsLocal;
+	QStringList mSelectedFeatures;
+	QMap< QString, QVariant > mParameters;
+};
+
+//-----------------------------------------------------------------------------
+
+}
@@ -12,7 +12,7 @@ CovarianceMatrix::CovarianceMatrix( lpmldata::TabularData& aTabularData )
 :
     lpmldata::Array2D< double >( aTabularData.columnCount(), aTabularData.columnCount() )
 {
-	initialize( aTabularData );
+	initialize( aTabularData.statistics( true ) );
 }
 
 //-----------------------------------------------------------------------------
@@ -26,63 +26,35 @@ CovarianceMatrix::CovarianceMatrix( lpmldata::TabularData& aFirst, lpmldata::Tab
 
 //-----------------------------------------------------------------------------
 
-CovarianceMatrix::~CovarianceMatrix()
+CovarianceMatrix::CovarianceMatrix( const lpmldata::StreamingStatistics& aStatistics )
+:
+	lpmldata::Array2D< double >( aStatistics.columnCount(), aStatistics.columnCount() )
 {
+	initialize( aStatistics );
 }
 
 //-----------------------------------------------------------------------------
 
-void CovarianceMatrix::initialize( lpmldata::TabularData& aTabularData )
+CovarianceMatrix::~CovarianceMatrix()
 {
-	QVector< double > means;
-	int meansSize = aTabularData.columnCount();
-	means.resize( meansSize );
-	means.fill( 0.0 );
+}
 
-	// Go through all columns in the tabular data and determine means.
-	for ( int columnIndex = 0; columnIndex < aTabularData.columnCount(); ++columnIndex )
+//-----------------------------------------------------------------------------
+
+void CovarianceMatrix::initialize( const lpmldata::StreamingStatistics& aStatistics )
+{
+	if ( !aStatistics.isCovarianceEnabled() )
 	{
-		means[ columnIndex ] = aTabularData.mean( columnIndex );
+		qDebug() << "CovarianceMatrix - Error: The statistics do not contain the covariance of the columns";
+		return;
 	}
 
-	// Fill in the covariance matrix.
-	omp_set_nested( 0 );
-
-	for ( int rowIndex = 0; rowIndex < rowCount(); ++rowIndex )
+	// Fill in the covariance matrix from the accumulated co-moments.
+	for ( unsigned int rowIndex = 0; rowIndex < rowCount(); ++rowIndex )
 	{
-		QVariantList firstColumn = aTabularData.column( rowIndex );
-#pragma omp parallel for schedule( guided )
-		for ( int columnIndex = 0; columnIndex < columnCount(); ++columnIndex )
-		{			
-			QVariantList secondColumn = aTabularData.column( columnIndex );
-
-			double leftSqrSum = 0.0;
-			double rightSqrSum = 0.0;
-			double numerator = 0.0;
-			double denomiator = 0.0;
-			double coefficient = 0.0;
-
-			// Go through both column variables
-			for ( int valueIndex = 0; valueIndex < firstColumn.size(); ++valueIndex )
-			{
-				double x = firstColumn.at( valueIndex ).toDouble();
-				double y = secondColumn.at( valueIndex ).toDouble();
-
-				double left  = x - means.at( rowIndex );
-				double right = y - means.at( columnIndex );
-
-				numerator   += left * right;
-				leftSqrSum  += left * left;
-				rightSqrSum += right * right;
-			}
-
-			denomiator  = sqrt( leftSqrSum * rightSqrSum );
-			coefficient = numerator / denomiator;
-
-#pragma omp critical
-			{
-				this->operator()( rowIndex, columnIndex ) = coefficient;				
-			}
+		for ( unsigned int columnIndex = 0; columnIndex < columnCount(); ++columnIndex )
+		{
+			this->operator()( rowIndex, columnIndex ) = aStatistics.correlation( rowIndex, columnIndex );
 		}
 	}
 }
@@ -3,6 +3,7 @@
 #include <Evaluation/Export.h>
 #include <DataRepresentation/Array2D.h>
 #include <DataRepresentation/TabularData.h>
+#include <DataRepresentation/StreamingStatistics.h>
 
 namespace lpmleval
 {
@@ -18,11 +19,13 @@ public:
 
 	CovarianceMatrix( lpmldata::TabularData& aFirst, lpmldata::TabularData& aSecond );
 
+	CovarianceMatrix( const lpmldata::StreamingStatistics& aStatistics );
+
 	virtual ~CovarianceMatrix();
 
 private:
 
-	void initialize( lpmldata::TabularData& aTabularData );
+	void initialize( const lpmldata::StreamingStatistics& aStatistics );
 
 	void initialize( lpmldata::TabularData& aFirst, lpmldata::TabularData& aSecond );
 
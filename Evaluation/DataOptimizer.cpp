@@ -1,154 +1,216 @@
 #include <Evaluation/DataOptimizer.h>
+#include <cstring>
+#include <limits>
 
 namespace dkeval
 {
 
 //-----------------------------------------------------------------------------
 
-QVector< double > DataOptimizer::generateMissingValues( QVector< double >& aFeatureVector ) const
-{	
-	for ( auto& element : aFeatureVector )
-	{
-		auto value = QString::number( element );
-		if ( value == "NA" )
-		{
-			double sum = 0;
-			std::for_each( aFeatureVector.begin(), aFeatureVector.end(), 
-				           [ &sum ]( double x ) { sum += x; } );
-
-			auto denominator = aFeatureVector.size();
-			double average   = sum / denominator;
-			element          = average;
-		}		
-	}	
-	
-	return aFeatureVector;
-}
-
-//-----------------------------------------------------------------------------
-
 void dkeval::DataOptimizer::build()
 {
-	auto header = mFDB.headerNames();
+	mRedundandFeatures.clear();
+	mColumnIndices.clear();
+
+	auto header     = mFDB.headerNames();
+	mKeys           = mFDB.keys();
+	mKeys.sort();
+
+	int keyCount    = mKeys.size();
+	int columnCount = mFDB.columnCount();
+
+	// Dense copy of the table, missing values are stored as NaN.
+	const double missing = std::numeric_limits< double >::quiet_NaN();
+	mColumns = lpmldata::Array2D< double >( keyCount, columnCount, lpmldata::Array2DLayout::ColumnMajor );
+
+	const lpmldata::TabularData& FDB = mFDB;
 
-	for ( auto& featureName : header )
+	#pragma omp parallel for schedule( static )
+	for ( int keyIndex = 0; keyIndex < keyCount; ++keyIndex )
 	{
-		QVector< double > featureVector;
-		auto featureVariantList = mFDB.column( featureName );
-		
-		for ( auto& variant : featureVariantList )
-		{
-			featureVector.push_back( variant.toDouble() );
-		}
+		const QVariantList& values = FDB.table().constFind( mKeys.at( keyIndex ) ).value();
 
-		if ( isRedundand( featureVector ) )
+		for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
 		{
-			mRedundandFeatures << featureName;
+			bool isNumber = false;
+			double value  = columnIndex < values.size() ? values.at( columnIndex ).toDouble( &isNumber ) : 0.0;
+
+			mColumns( keyIndex, columnIndex ) = isNumber && value == value ? value : missing;
 		}
-		else if ( hasEnoughTrueValues( featureVector ) )
+	}
+
+	// Profile the columns.
+	QVector< double > means( columnCount, 0.0 );
+	QVector< quint64 > hashes( columnCount, 0 );
+	QVector< char > isDropped( columnCount, 0 );
+	mMissingCounts.fill( 0, columnCount );
+
+	#pragma omp parallel for schedule( dynamic )
+	for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+	{
+		const double* column = mColumns.data() + ulint( columnIndex ) * keyCount;
+
+		int missingCount = 0;
+		double sum       = 0.0;
+		double min       = std::numeric_limits< double >::max();
+		double max       = -std::numeric_limits< double >::max();
+
+		for ( int keyIndex = 0; keyIndex < keyCount; ++keyIndex )
 		{
-			generateMissingValues( featureVector );
+			double value = column[ keyIndex ];
+
+			if ( value != value )
+			{
+				++missingCount;
+				continue;
+			}
+
+			sum += value;
+			min  = std::min( min, value );
+			max  = std::max( max, value );
 		}
+
+		mMissingCounts[ columnIndex ] = missingCount;
+		means[ columnIndex ]          = missingCount < keyCount ? sum / ( keyCount - missingCount ) : 0.0;
+		hashes[ columnIndex ]         = columnHash( column, keyCount );
+
+		// Constant and mostly missing columns do not carry information.
+		isDropped[ columnIndex ] = min >= max || !hasEnoughTrueValues( missingCount, keyCount );
 	}
 
-	auto purifiedHeader = header.toSet().subtract( mRedundandFeatures.toSet() ).toList();
+	// Exact duplicates of an earlier column, only columns with equal hashes are compared.
+	QHash< quint64, QVector< int > > columnsByHash;
 
-	// Create new dataset
-	lpmldata::TabularData updatedFDB = featureDatabaseSubset( purifiedHeader, mFDB );
+	for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+	{
+		if ( isDropped.at( columnIndex ) ) continue;
 
-	mFDB = updatedFDB;
-}
-//-----------------------------------------------------------------------------
+		const double* column = mColumns.data() + ulint( columnIndex ) * keyCount;
+		auto& candidates     = columnsByHash[ hashes.at( columnIndex ) ];
 
-bool DataOptimizer::hasEnoughTrueValues( const QVector< double >& aFeatureVector ) const
-{
-	auto falseEntryNumber = 0;
+		for ( int candidate : candidates )
+		{
+			// The missing values are the same NaN, a bitwise comparison treats them as equal.
+			if ( std::memcmp( column, mColumns.data() + ulint( candidate ) * keyCount, sizeof( double ) * keyCount ) == 0 )
+			{
+				isDropped[ columnIndex ] = 1;
+				break;
+			}
+		}
 
-	for ( auto& element : aFeatureVector )
-	{
-		auto value = QString::number( element );
-		if ( value == "NA" )
+		if ( !isDropped.at( columnIndex ) )
 		{
-			falseEntryNumber++;
+			candidates.push_back( columnIndex );
 		}
 	}
 
-	double totalNumberOfElements = aFeatureVector.size();
-	auto falseEntryPercentage    = ( double( falseEntryNumber ) / totalNumberOfElements ) * 100;
-
-	if ( falseEntryPercentage < 0.2 )
+	for ( int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
 	{
-		return true;
+		if ( isDropped.at( columnIndex ) )
+		{
+			mRedundandFeatures << header.at( columnIndex );
+		}
+		else
+		{
+			mColumnIndices.push_back( columnIndex );
+		}
 	}
-	else
+
+	// Fill in the missing values of the kept columns.
+	int keptCount = mColumnIndices.size();
+
+	#pragma omp parallel for schedule( static )
+	for ( int keptIndex = 0; keptIndex < keptCount; ++keptIndex )
 	{
-		return false;
+		int columnIndex = mColumnIndices.at( keptIndex );
+
+		if ( mMissingCounts.at( columnIndex ) > 0 )
+		{
+			imputeMissingValues( mColumns.data() + ulint( columnIndex ) * keyCount, keyCount, means.at( columnIndex ) );
+		}
 	}
 }
 
 //-----------------------------------------------------------------------------
 
-bool DataOptimizer::isRedundand( const QVector< double >& aFeatureVector ) const
+lpmldata::TabularData DataOptimizer::optimizedFeatureDatabase() const
 {
-	auto vectorSize = aFeatureVector.size();
-	double sum      = 0;
+	if ( mColumns.rowCount() != unsigned( mKeys.size() ) || mColumns.columnCount() != mFDB.columnCount() )
+	{
+		return mFDB;  // Not built yet.
+	}
 
-	std::for_each( aFeatureVector.begin(), aFeatureVector.end(), [ &sum ]( double x ) { sum += x; } );
+	auto header = mFDB.headerNames();
 
-	if ( sum == 0 || sum == vectorSize || !hasEnoughTrueValues( aFeatureVector ) )
+	QStringList purifiedHeader;
+	for ( int columnIndex : mColumnIndices )
 	{
-		return true;
+		purifiedHeader.push_back( header.at( columnIndex ) );
 	}
-	else
+
+	lpmldata::TabularData filteredFDB;
+	filteredFDB.setHeader( purifiedHeader );
+
+	for ( int keyIndex = 0; keyIndex < mKeys.size(); ++keyIndex )
 	{
-		return false;
+		QVariantList filteredFeatureVector;
+		filteredFeatureVector.reserve( mColumnIndices.size() );
+
+		for ( int columnIndex : mColumnIndices )
+		{
+			filteredFeatureVector.push_back( mColumns.at( keyIndex, columnIndex ) );
+		}
+
+		filteredFDB.insert( mKeys.at( keyIndex ), filteredFeatureVector );
 	}
+
+	return filteredFDB;
 }
 
 //-----------------------------------------------------------------------------
 
-lpmldata::TabularData DataOptimizer::featureDatabaseSubset( const QStringList& aPurifiedHeader, const lpmldata::TabularData& aFDB ) const
+bool DataOptimizer::hasEnoughTrueValues( int aMissingCount, int aValueCount ) const
 {
-	lpmldata::TabularData filteredFDB;
-	filteredFDB.setHeader( aPurifiedHeader );
-
-	auto originalFeatureNames = aFDB.headerNames();
-	auto keys = aFDB.keys();
+	if ( aValueCount == 0 )
+	{
+		return false;
+	}
 
-	QVector< int > indices;
+	auto falseEntryPercentage = ( double( aMissingCount ) / aValueCount ) * 100;
 
-	for ( auto& featureName : aPurifiedHeader )
-	{
-		for ( int i = 0; i < originalFeatureNames.size(); ++i )
-		{
-			auto originalName = originalFeatureNames.at( i );
-			auto featureIndex = -1;
+	return falseEntryPercentage < mMaximumMissingPercentage;
+}
 
+//-----------------------------------------------------------------------------
 
-			if ( featureName == originalName )
-			{
-				featureIndex = i;
-				indices.push_back( featureIndex );
-			}
-		}
-	}
+quint64 DataOptimizer::columnHash( const double* aColumn, int aSize )
+{
+	// FNV-1a over the value bits.
+	quint64 hash = 0xcbf29ce484222325ULL;
 
-	for ( auto& key : keys )
+	for ( int index = 0; index < aSize; ++index )
 	{
-		QVariantList filteredFeatureVector;
+		quint64 bits;
+		std::memcpy( &bits, aColumn + index, sizeof( bits ) );
 
-		for ( int i = 0; i < indices.size(); ++i )
-		{
-			filteredFeatureVector.push_back( aFDB.valueAt( key, indices.at( i ) ) );
-		}
-
-		filteredFDB.insert( key, filteredFeatureVector );
+		hash = ( hash ^ bits ) * 0x100000001b3ULL;
 	}
 
-	return filteredFDB;
+	return hash;
 }
 
 //-----------------------------------------------------------------------------
 
+void DataOptimizer::imputeMissingValues( double* aColumn, int aSize, double aValue )
+{
+	// Branchless select, the compiler vectorizes the loop.
+	for ( int index = 0; index < aSize; ++index )
+	{
+		double value    = aColumn[ index ];
+		aColumn[ index ] = value == value ? value : aValue;
+	}
 }
 
+//-----------------------------------------------------------------------------
+
+}
\ No newline at end of file
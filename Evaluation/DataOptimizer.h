@@ -2,6 +2,8 @@
 * \file
 * DataOptimzier class defitition. This file is part of Evaluation module.
 * The DataOptimzier class performs feature and label dataset optimization by checking the missing values, validity of features and sample keys etc.
+* The features are profiled in one parallel pass over a dense copy of the table: constant features, features with more missing values than the limit
+* and exact duplicates of earlier features (found by a 64-bit content hash, then compared) are dropped, the missing values are imputed with the feature mean.
 *
 * \remarks
 *
@@ -13,6 +15,7 @@
 
 #include <FileIo\TabularDataFileIo.h>
 #include <DataRepresentation/DataPackage.h>
+#include <DataRepresentation/Array2D.h>
 #include <Evaluation/Export.h>
 
 namespace dkeval
@@ -25,14 +28,20 @@ class Evaluation_API DataOptimizer
 	DataOptimizer();
 
 public:
-	
+
 	/*!
 	* \brief Constructor to load the feature database
 	* \param [in] aFDB Feature database
+	* \param [in] aMaximumMissingPercentage Features with at least this percentage of missing values are dropped
 	*/
-	DataOptimizer::DataOptimizer( const lpmldata::TabularData& aFDB )
+	DataOptimizer::DataOptimizer( const lpmldata::TabularData& aFDB, double aMaximumMissingPercentage = 20.0 )
 		: mFDB( aFDB ),
-		mRedundandFeatures()
+		mMaximumMissingPercentage( aMaximumMissingPercentage ),
+		mRedundandFeatures(),
+		mKeys(),
+		mColumns(),
+		mColumnIndices(),
+		mMissingCounts()
 	{
 	}
 
@@ -50,29 +59,53 @@ public:
 
 
 	/*!
-	* \brief get redundand features 
+	* \brief get redundand features
 	* \return QStringList of redundand features
 	*/
 	QStringList redundandFeatures() const { return mRedundandFeatures; }
 
 
 	/*!
-	* \brief get optimized feature database
+	* \brief get optimized feature database, created from the kept columns of the imputed dense table
+	* \details This is the only copy of the optimized data. DataPackage and the fold generation need a TabularData, and the imputed
+	* values differ from the loaded database, so the rows are built once here. Callers that can work on dense columns should use the view instead.
 	* \return lpmldata::TabularData optimized feature database
 	*/
-	lpmldata::TabularData optimizedFeatureDatabase() const { return mFDB; }
+	lpmldata::TabularData optimizedFeatureDatabase() const;
+
+
+	/*!
+	* \brief Kept columns of the loaded feature database in their original order, together with columns() the optimized data without a copy
+	*/
+	const QVector< int >& columnIndices() const { return mColumnIndices; }
+
+
+	/*!
+	* \brief Imputed dense table, one column per feature of the loaded database and one row per sorted key
+	*/
+	const lpmldata::Array2D< double >& columns() const { return mColumns; }
+
+
+	/*!
+	* \brief Missing ("NA", empty, non-numeric or NaN) values of each column of the loaded database
+	*/
+	const QVector< int >& missingCounts() const { return mMissingCounts; }
 
 
 private:
-	QVector< double > generateMissingValues( QVector< double >& aFeatureVector ) const;
-	bool hasEnoughTrueValues( const QVector< double >& aFeatureVector ) const;
-	bool isRedundand( const QVector< double >& aFeatureVector ) const;
-	lpmldata::TabularData featureDatabaseSubset( const QStringList& aPurifiedHeader, const lpmldata::TabularData& aFDB ) const;
-	
+	bool hasEnoughTrueValues( int aMissingCount, int aValueCount ) const;
+	static quint64 columnHash( const double* aColumn, int aSize );
+	static void imputeMissingValues( double* aColumn, int aSize, double aValue );
+
 
 private:
 	QStringList mRedundandFeatures;
 	lpmldata::TabularData mFDB;
-	
+	double mMaximumMissingPercentage;        //!< Missing value percentage from which a feature is dropped.
+	QStringList mKeys;                       //!< Sorted keys, the rows of mColumns.
+	lpmldata::Array2D< double > mColumns;    //!< Column-major, missing values are imputed after build().
+	QVector< int > mColumnIndices;           //!< The view of the optimized feature database.
+	QVector< int > mMissingCounts;
+
 };
-}
\ No newline at end of file
+}
@@ -0,0 +1,368 @@
+/*!
+* \file
+* Member function definitions for FeatureRanking class. This file is part of Evaluation module.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#include <Evaluation/FeatureRanking.h>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <omp.h>
+
+namespace dkeval
+{
+
+namespace
+{
+	const int kBlockSize = 64;  // Columns of a block, the sums of a block for all classes stay in cache.
+
+	// NaN scores are ranked last.
+	double sortKey( double aScore )
+	{
+		return std::isnan( aScore ) ? -std::numeric_limits< double >::infinity() : aScore;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+bool FeatureRanking::methodFromString( const QString& aName, RankMethod& aMethod )
+{
+	if ( aName == "RSquared" )               aMethod = RankMethod::RSquared;
+	else if ( aName == "Pearson" )           aMethod = RankMethod::Pearson;
+	else if ( aName == "PointBiserial" )     aMethod = RankMethod::PointBiserial;
+	else if ( aName == "AnovaF" )            aMethod = RankMethod::AnovaF;
+	else if ( aName == "MutualInformation" ) aMethod = RankMethod::MutualInformation;
+	else return false;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< double > FeatureRanking::scores( const lpmldata::Array2D< double >& aRows, const QVector< int >& aLabelCodes, int aClassCount ) const
+{
+	int columnCount = aRows.columnCount();
+	QVector< double > scores( columnCount, 0.0 );
+
+	if ( aRows.layout() != lpmldata::Array2DLayout::RowMajor || int( aRows.rowCount() ) != aLabelCodes.size() || aClassCount < 1 )
+	{
+		qDebug() << "FeatureRanking - Error: The rows must be row-major with one label code each";
+		return scores;
+	}
+
+	int blockCount = ( columnCount + kBlockSize - 1 ) / kBlockSize;
+
+	#pragma omp parallel for schedule( dynamic )
+	for ( int blockIndex = 0; blockIndex < blockCount; ++blockIndex )
+	{
+		int begin = blockIndex * kBlockSize;
+		int end   = std::min( begin + kBlockSize, columnCount );
+
+		if ( mMethod == RankMethod::MutualInformation )
+		{
+			mutualInformationBlock( aRows, aLabelCodes, aClassCount, begin, end, scores.data() );
+		}
+		else
+		{
+			scoreBlock( aRows, aLabelCodes, aClassCount, begin, end, scores.data() );
+		}
+	}
+
+	return scores;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< int > FeatureRanking::topFeatures( const QVector< double >& aScores, int aCount )
+{
+	QVector< int > columns( aScores.size() );
+	for ( int columnIndex = 0; columnIndex < columns.size(); ++columnIndex )
+	{
+		columns[ columnIndex ] = columnIndex;
+	}
+
+	int count = std::max( 0, std::min( aCount, columns.size() ) );
+
+	std::partial_sort( columns.begin(), columns.begin() + count, columns.end(),
+		[ &aScores ]( int aFirst, int aSecond )
+		{
+			double first  = sortKey( aScores.at( aFirst ) );
+			double second = sortKey( aScores.at( aSecond ) );
+			return first > second || ( first == second && aFirst < aSecond );
+		} );
+
+	columns.resize( count );
+
+	return columns;
+}
+
+//-----------------------------------------------------------------------------
+
+void FeatureRanking::scoreBlock( const lpmldata::Array2D< double >& aRows, const QVector< int >& aLabelCodes, int aClassCount, int aBegin, int aEnd, double* aScores ) const
+{
+	int rowCount     = aRows.rowCount();
+	int columnCount  = aRows.columnCount();
+	int width        = aEnd - aBegin;
+	const double* data = aRows.data();
+
+	// Column means of the block, rows with an unknown class are skipped.
+	QVector< double > means( width, 0.0 );
+	QVector< double > classCounts( width * aClassCount, 0.0 );  //Labelled finite values of each column by class, missing values are skipped per cell
+
+	for ( int rowIndex = 0; rowIndex < rowCount; ++rowIndex )
+	{
+		int code = aLabelCodes.at( rowIndex );
+		if ( code < 0 || code >= aClassCount ) continue;
+
+		const double* row = data + ulint( rowIndex ) * columnCount + aBegin;
+		for ( int column = 0; column < width; ++column )
+		{
+			if ( !std::isfinite( row[ column ] ) ) continue;
+
+			classCounts[ column * aClassCount + code ] += 1.0;
+			means[ column ] += row[ column ];
+		}
+	}
+
+	QVector< double > counts( width, 0.0 );
+	for ( int column = 0; column < width; ++column )
+	{
+		for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+		{
+			counts[ column ] += classCounts.at( column * aClassCount + classIndex );
+		}
+
+		if ( counts.at( column ) > 0.0 )
+		{
+			means[ column ] /= counts.at( column );
+		}
+	}
+
+	// Sums of the centered values per class and the centered sum of squares, every score is derived from them.
+	QVector< double > classSums( aClassCount * width, 0.0 );
+	QVector< double > squares( width, 0.0 );
+
+	for ( int rowIndex = 0; rowIndex < rowCount; ++rowIndex )
+	{
+		int code = aLabelCodes.at( rowIndex );
+		if ( code < 0 || code >= aClassCount ) continue;
+
+		const double* row = data + ulint( rowIndex ) * columnCount + aBegin;
+		double* sums      = classSums.data() + code * width;
+
+		for ( int column = 0; column < width; ++column )
+		{
+			if ( !std::isfinite( row[ column ] ) ) continue;
+
+			double centered = row[ column ] - means[ column ];
+			sums[ column ]    += centered;
+			squares[ column ] += centered * centered;
+		}
+	}
+
+	for ( int column = 0; column < width; ++column )
+	{
+		const double* columnClassCounts = classCounts.constData() + column * aClassCount;
+		double count                    = counts.at( column );
+		double featureSquares           = squares.at( column );
+		double score                    = 0.0;
+
+		if ( count >= 2.0 && featureSquares > 0.0 )
+		{
+			switch ( mMethod )
+			{
+			case RankMethod::RSquared:
+			case RankMethod::Pearson:
+			{
+				// Spread of the label codes of the rows where the feature is present.
+				double meanCode = 0.0;
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					meanCode += classIndex * columnClassCounts[ classIndex ];
+				}
+				meanCode /= count;
+
+				double codeSquares = 0.0;
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					codeSquares += columnClassCounts[ classIndex ] * ( classIndex - meanCode ) * ( classIndex - meanCode );
+				}
+
+				// The feature is centered, so the cross product does not need the centered codes.
+				double crossProduct = 0.0;
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					crossProduct += classIndex * classSums.at( classIndex * width + column );
+				}
+
+				double rSquared = codeSquares > 0.0 ? crossProduct * crossProduct / ( featureSquares * codeSquares ) : 0.0;
+				score           = mMethod == RankMethod::RSquared ? rSquared : std::sqrt( rSquared );
+				break;
+			}
+			case RankMethod::PointBiserial:
+			{
+				double deviation = std::sqrt( featureSquares / count );
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					double classCount = columnClassCounts[ classIndex ];
+					if ( classCount <= 0.0 || classCount >= count ) continue;
+
+					double classMean  = classSums.at( classIndex * width + column ) / classCount;
+					double restMean   = -classSums.at( classIndex * width + column ) / ( count - classCount );
+					double proportion = classCount / count;
+
+					score = std::max( score, std::abs( classMean - restMean ) / deviation * std::sqrt( proportion * ( 1.0 - proportion ) ) );
+				}
+				break;
+			}
+			case RankMethod::AnovaF:
+			{
+				int nonEmptyClassCount = 0;
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					nonEmptyClassCount += columnClassCounts[ classIndex ] > 0.0 ? 1 : 0;
+				}
+
+				if ( nonEmptyClassCount < 2 || count <= nonEmptyClassCount ) break;
+
+				double betweenSquares = 0.0;
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					double classCount = columnClassCounts[ classIndex ];
+					if ( classCount <= 0.0 ) continue;
+
+					double classSum = classSums.at( classIndex * width + column );
+					betweenSquares += classSum * classSum / classCount;
+				}
+
+				double withinSquares = featureSquares - betweenSquares;
+				if ( withinSquares <= featureSquares * 1e-12 )
+				{
+					score = std::numeric_limits< double >::max();  // The classes are perfectly separated.
+				}
+				else
+				{
+					score = ( betweenSquares / ( nonEmptyClassCount - 1 ) ) / ( withinSquares / ( count - nonEmptyClassCount ) );
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		aScores[ aBegin + column ] = score;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void FeatureRanking::mutualInformationBlock( const lpmldata::Array2D< double >& aRows, const QVector< int >& aLabelCodes, int aClassCount, int aBegin, int aEnd, double* aScores ) const
+{
+	int rowCount     = aRows.rowCount();
+	int columnCount  = aRows.columnCount();
+	int width        = aEnd - aBegin;
+	const double* data = aRows.data();
+
+	QVector< double > mins( width, std::numeric_limits< double >::max() );
+	QVector< double > maxs( width, -std::numeric_limits< double >::max() );
+	QVector< double > classCounts( width * aClassCount, 0.0 );  //Labelled finite values of each column by class, missing values are skipped per cell
+	double labelledCount = 0.0;
+
+	for ( int rowIndex = 0; rowIndex < rowCount; ++rowIndex )
+	{
+		int code = aLabelCodes.at( rowIndex );
+		if ( code < 0 || code >= aClassCount ) continue;
+
+		labelledCount += 1.0;
+
+		const double* row = data + ulint( rowIndex ) * columnCount + aBegin;
+		for ( int column = 0; column < width; ++column )
+		{
+			if ( !std::isfinite( row[ column ] ) ) continue;
+
+			classCounts[ column * aClassCount + code ] += 1.0;
+			mins[ column ] = std::min( mins.at( column ), row[ column ] );
+			maxs[ column ] = std::max( maxs.at( column ), row[ column ] );
+		}
+	}
+
+	if ( labelledCount < 2.0 )
+	{
+		return;
+	}
+
+	// Sturges' rule for the number of equal width bins.
+	int binCount = int( std::ceil( std::log2( labelledCount ) ) ) + 1;
+
+	QVector< double > scales( width, 0.0 );
+	for ( int column = 0; column < width; ++column )
+	{
+		double range    = maxs.at( column ) - mins.at( column );
+		scales[ column ] = range > 0.0 && std::isfinite( range ) ? binCount / range : 0.0;
+	}
+
+	// Joint bin and class counts of each column.
+	QVector< int > jointCounts( width * binCount * aClassCount, 0 );
+
+	for ( int rowIndex = 0; rowIndex < rowCount; ++rowIndex )
+	{
+		int code = aLabelCodes.at( rowIndex );
+		if ( code < 0 || code >= aClassCount ) continue;
+
+		const double* row = data + ulint( rowIndex ) * columnCount + aBegin;
+		for ( int column = 0; column < width; ++column )
+		{
+			if ( !std::isfinite( row[ column ] ) ) continue;
+
+			int bin = std::min( int( ( row[ column ] - mins.at( column ) ) * scales.at( column ) ), binCount - 1 );
+			++jointCounts[ ( column * binCount + bin ) * aClassCount + code ];
+		}
+	}
+
+	for ( int column = 0; column < width; ++column )
+	{
+		double information = 0.0;
+		const double* columnClassCounts = classCounts.constData() + column * aClassCount;
+
+		double count = 0.0;
+		for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+		{
+			count += columnClassCounts[ classIndex ];
+		}
+
+		if ( scales.at( column ) > 0.0 && count >= 2.0 )
+		{
+			for ( int bin = 0; bin < binCount; ++bin )
+			{
+				const int* counts = jointCounts.data() + ( column * binCount + bin ) * aClassCount;
+
+				double binCountSum = 0.0;
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					binCountSum += counts[ classIndex ];
+				}
+
+				for ( int classIndex = 0; classIndex < aClassCount; ++classIndex )
+				{
+					if ( counts[ classIndex ] == 0 ) continue;
+
+					double jointCount = counts[ classIndex ];
+					information += jointCount / count * std::log( jointCount * count / ( binCountSum * columnClassCounts[ classIndex ] ) );
+				}
+			}
+		}
+
+		aScores[ aBegin + column ] = information;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+}
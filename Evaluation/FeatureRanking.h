@@ -0,0 +1,103 @@
+/*!
+* \file
+* FeatureRanking class definition. This file is part of Evaluation module.
+* The FeatureRanking scores every feature of a dense sample matrix against integer label codes in one pass. The columns are split into blocks,
+* each block is scored by one thread while walking the rows, so the class sums of a block stay in cache.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <Evaluation/Export.h>
+#include <DataRepresentation/Array2D.h>
+#include <QVector>
+#include <QString>
+
+namespace dkeval
+{
+
+//-----------------------------------------------------------------------------
+
+/*!
+* \brief Ranking criteria, higher scores are better for all of them.
+*/
+enum class RankMethod
+{
+	RSquared,           //!< Coefficient of determination of the linear fit between the feature and the label codes.
+	Pearson,            //!< Absolute Pearson correlation with the label codes.
+	PointBiserial,      //!< Absolute point-biserial correlation, the maximum of the one-vs-rest correlations for more than two classes.
+	AnovaF,             //!< One-way ANOVA F statistic of the feature between the classes.
+	MutualInformation   //!< Mutual information between the equal width binned feature and the class.
+};
+
+//-----------------------------------------------------------------------------
+
+class Evaluation_API FeatureRanking
+{
+
+public:
+
+	/*!
+	* \brief Constructor.
+	* \param [in] aMethod The ranking criterion.
+	*/
+	FeatureRanking( RankMethod aMethod = RankMethod::RSquared ) : mMethod( aMethod ) {}
+
+	/*!
+	* \brief Destructor.
+	*/
+	~FeatureRanking() {}
+
+	/*!
+	* \brief Parses a rankMethod setting value.
+	* \param [in] aName The name of the method, e.g. "RSquared" or "AnovaF".
+	* \param [out] aMethod The parsed method, unchanged if the name is unknown.
+	* \return False if the name is unknown.
+	*/
+	static bool methodFromString( const QString& aName, RankMethod& aMethod );
+
+	RankMethod method() const { return mMethod; }
+
+	/*!
+	* \brief Scores of all features, constant features score 0.
+	* \param [in] aRows Row-major block with a sample in each row and a feature in each column.
+	* \param [in] aLabelCodes Class index of each row in [ 0, aClassCount ).
+	* \param [in] aClassCount The number of classes.
+	* \return The score of each column.
+	*/
+	QVector< double > scores( const lpmldata::Array2D< double >& aRows, const QVector< int >& aLabelCodes, int aClassCount ) const;
+
+	/*!
+	* \brief The aCount best columns in descending score order, ties are resolved by column index. Only the selected columns are sorted.
+	*/
+	static QVector< int > topFeatures( const QVector< double >& aScores, int aCount );
+
+	/*!
+	* \brief All columns in descending score order.
+	*/
+	static QVector< int > ranking( const QVector< double >& aScores ) { return topFeatures( aScores, aScores.size() ); }
+
+private:
+
+	/*!
+	* \brief Scores the columns [ aBegin, aEnd ) of the rows.
+	*/
+	void scoreBlock( const lpmldata::Array2D< double >& aRows, const QVector< int >& aLabelCodes, int aClassCount, int aBegin, int aEnd, double* aScores ) const;
+
+	/*!
+	* \brief Mutual information of the columns [ aBegin, aEnd ) binned between their minimum and maximum.
+	*/
+	void mutualInformationBlock( const lpmldata::Array2D< double >& aRows, const QVector< int >& aLabelCodes, int aClassCount, int aBegin, int aEnd, double* aScores ) const;
+
+private:
+
+	RankMethod mMethod;
+};
+
+//-----------------------------------------------------------------------------
+
+}
@@ -3,45 +3,62 @@
 namespace dkeval
 {
 
+namespace
+{
+
+//-----------------------------------------------------------------------------
+
+struct RankingCacheEntry
+{
+	quint64      fingerprint;  //!< DataPackage::fingerprint() of the ranked data.
+	QString      rankMethod;
+	QStringList  ranking;      //!< All feature names, best first.
+};
+
+const int kRankingCacheSize = 32;
+
+//Shared by all instances, the pipelines of the optimizer create a new FeatureSelection for each step, most recent first
+QList< RankingCacheEntry > rankingCache;
+
+}
+
 //-----------------------------------------------------------------------------
 
 void FeatureSelection::build( const lpmldata::DataPackage& aDataPackage )
 {
-	// Create switch which will call rank function e.g. rSquaredRank, RF, etc.	
-	if ( mRankMethod == "RSquared" )
-	{
-		mFeatureRanks = rSquaredRank( aDataPackage );
-	}
-	else
+	mSelectedFeatures.clear();
+
+	RankMethod method;
+	if ( !FeatureRanking::methodFromString( mRankMethod, method ) )
 	{
 		qDebug() << "SFS - Error: Ranking method is not defined! ";
+		return;
 	}
 
 	int correctedFeatureCount        = 0;
 	int forwardSelectionFeatureCount = std::max( 2, mFeatureCount );
 	correctedFeatureCount            = std::min( forwardSelectionFeatureCount, aDataPackage.featureCount() );
 
-	for ( int i = 0; i < correctedFeatureCount; ++i )
+	// The ranking depends only on the data and the rank method, steps changing featureCount only pick the first features
+	auto fingerprint = aDataPackage.fingerprint();
+	auto ranking     = cachedRanking( fingerprint );
+
+	if ( ranking.isEmpty() )
 	{
-		double max = -DBL_MAX;
-		QString maxFeatureName;
+		QVector< int > labelCodes;
+		auto rows   = denseRows( aDataPackage, labelCodes );
+		auto scores = FeatureRanking( method ).scores( rows, labelCodes, aDataPackage.labelGroups().size() );
 
-		for ( QMap< QString, double >::iterator it = mFeatureRanks.begin(); it != mFeatureRanks.end(); ++it )
+		auto headers = aDataPackage.featureDatabase().headerNames();
+		for ( int column : FeatureRanking::ranking( scores ) )
 		{
-			auto key   = it.key();
-			auto value = it.value();		
-
-			if ( mSelectedFeatures.contains( key ) ) continue;			
-
-			if ( value > max )
-			{
-				max            = value;
-				maxFeatureName = key;
-			}
+			ranking.push_back( headers.at( column ) );
 		}
 
-		mSelectedFeatures.push_back( maxFeatureName );
-	}	
+		cacheRanking( fingerprint, ranking );
+	}
+
+	mSelectedFeatures = ranking.mid( 0, correctedFeatureCount );
 }
 
 //-----------------------------------------------------------------------------
@@ -63,158 +80,80 @@ lpmldata::DataPackage FeatureSelection::run( const lpmldata::DataPackage& aDataP
 
 //-----------------------------------------------------------------------------
 
-QMap< QString, double > FeatureSelection::rSquaredRank( const lpmldata::DataPackage& aDataPackage )
+lpmldata::Array2D< double > FeatureSelection::denseRows( const lpmldata::DataPackage& aDataPackage, QVector< int >& aLabelCodes )
 {
-	QMap< QString, double > ranks;	
-
 	auto activeIndex = aDataPackage.activeLabelIndex();
 	auto labelGroups = aDataPackage.labelGroups();
-	auto commonKeys  = aDataPackage.commonKeys();	
-	auto FDB         = aDataPackage.featureDatabase();
-	auto LDB         = aDataPackage.labelDatabase();
-	auto headers     = FDB.headerNames();
-
-	
-	// Read out the label values and feature values from the dataset.
-	for ( int i = 0; i < headers.size(); ++i )
+	auto commonKeys  = aDataPackage.commonKeys();
+	const auto& FDB  = aDataPackage.featureDatabase();
+	const auto& LDB  = aDataPackage.labelDatabase();
+	int sampleCount  = commonKeys.size();
+	int featureCount = FDB.columnCount();
+
+	QHash< QString, int > labelCodes;
+	for ( int groupIndex = 0; groupIndex < labelGroups.size(); ++groupIndex )
 	{
-		QVector< double > x;
-		QVector< double > y;
-		
-		for ( int j = 0; j < commonKeys.size(); ++j )
-		{
-			auto key = commonKeys.at( j );
-
-			double featureValue = FDB.valueAt( key, i ).toDouble();
-			auto   label        = LDB.valueAt( key, activeIndex ).toString();
-			double labelValue   = labelGroups.indexOf( label ); 
-
-			x.push_back( featureValue );
-			y.push_back( labelValue ); // Create a numerical value list for labels.
-		}
-		
-		// Calculate the mean values of feature and label values separately
-		double sumOfElementsX = 0.0;
-		double sumOfElementsY = 0.0;
-		double denominatorX   = x.size();
-		double denominatorY   = y.size();
-
-		for ( double& element : x )
-		{
-			sumOfElementsX += element;
-		}
-
-		for ( double& element : y )
-		{
-			sumOfElementsY += element;
-		}
-
-		double meanFeature = sumOfElementsX / denominatorX;
-		double meanLabel   = sumOfElementsY / denominatorY;
-
-		// Calculate the difference between actual feature value and mean feature value
-		QVector< double > substractedX;
-		QVector< double > substractedY;
-
-		for ( double& element : x )
-		{
-			substractedX.push_back( element - meanFeature );
-		}
-
-		// Calculate the difference between actual label value and mean label value
-		for ( double& element : y )
-		{
-			substractedY.push_back( element - meanLabel );
-		}
-
-		// Calculate the squared difference of actual feature value and mean feature value
-		// and sum the results 
-		QVector< double > substractedXSquared;	
-
-		double sumOfSquaredElementsX = 0;
-	
-		for ( double& element : substractedX )
-		{
-			substractedXSquared.push_back( pow( element, 2.0 ) );
-		}
-
-		for ( double& element : substractedXSquared )
-		{
-			sumOfSquaredElementsX += element;
-		}
+		labelCodes.insert( labelGroups.at( groupIndex ), groupIndex );
+	}
 
-		// Calculate the squared difference of actual label value and mean label value
-		// and sum the results
-		QVector< double > substractedYSquared;
+	aLabelCodes.fill( -1, sampleCount );
+	lpmldata::Array2D< double > rows( sampleCount, featureCount, lpmldata::Array2DLayout::RowMajor );
 
-		double sumOfSquaredElementsY = 0;
+	#pragma omp parallel for schedule( static )
+	for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		const QString& key = commonKeys.at( sampleIndex );
+		aLabelCodes[ sampleIndex ] = labelCodes.value( LDB.valueAt( key, activeIndex ).toString(), -1 );
 
-		for ( double& element : substractedY )
-		{
-			substractedYSquared.push_back( pow( element, 2.0 ) );
-		}
+		const QVariantList& values = FDB.table().constFind( key ).value();
+		double* row                = rows.data() + ulint( sampleIndex ) * featureCount;
 
-		for ( double& element : substractedYSquared )
+		for ( int featureIndex = 0; featureIndex < featureCount; ++featureIndex )
 		{
-			sumOfSquaredElementsY += element;
+			row[ featureIndex ] = featureIndex < values.size() ? values.at( featureIndex ).toDouble() : 0.0;
 		}
-	
-		// Calculate the difference between actual feature value and mean feature value
-		// multiplied with the difference between actual label value and mean label value
-		// and sum the results
-		QVector< double > slopeNumerator;
+	}
 
-		double sumOfSlopeNumerators = 0;
+	return rows;
+}
 
-		for ( int i = 0; i < x.size(); ++i )
-		{
-			slopeNumerator.push_back( substractedX.at( i ) * substractedY.at( i ) );
-		}
-	
-		for ( double& element : slopeNumerator )
-		{
-			sumOfSlopeNumerators += element;
-		}
-		
-		double slope     = sumOfSlopeNumerators / sumOfSquaredElementsX;  // Calculate the slope of the regression line
-		double intersect = -( slope * meanFeature ) + meanLabel;  // Calculate the Y intersect point of the regression line
+//-----------------------------------------------------------------------------
 
-		// Calculate points of the regression line for each feature value 
-		QVector< double > estimatedValues;
+QStringList FeatureSelection::cachedRanking( quint64 aFingerprint ) const
+{
+	QStringList ranking;
 
-		for ( int i = 0; i < x.size(); ++i )
+	#pragma omp critical( FeatureSelectionRankingCache )
+	{
+		for ( int entryIndex = 0; entryIndex < rankingCache.size(); ++entryIndex )
 		{
-			estimatedValues.push_back( intersect + ( slope * x.at( i ) ) );
+			if ( rankingCache.at( entryIndex ).fingerprint == aFingerprint && rankingCache.at( entryIndex ).rankMethod == mRankMethod )
+			{
+				ranking = rankingCache.at( entryIndex ).ranking;
+				rankingCache.move( entryIndex, 0 );
+				break;
+			}
 		}
-	
-		// Calculate the squared difference between feature values on regression line and mean value 
-		// of label values and sum the results
-		QVector< double > substractedEstimated;
-		QVector< double > substractedEstimatedSquared;
+	}
 
-		double sumOfsubstractedEstimatedSquared = 0;
+	return ranking;
+}
 
-		for ( double& element : estimatedValues )
-		{
-			substractedEstimated.push_back( element - meanLabel );
-		}
+//-----------------------------------------------------------------------------
 
-		for ( double& element : substractedEstimated )
-		{
-			substractedEstimatedSquared.push_back( pow( element, 2.0 ) );
-		}
+void FeatureSelection::cacheRanking( quint64 aFingerprint, const QStringList& aRanking ) const
+{
+	#pragma omp critical( FeatureSelectionRankingCache )
+	{
+		rankingCache.prepend( RankingCacheEntry{ aFingerprint, mRankMethod, aRanking } );
 
-		for ( double& element : substractedEstimatedSquared )
+		while ( rankingCache.size() > kRankingCacheSize )
 		{
-			sumOfsubstractedEstimatedSquared += element;
+			rankingCache.removeLast();
 		}
-
-		double rSquared = sumOfsubstractedEstimatedSquared / sumOfSquaredElementsY;  // Calculate rSquared		
-			
-		ranks.insert( headers.at( i ), rSquared );
 	}
-
-	return ranks;
 }
 
-}
+//-----------------------------------------------------------------------------
+
+}
\ No newline at end of file
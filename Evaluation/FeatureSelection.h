@@ -2,6 +2,8 @@
 * \file
 * FeatureSelection class defitition. This file is part of Evaluation module.
 * The FeatureSelection is a class for describing tabular data manipulation in the feature space by performing the pre-selection of N highest ranking variables
+* The features are ranked by FeatureRanking with the rankMethod setting: RSquared, Pearson, PointBiserial, AnovaF or MutualInformation.
+* The full ranking is cached per data fingerprint and rank method, so optimizer steps changing only featureCount do not rank again.
 *
 * \remarks
 *
@@ -13,6 +15,7 @@
 
 #include <Evaluation/Export.h>
 #include <Evaluation/AbstractTDPAction.h>
+#include <Evaluation/FeatureRanking.h>
 #include <QDebug>
 #include <qmath.h>
 
@@ -38,7 +41,6 @@ public:
 		AbstractTBPAction( aSettings ),
 		mFeatureCount( 0 ),
 		mRankMethod(),
-		mFeatureRanks(),
 		mParameters(),
 		mSelectedFeatures()
 	{
@@ -110,14 +112,26 @@ public:
 
 private:
 
-	QMap< QString, double > rSquaredRank( const lpmldata::DataPackage& aDataPackage );
+	/*!
+	* \brief Gathers the features of the common samples into row-major rows and the active labels into class indices of labelGroups().
+	*/
+	lpmldata::Array2D< double > denseRows( const lpmldata::DataPackage& aDataPackage, QVector< int >& aLabelCodes );
+
+	/*!
+	* \brief Full ranking computed earlier for the same data and rank method, empty if there is none.
+	*/
+	QStringList cachedRanking( quint64 aFingerprint ) const;
+
+	/*!
+	* \brief Stores a full ranking for later steps, the least recently used rankings are dropped.
+	*/
+	void cacheRanking( quint64 aFingerprint, const QStringList& aRanking ) const;
 
 private:
 
 	int mFeatureCount;
 	QString mRankMethod;
 	QStringList mSelectedFeatures;
-	QMap< QString, double > mFeatureRanks;
 	QMap< QString, QVariant > mParameters;
 };
 
@@ -1,4 +1,6 @@
 #include <IsolationForest.h>
+#include <numeric>
+#include <omp.h>
 
 namespace dkeval
 {
@@ -7,93 +9,100 @@ namespace dkeval
 
 void IsolationForest::build( const lpmldata::DataPackage& aDataPackage )
 {
-	auto FDB          = aDataPackage.featureDatabase();
-	auto featureNames = FDB.headerNames();
-	auto keys         = aDataPackage.commonKeys();
-	
-	
+	mOutliers.clear();
 
-	QStringList names; //sample keys
-	QVector< QVector< int > >pathLenghts;
-	QMap< QString, double > averagePathLenghts;
+	const auto& FDB  = aDataPackage.featureDatabase();
+	auto keys        = aDataPackage.commonKeys();
+	int sampleCount  = keys.size();
+	int featureCount = FDB.columnCount();
 
-	for ( int index = 0; index < mTreesnumber; index++ ) 
+	if ( sampleCount < 2 || featureCount < 1 || mTreesnumber < 1 )
 	{
-		//Randomly select a feature from the dataset
-		auto headerSize = featureNames.size();
+		return;
+	}
 
-		QVector< double > featureVector;//Randomly selected feature vector				
+	//Gather the samples once into dense rows
+	lpmldata::Array2D< double > rows( sampleCount, featureCount, lpmldata::Array2DLayout::RowMajor );
 
-		std::random_device rd;
-		std::mt19937 rng( rd() );
-		std::uniform_int_distribution< int > dice( 0, headerSize - 1 ); 
+	#pragma omp parallel for schedule( static )
+	for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+	{
+		auto iterator = FDB.table().constFind( keys.at( sampleIndex ) );
+		if ( iterator == FDB.table().constEnd() ) continue;
 
-		int featureIndex = dice( rng );
+		const QVariantList& values = iterator.value();
+		double* row                = rows.data() + ulint( sampleIndex ) * featureCount;
 
-		for ( int i = 0; i < 1; ++i )
+		for ( int featureIndex = 0; featureIndex < std::min( featureCount, values.size() ); ++featureIndex )
 		{
-			for ( int j = 0; j < keys.size(); ++j )
-			{
-				auto key   = keys.at( j );
-				auto value = FDB.valueAt( key, featureIndex ).toDouble();
-				
-				featureVector.push_back( value );
-				names.push_back( key );
-			}
-		}		
-		//Populate the tree	
-		mRoot = createNode( featureVector );		
-
-		addNode( mRoot );
-
-		
-		//Calculate the path lenght of a sample in the tree
-		QVector< int > lenghts;
-
-		for ( int k = 0; k < featureVector.size(); ++k )
-		{			
-			auto path = pathLenght( featureVector.at( k ), mRoot );		
-			auto name = names.at( k );
-			
-			lenghts.push_back( path );
-			resetCounter();			
+			row[ featureIndex ] = values.at( featureIndex ).toDouble();
 		}
-		pathLenghts.push_back( lenghts );
 	}
 
-	//Calculate the average path lenght for each sample
-	for ( int i = 0; i < pathLenghts.at( 0 ).size(); ++i )
+	int subsamplingSize = std::min( mSubsamplingSize, sampleCount );
+	int heightLimit     = int( std::ceil( std::log2( double( subsamplingSize ) ) ) );
+
+	//Every tree has its own stream, the forest does not depend on the thread count
+	std::random_device rd;
+	unsigned int seed = rd();
+
+	//Each thread sums the path lengths of its trees, the sums are added at the end
+	QVector< QVector< double > > threadPathLenghts( omp_get_max_threads() );
+
+	#pragma omp parallel
 	{
-		QVector< int > temp;
+		QVector< double >& pathLenghts = threadPathLenghts[ omp_get_thread_num() ];
+		pathLenghts.fill( 0.0, sampleCount );
+
+		QVector< int > samples( sampleCount );
+		QVector< Node > tree;
+		tree.reserve( 2 * subsamplingSize );
 
-		for ( int j = 0; j < pathLenghts.size(); ++j )
+		#pragma omp for schedule( dynamic )
+		for ( int treeIndex = 0; treeIndex < mTreesnumber; ++treeIndex )
 		{
-			auto value = pathLenghts.at( j ).at( i );
+			std::seed_seq sequence{ seed, unsigned( treeIndex ) };
+			std::mt19937 rng( sequence );
 
-			temp.push_back( value );
-		}
-		auto value  = averagePathLenght( temp );
-		auto name   = names.at( i );
+			//Partial shuffle, the first subsamplingSize positions are the subsample of the tree
+			std::iota( samples.begin(), samples.end(), 0 );
+			for ( int position = 0; position < subsamplingSize; ++position )
+			{
+				std::uniform_int_distribution< int > dice( position, sampleCount - 1 );
+				std::swap( samples[ position ], samples[ dice( rng ) ] );
+			}
 
-		averagePathLenghts.insertMulti( name, value );
-	}
-	
-	//Calculate the average path lenght of all average path lenghts
-	auto avgPath = averagePath( averagePathLenghts );		
+			tree.clear();
+			buildNode( 0, subsamplingSize, 0, heightLimit, samples, rows, rng, tree );
 
+			for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
+			{
+				pathLenghts[ sampleIndex ] += pathLenght( tree, rows.data() + ulint( sampleIndex ) * featureCount );
+			}
+		}
+	}
 
-	
+	QVector< double > averagePathLenghts( sampleCount, 0.0 );
+	for ( auto& pathLenghts : threadPathLenghts )
+	{
+		for ( int sampleIndex = 0; sampleIndex < pathLenghts.size(); ++sampleIndex )
+		{
+			averagePathLenghts[ sampleIndex ] += pathLenghts.at( sampleIndex ) / mTreesnumber;
+		}
+	}
 
+	//The path lengths are normalized with the average path length of a subsample
+	auto normalization = unsuccessfulSearchLenght( subsamplingSize );
 
-	for ( int i = 0; i < averagePathLenghts.size(); ++i )
+	for ( int sampleIndex = 0; sampleIndex < sampleCount; ++sampleIndex )
 	{
-		auto anomaly = anomalyScore( avgPath, averagePathLenghts.values().at( i ) );
+		auto anomaly = anomalyScore( normalization, averagePathLenghts.at( sampleIndex ) );
 
 		if ( anomaly >= 0.6 )
 		{
-			mOutliers.push_back( averagePathLenghts.keys().at( i ) );
+			mOutliers.push_back( keys.at( sampleIndex ) );
 		}
-	}	
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -104,7 +113,7 @@ lpmldata::DataPackage IsolationForest::run( const lpmldata::DataPackage& aDataPa
 	auto purifiedKeys = keys.toSet().subtract( mOutliers.toSet() ).toList();
 
 	auto updatedFDB = aDataPackage.sampleDatabaseSubset( purifiedKeys );
-	auto updatedLDB = aDataPackage.labelDatabaseSubset( purifiedKeys );	
+	auto updatedLDB = aDataPackage.labelDatabaseSubset( purifiedKeys );
 
 	lpmldata::DataPackage result( updatedFDB, updatedLDB );
 	return result;
@@ -112,196 +121,111 @@ lpmldata::DataPackage IsolationForest::run( const lpmldata::DataPackage& aDataPa
 
 //-----------------------------------------------------------------------------
 
-std::shared_ptr< IsolationForest::Node > IsolationForest::createNode( QVector< double >& aValue )
+int IsolationForest::buildNode( int aBegin, int aEnd, int aDepth, int aHeightLimit, QVector< int >& aSamples, const lpmldata::Array2D< double >& aRows,
+	std::mt19937& aRng, QVector< Node >& aTree )
 {
-	std::shared_ptr< Node > node = std::make_shared< Node >();
-	node->value = aValue;
-	node->left  = nullptr;
-	node->right = nullptr;
+	int nodeIndex = aTree.size();
+	aTree.push_back( Node{ aBegin, aEnd, -1, 0.0, -1, -1 } );
 
-	return node;
-}
-
-//-----------------------------------------------------------------------------
-
-void IsolationForest::addNode( std::shared_ptr< Node > aPointer )
-{
-	if ( mRoot == nullptr )
+	if ( aDepth >= aHeightLimit || aEnd - aBegin < 2 )
 	{
-		qDebug() << "Error - the root is empty!";
+		return nodeIndex;
 	}
-	else 
-	{		
-		//Determine min and max values for the selected feature 
-		QVector< double > temp = aPointer->value;
-
-		std::sort( temp.begin(), temp.end() );
-		
-		auto min = temp.first();
-		auto max = temp.last();
 
+	//Random feature, the next one is tried if it is constant within the node
+	int featureCount = aRows.columnCount();
+	std::uniform_int_distribution< int > featureDice( 0, featureCount - 1 );
+	int firstFeature = featureDice( aRng );
 
-		//generate a random value between min and max
-		std::random_device rd;
-		std::mt19937 rng( rd() );
-		std::uniform_real_distribution< double > distribute( min, max );
-
-		auto splitValue = distribute( rng );
-
-		QVector< double > lower;
-		QVector< double > higher;
+	for ( int offset = 0; offset < featureCount; ++offset )
+	{
+		int feature   = ( firstFeature + offset ) % featureCount;
+		double min    = aRows.data()[ ulint( aSamples.at( aBegin ) ) * featureCount + feature ];
+		double max    = min;
 
-		for ( int i = 0; i < aPointer->value.size(); ++i )
+		for ( int position = aBegin + 1; position < aEnd; ++position )
 		{
-			if ( aPointer->value.at( i ) < splitValue )
-			{
-				lower.push_back( aPointer->value.at( i ) );
-			}
-			else
-			{
-				higher.push_back( aPointer->value.at( i ) );
-			}
-		}
-
-		bool brakeTest = false;
-
-		if ( lower.isEmpty() == true || higher.isEmpty() == true )
-		{	
-			brakeTest = true;
+			double value = aRows.data()[ ulint( aSamples.at( position ) ) * featureCount + feature ];
+			min = std::min( min, value );
+			max = std::max( max, value );
 		}
 
-		if ( brakeTest != true )
+		if ( min >= max )
 		{
-			if ( lower.size() > 1 )
-			{
-				aPointer->left = createNode( lower );
-				addNode( aPointer->left );
-			}
-			else if ( lower.size() == 1 )
-			{
-				aPointer->left = createNode( lower );
-			}
-
-			if ( higher.size() > 1 )
-			{
-				aPointer->right = createNode( higher );
-				addNode( aPointer->right );
-			}
-			else if ( higher.size() == 1 )
-			{
-				aPointer->right = createNode( higher );
-			}
+			continue;
 		}
-	
-	}	
-}
 
-//-----------------------------------------------------------------------------
-
-void IsolationForest::removeNode( std::shared_ptr< Node > aPointer )
-{
-	if ( aPointer != nullptr )
-	{
-		if ( aPointer->left != nullptr )
-		{
-			removeNode( aPointer->left );
-		}
-		if ( aPointer->right != nullptr )
-		{
-			removeNode( aPointer->right );
-		}		
-		
-		aPointer = nullptr;
-	}
-	else
-	{
-		qDebug() << "mRoot is empty!";
-	}
-}
+		//The split is below the maximum, both children get at least one sample
+		std::uniform_real_distribution< double > splitDice( min, max );
+		double split = splitDice( aRng );
 
-//-----------------------------------------------------------------------------
+		auto middle = std::partition( aSamples.begin() + aBegin, aSamples.begin() + aEnd,
+			[ & ]( int aSample ) { return aRows.data()[ ulint( aSample ) * featureCount + feature ] <= split; } );
+		int middlePosition = int( middle - aSamples.begin() );
 
-int IsolationForest::pathLenght( double aValue, std::shared_ptr< Node > aRoot )
-{
-	if ( aRoot->value.contains( aValue ) == true )
-	{						
-		mCounter++;
-	}		
-	
-	if ( aRoot->left != nullptr && aRoot->value.size() > 1 )
-	{
-		pathLenght( aValue, aRoot->left );
-	}
+		int left  = buildNode( aBegin, middlePosition, aDepth + 1, aHeightLimit, aSamples, aRows, aRng, aTree );
+		int right = buildNode( middlePosition, aEnd, aDepth + 1, aHeightLimit, aSamples, aRows, aRng, aTree );
 
-	if ( aRoot->right != nullptr && aRoot->value.size() > 1 )
-	{
-		pathLenght( aValue, aRoot->right );
+		Node& node   = aTree[ nodeIndex ];
+		node.feature = feature;
+		node.split   = split;
+		node.left    = left;
+		node.right   = right;
+		break;
 	}
 
-	return mCounter;
+	return nodeIndex;
 }
 
 //-----------------------------------------------------------------------------
 
-void IsolationForest::resetCounter()
+double IsolationForest::pathLenght( const QVector< Node >& aTree, const double* aRow ) const
 {
-	mCounter = 0;
-}
+	int nodeIndex = 0;
+	int depth     = 0;
 
-//-----------------------------------------------------------------------------
-
-double IsolationForest::averagePathLenght( QVector< int >& aPathLenghts )
-{
-	auto denominator = aPathLenghts.size();
-	double sum       = 0;
-	double average   = 0;
-
-	std::for_each( aPathLenghts.begin(), aPathLenghts.end(),
-				   [ &sum ]( auto x ) { sum += x; } );
+	while ( aTree.at( nodeIndex ).feature >= 0 )
+	{
+		const Node& node = aTree.at( nodeIndex );
+		nodeIndex        = aRow[ node.feature ] <= node.split ? node.left : node.right;
+		++depth;
+	}
 
-	average = sum / denominator;
+	const Node& leaf = aTree.at( nodeIndex );
 
-	return average;
+	return depth + unsuccessfulSearchLenght( leaf.end - leaf.begin );
 }
 
 //-----------------------------------------------------------------------------
 
-double IsolationForest::averagePath( QMap< QString, double >& aPathLenghts )
+double IsolationForest::unsuccessfulSearchLenght( int aInstancesCount ) const
 {
-	auto denominator = aPathLenghts.values().size();
-	double sum     = 0;
-	double average = 0;
+	const double eulerConstant = 0.5772156649;
 
-	for ( auto& element : aPathLenghts.values() )
+	if ( aInstancesCount < 2 )
 	{
-		sum += element;
+		return 0.0;
 	}
 
-	average = sum / denominator;
-
-	return average;
-}
-//-----------------------------------------------------------------------------
-
-double IsolationForest::unsuccessfulSearchLenght( int aInstancesCount )
-{
-	const double eulerConstant = 0.5772156649;
-	const double Ln_i          = 1.57079633;
+	if ( aInstancesCount == 2 )
+	{
+		return 1.0;
+	}
 
-	auto reducedInstanceCount  = aInstancesCount - 1;
-	auto harmonic              = Ln_i + eulerConstant;
+	double reducedInstanceCount = aInstancesCount - 1;
+	double harmonic             = std::log( reducedInstanceCount ) + eulerConstant;
 
-	auto left   = 2 * harmonic * ( reducedInstanceCount );
-	auto right  = ( 2 * reducedInstanceCount ) / aInstancesCount;
+	auto left   = 2.0 * harmonic;
+	auto right  = ( 2.0 * reducedInstanceCount ) / aInstancesCount;
 
 	auto result = left - right;
-	
+
 	return result;
 }
 
 //-----------------------------------------------------------------------------
 
-double IsolationForest::anomalyScore( double aUnsuccessfulSearchLenght, double aAveragePathLenght )
+double IsolationForest::anomalyScore( double aUnsuccessfulSearchLenght, double aAveragePathLenght ) const
 {
 	auto divided = -( aAveragePathLenght / aUnsuccessfulSearchLenght) ;
 
@@ -310,14 +234,6 @@ double IsolationForest::anomalyScore( double aUnsuccessfulSearchLenght, double a
 	return anomaly;
 }
 
-
 //-----------------------------------------------------------------------------
 
-IsolationForest::~IsolationForest()
-{
-		removeNode( mRoot );	
 }
-
-//-----------------------------------------------------------------------------
-
-}
\ No newline at end of file
@@ -2,6 +2,8 @@
 * \file
 * IsolationForest class defitition. This file is part of Evaluation module.
 * The IsolationForest is a class for outlier detection based on Isloation forest algorithm.
+* Each tree isolates a random subsample of psi samples (default 256) with random feature splits up to a height of ceil( log2( psi ) ),
+* the trees are built and scored in parallel, each tree with its own random stream.
 * \remarks
 *
 * \authors
@@ -36,9 +38,7 @@ public:
 		:
 		AbstractTBPAction( aSettings ),
 		mTreesnumber( 0 ),
-		mSubsamplingSize( 0 ),
-		mRoot( nullptr ),
-		mCounter( 0 ),
+		mSubsamplingSize( 256 ),
 		mOutliers(),
 		mParameters()
 	{
@@ -59,13 +59,25 @@ public:
 			}
 
 			mParameters.insert( "IsolationForest/treeCount", mTreesnumber );
+
+			//Optional, the default of the original algorithm is 256
+			if ( mSettings->contains( "IsolationForest/subsamplingSize" ) )
+			{
+				bool isSubsamplingSize;
+				mSubsamplingSize = std::abs( mSettings->value( "IsolationForest/subsamplingSize" ).toInt( &isSubsamplingSize ) );
+				if ( !isSubsamplingSize || mSubsamplingSize < 2 )
+				{
+					qDebug() << "IsolationForest - Error: Invalid parameter subsamplingSize";
+					mIsInitValid = false;
+				}
+			}
 		}
 	}
 
 	/*!
 	* \brief Destructor
 	*/
-	~IsolationForest();
+	~IsolationForest() {}
 	
 	/*!
 	* \brief Builds the algorithm based on the input datapackage to indetify outliers
@@ -102,30 +114,43 @@ public:
 
 private:
 
+	/*!
+	* \brief Node of a flat isolation tree, the node owns the range [ begin, end ) of the subsample positions.
+	*/
 	struct Node
 	{
-		QVector< double > value;
-		std::shared_ptr< Node > left   = nullptr;
-		std::shared_ptr< Node > right  = nullptr;
+		int     begin;
+		int     end;
+		int     feature;  //!< -1 for external nodes.
+		double  split;    //!< Samples with a value not greater than the split go to the left.
+		int     left;
+		int     right;
 	};
 
-	std::shared_ptr< Node > createNode( QVector< double >& aValue );
-	void addNode( std::shared_ptr< Node > aPointer );
-	void removeNode( std::shared_ptr< Node > aPointer );
-	int pathLenght( double aValue, std::shared_ptr< Node > aRoot );
-	void resetCounter();
-	double averagePathLenght( QVector< int >& aPathLenghts );
-	double averagePath( QMap< QString, double >& aPathLenghts );
-	double unsuccessfulSearchLenght( int aInstancesCount );
-	double anomalyScore( double aUnsuccessfulSearchLenght, double aAveragePathLenght );
+	/*!
+	* \brief Recursively splits the subsample range [ aBegin, aEnd ) and appends the nodes to aTree.
+	* \return The index of the created node in aTree.
+	*/
+	static int buildNode( int aBegin, int aEnd, int aDepth, int aHeightLimit, QVector< int >& aSamples, const lpmldata::Array2D< double >& aRows,
+		std::mt19937& aRng, QVector< Node >& aTree );
+
+	/*!
+	* \brief Path length of a row, an external node adds the average path length of its unseparated samples.
+	*/
+	double pathLenght( const QVector< Node >& aTree, const double* aRow ) const;
+
+	/*!
+	* \brief Average path length of an unsuccessful search in a binary search tree of aInstancesCount nodes, c(n) of the algorithm.
+	*/
+	double unsuccessfulSearchLenght( int aInstancesCount ) const;
+
+	double anomalyScore( double aUnsuccessfulSearchLenght, double aAveragePathLenght ) const;
 	
 
 private:
 
 	int mTreesnumber;
-	int mSubsamplingSize;
-	std::shared_ptr< Node > mRoot;
-	int mCounter;
+	int mSubsamplingSize;  //!< Samples of a tree, psi of the algorithm.
 	QStringList mOutliers;
 	QMap< QString, QVariant > mParameters;
 };
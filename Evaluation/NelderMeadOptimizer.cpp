@@ -10,6 +10,8 @@
 
 #include <Evaluation/NelderMeadOptimizer.h>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <omp.h>
 
 namespace lpmleval
 {
@@ -28,7 +30,15 @@ NelderMeadOptimizer::NelderMeadOptimizer( lpmleval::AbstractModel* aModel, lpmle
 	mIsPunish( false ),
 	mTerminationCode( TerminationCode::FunctionConverged ),
 	mIsNegativeNotAllowed( aIsNegativeNotAllowed ),
-	mIsStop( false )
+	mIsStop( false ),
+	mEvaluationMode( EvaluationMode::Serial ),
+	mStagnationIterationCount( 0 ),
+	mIsStopOnCollapse( false ),
+	mMaximumEvaluationCount( 0 ),
+	mTimeLimit( 0 ),
+	mEvaluationCount( 0 ),
+	mModelClones(),
+	mAnalyticsClones()
 {
 	mModel = aModel;
 }
@@ -45,43 +55,167 @@ NelderMeadOptimizer::~NelderMeadOptimizer()
 //-----------------------------------------------------------------------------
 
 double NelderMeadOptimizer::amotry( QList< QVector< double > > &p, QVector< double > &y, QVector< double > &psum, double ihi, double fac )
+{
+	QVector< double > ptry = trialPoint( psum, p[ ihi ], fac );
+
+	//modifyParamsByPunishment( ptry );
+	double ytry = evaluateVertex( ptry );
+
+	return acceptTrial( p, y, psum, ihi, ptry, ytry );
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< double > NelderMeadOptimizer::trialPoint( const QVector< double >& psum, const QVector< double >& aHighest, double fac ) const
 {
 	const double fac1 = ( 1.0 - fac ) / psum.size();
 	const double fac2 = fac1 - fac;
 	QVector< double > ptry;
-	QVector< double > ytry;
-	ytry.resize( 1 );
 
-	for ( lint i = 0; i < p[ ihi ].size(); ++i )
+	for ( lint i = 0; i < aHighest.size(); ++i )
 	{
-		ptry.push_back( ( psum[ i ] * fac1 ) - ( p[ ihi ][ i ] * fac2 ) );
+		ptry.push_back( ( psum[ i ] * fac1 ) - ( aHighest[ i ] * fac2 ) );
 	}
 
-	//modifyParamsByPunishment( ptry );
-	if ( testIfNegative( ptry ) )
+	return ptry;
+}
+
+//-----------------------------------------------------------------------------
+
+double NelderMeadOptimizer::acceptTrial( QList< QVector< double > > &p, QVector< double > &y, QVector< double > &psum, double ihi, const QVector< double >& ptry, double ytry )
+{
+	if ( ytry < y[ ihi ] )
 	{
-		ytry[ 0 ] = DBL_MAX;
+		y[ ihi ] = ytry;
+
+		for ( ulint i = 0; i < psum.size(); ++i )
+		{
+			psum[ i ] = psum[ i ] + ptry[ i ] - p[ ihi ][ i ];
+		}
+
+		p[ ihi ] = ptry;
 	}
-	else
+
+	return ytry;
+}
+
+//-----------------------------------------------------------------------------
+
+double NelderMeadOptimizer::evaluateVertex( const QVector< double >& aVertex, int aWorker )
+{
+	if ( testIfNegative( aVertex ) )
 	{
-		mModel->set( ptry );		
-		ytry[0] = mAnalytics->evaluate( mModel );
-		//mFunction->execute( ptry, ytry );
+		return DBL_MAX;
 	}
 
-	if ( ytry[ 0 ] < y[ ihi ] )
+	#pragma omp atomic
+	++mEvaluationCount;
+
+	auto model     = aWorker == 0 ? mModel : mModelClones.at( aWorker - 1 ).get();
+	auto analytics = aWorker == 0 ? mAnalytics : mAnalyticsClones.at( aWorker - 1 ).get();
+
+	model->set( aVertex );
+
+	return analytics->evaluate( model );
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< double > NelderMeadOptimizer::evaluateVertices( const QList< QVector< double > >& aVertices )
+{
+	int vertexCount = aVertices.size();
+	int workerCount = mModelClones.size() + 1;
+	QVector< double > values( vertexCount, DBL_MAX );
+
+	//Every thread sets and evaluates its own model, the values are written to separate slots
+	#pragma omp parallel for num_threads( workerCount ) schedule( dynamic, 1 ) if ( workerCount > 1 )
+	for ( int vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex )
 	{
-		y[ ihi ] = ytry[ 0 ];
+		values[ vertexIndex ] = evaluateVertex( aVertices.at( vertexIndex ), omp_get_thread_num() );
+	}
 
-		for ( ulint i = 0; i < psum.size(); ++i )
+	return values;
+}
+
+//-----------------------------------------------------------------------------
+
+void NelderMeadOptimizer::createWorkers()
+{
+	releaseWorkers();
+
+	//Inside a parallel region (e.g. creatures evaluated concurrently) the nested region would run on one thread
+	if ( mEvaluationMode == EvaluationMode::Serial || omp_in_parallel() )
+	{
+		return;
+	}
+
+	int workerCount = omp_get_max_threads();
+
+	for ( int worker = 1; worker < workerCount; ++worker )
+	{
+		std::shared_ptr< lpmleval::AbstractModel > model( mModel->clone() );
+		std::shared_ptr< lpmleval::AbstractAnalytics > analytics( mAnalytics->clone() );
+
+		if ( model == nullptr || analytics == nullptr )
 		{
-			psum[ i ] = psum[ i ] + ptry[ i ] - p[ ihi ][ i ];
+			qDebug() << "NelderMeadOptimizer - Warning: The model or the analytics cannot be cloned, the vertices are evaluated serially";
+			releaseWorkers();
+			return;
 		}
 
-		p[ ihi ] = ptry;
+		mModelClones.push_back( model );
+		mAnalyticsClones.push_back( analytics );
 	}
+}
+
+//-----------------------------------------------------------------------------
 
-	return ytry[ 0 ];
+void NelderMeadOptimizer::releaseWorkers()
+{
+	mModelClones.clear();
+	mAnalyticsClones.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+bool NelderMeadOptimizer::isCollapsed( const QList< QVector< double > >& p ) const
+{
+	auto configuration = mModel->discreteIndices( p.first() );
+
+	if ( configuration.isEmpty() )
+	{
+		return false;  // Continuous model.
+	}
+
+	for ( int i = 1; i < p.size(); ++i )
+	{
+		if ( mModel->discreteIndices( p.at( i ) ) != configuration )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+QString NelderMeadOptimizer::terminationName( TerminationCode aTerminationCode )
+{
+	switch ( aTerminationCode )
+	{
+		case TerminationCode::ParameterError:                    return "ParameterError";
+		case TerminationCode::FunctionConverged:                 return "FunctionConverged";
+		case TerminationCode::MinFunctionToleranceChangeReached: return "MinFunctionToleranceChangeReached";
+		case TerminationCode::MaxIterationsReached:              return "MaxIterationsReached";
+		case TerminationCode::ExecutionAborted:                  return "ExecutionAborted";
+		case TerminationCode::StagnationReached:                 return "StagnationReached";
+		case TerminationCode::SimplexCollapsed:                  return "SimplexCollapsed";
+		case TerminationCode::MaxEvaluationsReached:             return "MaxEvaluationsReached";
+		case TerminationCode::DeadlineReached:                   return "DeadlineReached";
+	}
+
+	return "Unknown";
 }
 
 //-----------------------------------------------------------------------------
@@ -117,33 +251,24 @@ void NelderMeadOptimizer::build()
 
 	const int mpts = mModel->inputCount() + 1;
 
-	QVector< double > y;
-	QVector< double > trial;
-	trial.resize( 1 );
-
-	for ( int i = 0; i < mpts; ++i )
+	if ( mIsStop )
 	{
-		if ( mIsStop )
-		{
-			mIsStop = false;
-			mOptimizedParameters = mInitialParameters;
+		mIsStop = false;
+		mOptimizedParameters = mInitialParameters;
+		mModel->set( mOptimizedParameters );
 
-			mTerminationCode = TerminationCode::ExecutionAborted;
-			return;
-		}
+		mTerminationCode = TerminationCode::ExecutionAborted;
+		return;
+	}
 
-		if ( testIfNegative( p[ i ] ) )
-		{
-			trial[ 0 ] = DBL_MAX;
-		}
-		else
-		{
-			mModel->set( p[ i ] );
-			trial[ 0 ] = mAnalytics->evaluate( mModel );
-		}
+	QElapsedTimer timer;
+	timer.start();
+	mEvaluationCount = 0;
 
-		y.push_back( trial[ 0 ] );
-	}
+	createWorkers();
+	const bool isSpeculative = mEvaluationMode == EvaluationMode::Speculative && !mModelClones.isEmpty();
+
+	QVector< double > y = evaluateVertices( p );
 
 	lint ncalls = 0;
 
@@ -167,6 +292,10 @@ void NelderMeadOptimizer::build()
 
 	mOptimizedParameters.clear();
 
+	lint iteration       = 0;
+	lint lastImprovement = 0;
+	double bestValue     = DBL_MAX;  // Stagnation is measured on the best vertex
+
 	while ( ncalls < mMaximumIterationCount )
 	{
 		QVector< int > s = labelOrder( y );
@@ -188,7 +317,41 @@ void NelderMeadOptimizer::build()
 			rtol = mTolerance / 2.0;
 		}
 
+		if ( y[ ilo ] < bestValue )
+		{
+			bestValue       = y[ ilo ];
+			lastImprovement = iteration;
+		}
+
+		TerminationCode stopCode = TerminationCode::FunctionConverged;
+		bool isStopped           = true;
+
 		if ( rtol < mTolerance || mIsStop )
+		{
+			stopCode = TerminationCode::MinFunctionToleranceChangeReached;
+		}
+		else if ( mStagnationIterationCount > 0 && iteration - lastImprovement >= mStagnationIterationCount )
+		{
+			stopCode = TerminationCode::StagnationReached;
+		}
+		else if ( mIsStopOnCollapse && isCollapsed( p ) )
+		{
+			stopCode = TerminationCode::SimplexCollapsed;
+		}
+		else if ( mMaximumEvaluationCount > 0 && mEvaluationCount >= mMaximumEvaluationCount )
+		{
+			stopCode = TerminationCode::MaxEvaluationsReached;
+		}
+		else if ( mTimeLimit > 0 && timer.elapsed() >= mTimeLimit )
+		{
+			stopCode = TerminationCode::DeadlineReached;
+		}
+		else
+		{
+			isStopped = false;
+		}
+
+		if ( isStopped )
 		{
 			double t = y[ 0 ];
 			y[ 0 ] = y[ ilo ];
@@ -198,55 +361,71 @@ void NelderMeadOptimizer::build()
 			p[ ilo ] = p[ 0 ];
 			p[ 0 ] = mOptimizedParameters;
 			mIsStop = false;
+			releaseWorkers();
+			mModel->set( mOptimizedParameters );  // The model holds the last evaluated vertex, with workers that of an arbitrary thread
 
-			mTerminationCode = TerminationCode::MinFunctionToleranceChangeReached;
+			mTerminationCode = stopCode;
 			//qDebug() << "NelderMeadOptimizer ITERATIONS (TerminationCode::MinFunctionToleranceChangeReached): " << ncalls;
 			return;
 		}
 
+		++iteration;
 		ncalls = ncalls + 2;
 
-		double ytry = amotry( p, y, psum, ihi, -1.0 );
+		//Speculative mode: reflection, expansion, outside and inside contraction of the current simplex, evaluated together.
+		//The moves below pick the same points as the serial amotry() calls, the iteration count is not changed by the extra evaluations.
+		QList< QVector< double > > trials;
+		QVector< double > trialValues;
+
+		if ( isSpeculative )
+		{
+			trials << trialPoint( psum, p[ ihi ], -1.0 ) << trialPoint( psum, p[ ihi ], -2.0 ) << trialPoint( psum, p[ ihi ], -0.5 ) << trialPoint( psum, p[ ihi ], 0.5 );
+			trialValues = evaluateVertices( trials );
+		}
+
+		double yhi  = y[ ihi ];
+		double ytry = isSpeculative ? acceptTrial( p, y, psum, ihi, trials.at( 0 ), trialValues.at( 0 ) ) : amotry( p, y, psum, ihi, -1.0 );
 
 		if ( ytry <= y[ ilo ] )
 		{
-			ytry = amotry( p, y, psum, ihi, 2.0 );
+			ytry = isSpeculative && ytry < yhi ? acceptTrial( p, y, psum, ihi, trials.at( 1 ), trialValues.at( 1 ) ) : amotry( p, y, psum, ihi, 2.0 );
 		}
 		else if ( ytry >= y[ inhi ] )
 		{
 			double ysave = y[ ihi ];
-			ytry = amotry( p, y, psum, ihi, 0.5 );
+			int contraction = ytry < yhi ? 2 : 3;  //Outside if the reflection replaced the highest vertex
+			ytry = isSpeculative ? acceptTrial( p, y, psum, ihi, trials.at( contraction ), trialValues.at( contraction ) ) : amotry( p, y, psum, ihi, 0.5 );
 
 			if ( ytry >= ysave )
 			{
+				QList< QVector< double > > shrunkVertices;
+				QVector< int > shrunkIndices;
+
 				for ( int i = 0; i < mpts; ++i )
 				{
 					if ( i != ilo )
 					{
-						psum.clear();
+						QVector< double > vertex;
 
 						for ( int j = 0; j < mModel->inputCount(); ++j )
 						{
-							psum.push_back( 0.5 * ( p[ i ][ j ] + p[ ilo ][ j ] ) );
+							vertex.push_back( 0.5 * ( p[ i ][ j ] + p[ ilo ][ j ] ) );
 						}
 
-						p[ i ] = psum;
-
-						//modifyParamsByPunishment( psum );
-						if ( testIfNegative( psum ) )
-						{
-							trial[ 0 ] = DBL_MAX;
-						}
-						else
-						{
-							//mFunction->execute( psum, trial );
-							mModel->set( psum );
-							trial[ 0 ] = mAnalytics->evaluate( mModel );
-						}
-						y[ i ] = trial[ 0 ];
+						p[ i ] = vertex;
+						shrunkVertices.push_back( vertex );
+						shrunkIndices.push_back( i );
 					}
 				}
 
+				//modifyParamsByPunishment( psum );
+				auto shrunkValues = evaluateVertices( shrunkVertices );
+
+				for ( int k = 0; k < shrunkIndices.size(); ++k )
+				{
+					y[ shrunkIndices.at( k ) ] = shrunkValues.at( k );
+				}
+
 				ncalls = ncalls + mModel->inputCount();
 
 				psum.clear();
@@ -277,6 +456,8 @@ void NelderMeadOptimizer::build()
 	mOptimizedParameters = p[ ilo ];
 	p[ ilo ] = p[ 0 ];
 	p[ 0 ] = mOptimizedParameters;
+	releaseWorkers();
+	mModel->set( mOptimizedParameters );
 
 	mTerminationCode = TerminationCode::MaxIterationsReached;
 	//qDebug() << "NelderMeadOptimizer ITERATIONS (TerminationCode::MaxIterationsReached): " << ncalls;
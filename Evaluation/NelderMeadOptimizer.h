@@ -16,6 +16,8 @@
 #include <Evaluation/AbstractAnalytics.h>
 #include <QVector>
 #include <QSettings>
+#include <QString>
+#include <memory>
 
 namespace lpmleval
 {
@@ -34,6 +36,17 @@ public:
 		MinFunctionToleranceChangeReached,  // Minimum function tolerance changes reached.
 		MaxIterationsReached,     // Maximum number of iterations has been reached.
 		ExecutionAborted,
+		StagnationReached,        // The best value did not improve for the given number of iterations.
+		SimplexCollapsed,         // All vertices map to the same discrete configuration of the model.
+		MaxEvaluationsReached,    // Maximum number of objective evaluations has been reached.
+		DeadlineReached,          // The time limit has been reached.
+	};
+
+	enum class EvaluationMode
+	{
+		Serial = 0,               // One vertex at a time on the given model.
+		Parallel,                 // The initial and the shrunk vertices are evaluated concurrently on clones of the model and the analytics.
+		Speculative,              // Parallel, and the reflection, expansion and both contraction points of an iteration are evaluated together.
 	};
 
 	NelderMeadOptimizer( lpmleval::AbstractModel* aModel, lpmleval::AbstractAnalytics* aAnalytics, const QVector< double >& aInitialInputs, const QVector< double >& aScales, double aTolerance, lint aMaximumIterationCount, bool aIsNegativeNotAllowed );
@@ -70,6 +83,36 @@ public:
 	*/
 	void setMaximumIterationCount( int aIterations ) { mMaximumIterationCount = aIterations; }
 
+	/*!
+	* \brief Sets how the vertices are evaluated. The parallel modes need AbstractModel::clone() and AbstractAnalytics::clone(), otherwise the evaluation stays serial.
+	* \param [in] aEvaluationMode The evaluation mode.
+	*/
+	void setEvaluationMode( EvaluationMode aEvaluationMode ) { mEvaluationMode = aEvaluationMode; }
+
+	/*!
+	* \brief Stops the optimization if the best value did not improve for the given number of iterations, 0 disables it.
+	* \param [in] aIterations The number of iterations without improvement.
+	*/
+	void setStagnationIterationCount( int aIterations ) { mStagnationIterationCount = aIterations; }
+
+	/*!
+	* \brief Stops the optimization if all vertices map to the same AbstractModel::discreteIndices().
+	* \param [in] aIsStopOnCollapse True if the collapse stops the optimization.
+	*/
+	void setStopOnCollapse( bool aIsStopOnCollapse ) { mIsStopOnCollapse = aIsStopOnCollapse; }
+
+	/*!
+	* \brief Sets the maximum number of objective evaluations, 0 disables it. It is checked between the iterations.
+	* \param [in] aEvaluations The maximum number of objective evaluations.
+	*/
+	void setMaximumEvaluationCount( lint aEvaluations ) { mMaximumEvaluationCount = aEvaluations; }
+
+	/*!
+	* \brief Sets the wall-clock limit of build() in milliseconds, 0 disables it. It is checked between the iterations.
+	* \param [in] aMilliseconds The time limit.
+	*/
+	void setTimeLimit( qint64 aMilliseconds ) { mTimeLimit = aMilliseconds; }
+
 	/*!
 	* \brief Returns with the maximum number of iterations.
 	* \return The maximum number of iterations.
@@ -82,6 +125,12 @@ public:
 	*/
 	const double tolerance() const { return mTolerance; }
 
+	/*!
+	* \brief Returns with the evaluation mode.
+	* \return The evaluation mode.
+	*/
+	EvaluationMode evaluationMode() const { return mEvaluationMode; }
+
 	/*!
 	* \brief Returns with the scale values.
 	* \return The scale values.
@@ -108,6 +157,17 @@ public:
 
 	TerminationCode terminationCode() const { return mTerminationCode; }
 
+	/*!
+	* \brief Returns with the name of a termination code, for logging.
+	*/
+	static QString terminationName( TerminationCode aTerminationCode );
+
+	/*!
+	* \brief Returns with the number of objective evaluations of the last build().
+	* \return The number of objective evaluations.
+	*/
+	lint evaluationCount() const { return mEvaluationCount; }
+
 	QVector< double > result() override { return mOptimizedParameters; }
 
 private:
@@ -130,6 +190,43 @@ private:
 	*/
 	double amotry( QList< QVector< double > > &p, QVector< double > &y, QVector< double > &psum, double ihi, double fac );
 
+	/*!
+	* \brief Calculates a trial point on the line of the highest vertex and the centroid of the others.
+	* \param [in] psum Sum of the vertices.
+	* \param [in] aHighest The highest vertex.
+	* \param [in] fac Defines the trial point, -1 is the reflection.
+	* \return The trial point.
+	*/
+	QVector< double > trialPoint( const QVector< double >& psum, const QVector< double >& aHighest, double fac ) const;
+
+	/*!
+	* \brief Replaces the highest vertex with the trial point if it is better.
+	* \return The similarity value of the trial point.
+	*/
+	double acceptTrial( QList< QVector< double > > &p, QVector< double > &y, QVector< double > &psum, double ihi, const QVector< double >& ptry, double ytry );
+
+	/*!
+	* \brief Evaluates one vertex on the model and the analytics of a worker, worker 0 is the given model.
+	*/
+	double evaluateVertex( const QVector< double >& aVertex, int aWorker = 0 );
+
+	/*!
+	* \brief Evaluates the vertices concurrently, one worker per thread.
+	*/
+	QVector< double > evaluateVertices( const QList< QVector< double > >& aVertices );
+
+	/*!
+	* \brief Clones the model and the analytics for the worker threads of the parallel evaluation modes.
+	*/
+	void createWorkers();
+
+	void releaseWorkers();
+
+	/*!
+	* \brief Checks if all vertices map to the same discrete configuration of the model.
+	*/
+	bool isCollapsed( const QList< QVector< double > >& p ) const;
+
 	bool testIfNegative( QVector< double > aVector );
 
 private:
@@ -145,6 +242,14 @@ private:
 	bool                         mIsNegativeNotAllowed;      //!< Are negative values allowed?
 	bool                         mIsStop;
 	lpmleval::AbstractAnalytics* mAnalytics;
+	EvaluationMode               mEvaluationMode;            //!< Serial or concurrent vertex evaluation.
+	int                          mStagnationIterationCount;  //!< Iterations without improvement before stopping, 0 if disabled.
+	bool                         mIsStopOnCollapse;          //!< True if a simplex of one discrete configuration stops the optimization.
+	lint                         mMaximumEvaluationCount;    //!< Objective evaluation budget, 0 if disabled.
+	qint64                       mTimeLimit;                 //!< Wall-clock limit in milliseconds, 0 if disabled.
+	lint                         mEvaluationCount;           //!< Objective evaluations of the last build().
+	QVector< std::shared_ptr< lpmleval::AbstractModel > >     mModelClones;      //!< Models of the workers 1..n during build().
+	QVector< std::shared_ptr< lpmleval::AbstractAnalytics > > mAnalyticsClones;  //!< Analytics of the workers 1..n during build().
 
 };
 
@@ -4,12 +4,56 @@
 namespace dkeval
 {
 
+namespace
+{
+
+//-----------------------------------------------------------------------------
+
+template < typename Index >
+QVector< int > excludedIndices( const Index& aIndex, const QStringList& aQueryKeys )
+{
+	//A query sample is not its own neighbour
+	QVector< int > indices;
+	for ( auto& key : aQueryKeys )
+	{
+		indices.push_back( aIndex.indexOf( key ) );
+	}
+
+	return indices;
+}
+
+//-----------------------------------------------------------------------------
+
+template < typename Index >
+QHash< QString, QMap< double, QString > > neighbourMaps( const Index& aIndex, const QStringList& aQueryKeys, const QVector< QVector< QPair< double, unsigned int > > >& aNeighbourLists )
+{
+	QHash< QString, QMap< double, QString > > kNN;
+
+	for ( int queryIndex = 0; queryIndex < aQueryKeys.size(); ++queryIndex )
+	{
+		QMap< double, QString > neighbours;
+
+		for ( auto& neighbour : aNeighbourLists.at( queryIndex ) )
+		{
+			neighbours.insertMulti( neighbour.first, aIndex.key( neighbour.second ) );
+		}
+
+		kNN.insert( aQueryKeys.at( queryIndex ), neighbours );
+	}
+
+	return kNN;
+}
+
+}
+
 //-----------------------------------------------------------------------------
 
 void Oversampling::build( const lpmldata::DataPackage& aDataPackage )
 {
 	mDataPackage = &aDataPackage;
 	mLabel       = mDataPackage->getMinorityLabel();
+	mSyntheticNames.clear();
+	mSyntheticRows = lpmldata::Array2D< double >();
 		
 	//calculate the difference between samples
 	mSamplesDifference = mDataPackage->getMajorityCount() - mDataPackage->getMinorityCount();
@@ -32,103 +76,129 @@ void Oversampling::build( const lpmldata::DataPackage& aDataPackage )
 	{
 		qDebug() << "Error - no valid method selected!\n";
 	}
-			
+
+	mDistances.reset(); //The package keeps the distance caches for the next stage
 }
 
 //-----------------------------------------------------------------------------
 
-QMap< double, QString > Oversampling::getNeighbours( const QString& aEvaluatedKey, const QStringList& aNeighbourKeys )
+QHash< QString, QMap< double, QString > > Oversampling::nearestNeighbours( const QStringList& aQueryKeys, const QStringList& aCandidateKeys, const int& aNearestNeighboursCount )
 {
-	QMap< double, QString > neighbours;
+	unsigned int neighbourCount = std::max( aNearestNeighboursCount, 0 );
 
-	auto evaluatedKeyFeatureVector = mDataPackage->featureVector( aEvaluatedKey );
-
-	
-	for each ( auto& neighbour in aNeighbourKeys )
+	//The package keeps the index of the candidates for the next stage
+	if ( mKnnBackend == "hnsw" )
 	{
-		if ( aEvaluatedKey != neighbour )
+		auto index         = mDataPackage->approximateNeighbourIndex( aCandidateKeys, mHnswConnectionCount, mHnswConstructionBreadth );
+		auto queries       = index->points( mDataPackage->featureDatabase(), aQueryKeys );
+		auto searchBreadth = unsigned( mHnswSearchBreadth );
+
+		if ( mHnswTargetRecall > 0.0 )
 		{
-			auto neighbourFeatureVector = mDataPackage->featureVector( neighbour );
-			auto distance               = mDataPackage->distance( evaluatedKeyFeatureVector, neighbourFeatureVector );
-		
-			neighbours.insertMulti( distance, neighbour );
+			searchBreadth = index->searchBreadthForRecall( *mDataPackage->nearestNeighbourIndex( aCandidateKeys ), neighbourCount, mHnswTargetRecall, searchBreadth );
 		}
+
+		return neighbourMaps( *index, aQueryKeys, index->nearestNeighbours( queries, neighbourCount, excludedIndices( *index, aQueryKeys ), searchBreadth ) );
 	}
-	return neighbours;
+
+	auto index   = mDataPackage->nearestNeighbourIndex( aCandidateKeys );
+	auto queries = index->points( mDataPackage->featureDatabase(), aQueryKeys );
+
+	return neighbourMaps( *index, aQueryKeys, index->nearestNeighbours( queries, neighbourCount, excludedIndices( *index, aQueryKeys ) ) );
 }
 
 //-----------------------------------------------------------------------------
 
-QMap< double, QString > Oversampling::getNearestNeighbours( const QString& aEvaluatedKey, const QStringList& aNeighbourKeys, const int& aNearestNeighboursCount )
+const lpmldata::PairwiseDistanceMatrix& Oversampling::distances()
 {
-	auto neighbours = getNeighbours( aEvaluatedKey, aNeighbourKeys );
-	
-	QMap< double, QString > kNN;
-	for ( int i = 0; i < neighbours.size(); ++i )
+	if ( mDistances == nullptr )
 	{
-		if ( i == aNearestNeighboursCount )
-		{
-			break;
-		}
-		else
-		{
-			kNN.insertMulti( neighbours.keys().at( i ), neighbours.values().at( i ) );
-		}
-		
+		mDistances = mDataPackage->pairwiseDistances( mDistancePrecision );
 	}
 
-	return kNN;
+	return *mDistances;
 }
 
-
 //-----------------------------------------------------------------------------
 
-void Oversampling::filterNearestNeighbours( QMap< double, QString >& aNeighbours, const int& aNeighboursNumber ) //Filter aNeighbours map - pass by &
+void Oversampling::generateSyntheticSamples( const QVector< QPair< QString, QString > >& aSamplePairs )
 {
-	auto counter = 0; 
-
-	for ( auto iterator = aNeighbours.begin(); iterator != aNeighbours.end(); )
-	{		
-		if ( counter >= aNeighboursNumber )
+	const lpmldata::TabularData& FDB = mDataPackage->featureDatabase();
+	int syntheticCount = aSamplePairs.size();
+	int columnCount    = FDB.columnCount();
+
+	//Convert the rows of the involved samples once
+	QHash< QString, int > sourceIndices;
+	QStringList sourceKeys;
+	for ( auto& samplePair : aSamplePairs )
+	{
+		for ( auto& key : { samplePair.first, samplePair.second } )
 		{
-			aNeighbours.erase( iterator++ );				
+			if ( !sourceIndices.contains( key ) )
+			{
+				sourceIndices.insert( key, sourceKeys.size() );
+				sourceKeys.push_back( key );
+			}
 		}
-		else
+	}
+
+	lpmldata::Array2D< double > sourceRows( sourceKeys.size(), columnCount, lpmldata::Array2DLayout::RowMajor );
+	int sourceCount = sourceKeys.size();
+
+	#pragma omp parallel for schedule( static )
+	for ( int sourceIndex = 0; sourceIndex < sourceCount; ++sourceIndex )
+	{
+		auto iterator = FDB.table().constFind( sourceKeys.at( sourceIndex ) );
+		if ( iterator == FDB.table().constEnd() ) continue;
+
+		const QVariantList& values = iterator.value();
+		double* row                = sourceRows.data() + ulint( sourceIndex ) * columnCount;
+
+		for ( int columnIndex = 0; columnIndex < std::min( columnCount, values.size() ); ++columnIndex )
 		{
-			iterator++;
+			row[ columnIndex ] = values.at( columnIndex ).toDouble();
 		}
-		counter++;		
 	}
-}
-
-//-----------------------------------------------------------------------------
 
-QMap< QString, QVector< double > > Oversampling::generateSyntheticSample( const QString& aSampleKey, const double& aDistance )
-{
-	QMap< QString, QVector< double > > synthticSample;
-	QVector< double > syntheticValues;	
-	
-	
+	//The gaps are drawn sequentially, the generated samples depend only on the random generator
 	std::uniform_real_distribution< double > dDice( 0.0, 1.0 );
-	std::uniform_int_distribution< int > iDice( 1, 1000000 );
-	auto randomDouble  = dDice( *mRng );
-	auto randomInt     = iDice( *mRng );
+	QVector< double > gaps( syntheticCount );
+	for ( auto& gap : gaps )
+	{
+		gap = dDice( *mRng );
+	}
 
+	//Sequential names, the first number is chosen so that none of them exists in the feature database
+	int firstNumber = FDB.rowCount();
+	QStringList names;
+	bool isCollision = true;
+
+	while ( isCollision )
+	{
+		names.clear();
+		names.reserve( syntheticCount );
+		isCollision = false;
 
-	QString syntheticName = "Synthetic sample " + QString::number( randomInt );
-	mSyntheticNames << syntheticName;
+		for ( int syntheticIndex = 0; syntheticIndex < syntheticCount && !isCollision; ++syntheticIndex )
+		{
+			names.push_back( "Synthetic sample " + QString::number( firstNumber + syntheticIndex ) );
+			isCollision = FDB.table().contains( names.last() );
+		}
 
-	double product           = randomDouble * aDistance;	
-	auto sampleFeatureVector = mDataPackage->featureVector( aSampleKey );		
+		firstNumber += syntheticCount;
+	}
 
+	mSyntheticNames = names;
+	mSyntheticRows  = lpmldata::Array2D< double >( syntheticCount, columnCount, lpmldata::Array2DLayout::RowMajor );
 
-	for ( auto& value : sampleFeatureVector )
+	#pragma omp parallel for schedule( static )
+	for ( int syntheticIndex = 0; syntheticIndex < syntheticCount; ++syntheticIndex )
 	{
-		syntheticValues.push_back( value.toDouble() + product );
-	}	
-	synthticSample.insert( syntheticName, syntheticValues );
-	
-	return synthticSample;
+		const double* sample    = sourceRows.data() + ulint( sourceIndices.value( aSamplePairs.at( syntheticIndex ).first ) ) * columnCount;
+		const double* neighbour = sourceRows.data() + ulint( sourceIndices.value( aSamplePairs.at( syntheticIndex ).second ) ) * columnCount;
+
+		lpmldata::DistanceKernels::interpolate( sample, neighbour, gaps.at( syntheticIndex ), columnCount, mSyntheticRows.data() + ulint( syntheticIndex ) * columnCount );
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -136,12 +206,11 @@ QMap< QString, QVector< double > > Oversampling::generateSyntheticSample( const
 QStringList Oversampling::borderlineMajorities( const QStringList& aMinorityKeys, const QStringList& aMajorityKeys )
 {
 	QStringList borderlineMajorities;
+	auto neighbourMaps = nearestNeighbours( aMinorityKeys, aMajorityKeys, mM_NeighboursNumber ); //mM_NeighboursNumber == mNN, k2
 
 	for ( auto& element : aMinorityKeys )
 	{
-		auto neighbours = getNeighbours( element, aMajorityKeys );
-
-		filterNearestNeighbours( neighbours, mM_NeighboursNumber ); //mM_NeighboursNumber == mNN, k2
+		auto neighbours = neighbourMaps.value( element );
 
 		for ( auto& name : neighbours.values() )
 		{
@@ -159,12 +228,11 @@ QStringList Oversampling::borderlineMajorities( const QStringList& aMinorityKeys
 QStringList Oversampling::borderlineMinorities( const QStringList& aMinorityKeys, const QStringList& aMajorityKeys )
 {
 	QStringList borderlineMinorities;
+	auto neighbourMaps = nearestNeighbours( aMajorityKeys, aMinorityKeys, mN_NeighboursNumber ); //mN_NeighboursNumber == k3
 
 	for ( auto& element : aMajorityKeys )
 	{
-		auto neighbours = getNeighbours( element, aMinorityKeys );
-
-		filterNearestNeighbours( neighbours, mN_NeighboursNumber ); //mN_NeighboursNumber == k3  
+		auto neighbours = neighbourMaps.value( element );
 
 		for ( auto& name : neighbours.values() )
 		{
@@ -184,10 +252,8 @@ double Oversampling::closenessFactor( const QString& aMajorityKey, const QString
 	const int cFactor = 100; //Suggested by the literature
 	const int cMax    = 2; //Suggested by the literature
 	
-	auto majorityFeatureVector = mDataPackage->featureVector( aMajorityKey );
-	auto minorityFeatureVector = mDataPackage->featureVector( aMinorityKey );
-	auto distance              = mDataPackage->distance( majorityFeatureVector, minorityFeatureVector );
-	auto vectorLenght          = majorityFeatureVector.size();
+	auto distance     = distances().distance( aMajorityKey, aMinorityKey );
+	auto vectorLenght = mDataPackage->featureCount();
 
 	auto normalized = distance / vectorLenght;	
 	auto inverse    = 1 / normalized;
@@ -264,26 +330,14 @@ QMap< double, QString > Oversampling::selectionProbabilities( QMap< double, QStr
 double Oversampling::averageMinimalDistance( const QStringList& aMinorityKeys )
 {
 	auto minimalDistanceSum = 0.0;
+	auto neighbourMaps      = nearestNeighbours( aMinorityKeys, aMinorityKeys, 1 );
 
-	for ( auto& firstKey : aMinorityKeys )
+	for ( auto& neighbours : neighbourMaps )
 	{
-		QVector< double > minimalDistances;
-
-		auto firstFeatureVector = mDataPackage->featureVector( firstKey );
-
-		for ( auto& secondKey : aMinorityKeys )
+		if ( !neighbours.isEmpty() )
 		{
-			if ( firstKey != secondKey )
-			{
-				auto secondFeatureVector = mDataPackage->featureVector( secondKey );
-				auto distance            = mDataPackage->distance( firstFeatureVector, secondFeatureVector );
-
-				minimalDistances.push_back( distance );
-			}			
+			minimalDistanceSum += neighbours.firstKey();
 		}
-		std::sort( minimalDistances.begin(), minimalDistances.end() );
-
-		minimalDistanceSum += minimalDistances.first();
 	}
 	
 	return 1 / minimalDistanceSum;
@@ -293,23 +347,23 @@ double Oversampling::averageMinimalDistance( const QStringList& aMinorityKeys )
 
 double Oversampling::averageDistance( const QStringList& aMinorityKeys )
 {
-	QVector< double > distances;
 	double sum = 0.0;
+	int count  = 0;
+	auto minorityIndices = distances().indicesOf( aMinorityKeys );
 
-	for ( auto& minorityKey : aMinorityKeys )
+	for ( auto firstIndex : minorityIndices )
 	{
-		auto neighbours = getNeighbours( minorityKey, aMinorityKeys );
-
-		for ( auto& value : neighbours.keys() )
+		for ( auto secondIndex : minorityIndices )
 		{
-			distances.push_back( value );
+			if ( firstIndex != secondIndex )
+			{
+				sum += distances().distance( firstIndex, secondIndex );
+				++count;
+			}
 		}
 	}
 
-	std::for_each( distances.begin(), distances.end(),
-		 [ &sum ]( double x ) { sum += x; } );
-
-	auto average = sum / distances.size();
+	auto average = sum / count;
 
 	return average;
 }
@@ -318,23 +372,23 @@ double Oversampling::averageDistance( const QStringList& aMinorityKeys )
 
 double Oversampling::averageClusterDistance( const QStringList& aFirstCluster, const QStringList& aSecondCluster )
 {
-	QVector< double > distances;
 	double sum = 0.0;
+	int count  = 0;
+	auto secondIndices = distances().indicesOf( aSecondCluster );
 
-	for ( auto& firstElement : aFirstCluster )
+	for ( auto firstIndex : distances().indicesOf( aFirstCluster ) )
 	{
-		auto clusterDistances = getNeighbours( firstElement, aSecondCluster );
-
-		for ( auto& value : clusterDistances.keys() )
+		for ( auto secondIndex : secondIndices )
 		{
-			distances.push_back( value );
+			if ( firstIndex != secondIndex )
+			{
+				sum += distances().distance( firstIndex, secondIndex );
+				++count;
+			}
 		}
 	}
 
-	std::for_each( distances.begin(), distances.end(),
-		[ &sum ]( double x ) { sum += x; } );
-
-	auto average = sum / distances.size();
+	auto average = sum / count;
 
 	return average;
 }
@@ -439,46 +493,52 @@ void Oversampling::findClusters( QVector< QStringList >& aInitialClusters )
 void Oversampling::smote()
 {	
 	auto minorityKeys     = mDataPackage->getMinorityKeys();
+	auto neighbourMaps    = nearestNeighbours( minorityKeys, minorityKeys, mNeighboursNumber );
 	int oversampplingRate = mOversamplingAmount / 100;	
+
+	//Choose every sample and neighbour pair first, the rows are generated in one block
+	QVector< QPair< QString, QString > > samplePairs;
 	
 	if ( mAutomatic == true )
 	{
-		int counter = 0;
+		samplePairs.reserve( std::max( mSamplesDifference, 0 ) );
 
 		std::uniform_int_distribution< int > iDice( 0, minorityKeys.size() - 1 );
 
-		while ( counter < mSamplesDifference )
+		while ( samplePairs.size() < mSamplesDifference && !minorityKeys.isEmpty() )
 		{
 			auto randomInteger = iDice( *mRng );
 			auto element       = minorityKeys.at( randomInteger );
-			auto neighbours    = getNeighbours( element, minorityKeys );
-			filterNearestNeighbours( neighbours, mNeighboursNumber );
+			auto neighbours    = neighbourMaps.value( element ).values();
 
+			if ( neighbours.isEmpty() ) break;
 
-			std::uniform_int_distribution< int > iDice( 0, mNeighboursNumber - 1 );
-			randomInteger                  = iDice( *mRng );
-			auto choosenNeighbourDisstance = neighbours.keys().at( randomInteger );
-			mSyntheticSamples.unite( generateSyntheticSample( element, choosenNeighbourDisstance ) );
-
-			counter++;
+			std::uniform_int_distribution< int > iDice( 0, neighbours.size() - 1 );
+			randomInteger = iDice( *mRng );
+			samplePairs.push_back( qMakePair( element, neighbours.at( randomInteger ) ) );
 		}
 	}
 	else
 	{
-		for each ( auto& element in minorityKeys )
+		samplePairs.reserve( minorityKeys.size() * oversampplingRate );
+
+		for ( auto& element : minorityKeys )
 		{
-			auto neighbours = getNeighbours( element, minorityKeys );
-			filterNearestNeighbours( neighbours, mNeighboursNumber );
+			auto neighbours = neighbourMaps.value( element ).values();
+
+			if ( neighbours.isEmpty() ) continue;
 
-			for ( unsigned int index = 0; index < oversampplingRate; ++index )
+			std::uniform_int_distribution< int > iDice( 0, neighbours.size() - 1 );
+
+			for ( int index = 0; index < oversampplingRate; ++index )
 			{
-				std::uniform_int_distribution< int > iDice( 0, mNeighboursNumber - 1 );
-				auto randomInteger            = iDice( *mRng );
-				auto choosenNeighbourDistance = neighbours.keys().at( randomInteger );
-				mSyntheticSamples.unite( generateSyntheticSample( element, choosenNeighbourDistance ) );
+				auto randomInteger = iDice( *mRng );
+				samplePairs.push_back( qMakePair( element, neighbours.at( randomInteger ) ) );
 			}
 		}
-	}	
+	}
+
+	generateSyntheticSamples( samplePairs );
 }
 
 //-----------------------------------------------------------------------------
@@ -489,13 +549,12 @@ void Oversampling::bSmote()
 	int oversampplingRate = mOversamplingAmount / 100;
 	auto minorityKeys     = mDataPackage->getMinorityKeys();
 	auto majorityKeys     = mDataPackage->getMajorityKeys();
-	auto allKeys          = mDataPackage->featureDatabase().keys();
+	auto allNeighbourMaps = nearestNeighbours( minorityKeys, QStringList(), mM_NeighboursNumber ); //mM_NeighboursNumber == mNN
 
 	for each ( auto& element in minorityKeys )
 	{
 		int majorityNeighboursCount = 0;
-		auto neighbours             = getNeighbours( element, allKeys );		
-		filterNearestNeighbours( neighbours, mM_NeighboursNumber ); //mM_NeighboursNumber == mNN
+		auto neighbours             = allNeighbourMaps.value( element );
 
 		for ( auto& name : neighbours.values() )
 		{
@@ -513,95 +572,56 @@ void Oversampling::bSmote()
 		}
 	}
 
+	//Without borderline minorities the data is left unchanged
 	if ( !danger.isEmpty() )
 	{
-		for each( auto& element in danger )
+		auto neighbourMaps = nearestNeighbours( danger, minorityKeys, mNeighboursNumber ); //mNeighboursNumber == kNN
+		QVector< QPair< QString, QString > > samplePairs;
+		samplePairs.reserve( danger.size() * oversampplingRate );
+
+		for ( auto& element : danger )
 		{
-			auto neighbours = getNeighbours( element, minorityKeys );
-			filterNearestNeighbours( neighbours, mNeighboursNumber ); //mNeighboursNumber == kNN
+			auto neighbours = neighbourMaps.value( element ).values();
+
+			if ( neighbours.isEmpty() ) continue;
 
+			std::uniform_int_distribution< int > iDice( 0, neighbours.size() - 1 );
 
 			for ( int index = 0; index < oversampplingRate; ++index )
 			{
-				std::uniform_int_distribution< int > iDice( 0, mNeighboursNumber - 1 );
-				auto randomInteger            = iDice( *mRng );
-				auto choosenNeighbourDistance = neighbours.keys().at( randomInteger );
-				mSyntheticSamples.unite( generateSyntheticSample( element, choosenNeighbourDistance ) );
+				auto randomInteger = iDice( *mRng );
+				samplePairs.push_back( qMakePair( element, neighbours.at( randomInteger ) ) );
 			}
 		}
-	}
-	else
-	{
-		//Fill original values
-		auto keys = mDataPackage->featureDatabase().keys();		
-		
-		for ( auto& key : keys )
-		{
-			QVector< double > featureVector;
-			auto vector = mDataPackage->featureDatabase().value( key );
 
-			for ( auto& value : vector )
-			{
-				featureVector.push_back( value.toDouble() );
-			}
-
-			mSyntheticSamples.insert( key, featureVector );
-		}
+		generateSyntheticSamples( samplePairs );
 	}
-	
 }
 
 //-----------------------------------------------------------------------------
 
 void Oversampling::randomOVersampling()
 {
-	auto FDB              = mDataPackage->featureDatabase();
 	auto minorityKeys     = mDataPackage->getMinorityKeys();
 	auto majorityKeys     = mDataPackage->getMajorityKeys();
 	auto oversamplingRate = majorityKeys.size() - minorityKeys.size();
 
-	QMap< QString, QVariantList > minorityFeatures;
-
-	for ( auto& key : minorityKeys )
-	{
-		auto feature = FDB.value( key );	
-
-		minorityFeatures.insert( key, feature );
-	}
+	if ( minorityKeys.isEmpty() ) return;
 		
 	std::uniform_int_distribution< int > dice( 0, minorityKeys.size() - 1 );
 
-	QStringList choosenSamples;
+	//Identical pairs copy the chosen minority samples
+	QVector< QPair< QString, QString > > samplePairs;
+	samplePairs.reserve( std::max( oversamplingRate, 0 ) );
 
 	for ( int i = 0; i < oversamplingRate; ++i )
 	{
-		int randomNumber = dice( *mRng );
-		auto key         = minorityKeys.at( randomNumber );
+		auto key = minorityKeys.at( dice( *mRng ) );
 
-		choosenSamples.push_back( key );
+		samplePairs.push_back( qMakePair( key, key ) );
 	}
 
-	for ( int i = 0; i < choosenSamples.size(); ++i )
-	{
-		auto key = choosenSamples.at( i );
-
-		for ( int j = 0; j < minorityFeatures.size(); ++j )
-		{
-			auto name          = minorityFeatures.keys().at( j );
-			auto featureList   = minorityFeatures.values().at( j );
-			auto featureVector = toQVectorDouble( featureList );
-
-			if ( key == name )
-			{
-				int random        = dice( *mRng );
-				QString synthName = "Synthetic sample no:" + QString::number( i ) + QString::number( j ) + QString::number( random );
-
-				mSyntheticSamples.insert( synthName, featureVector );
-				mSyntheticNames << synthName;
-				continue;
-			}
-		}
-	}
+	generateSyntheticSamples( samplePairs );
 }
 
 //-----------------------------------------------------------------------------
@@ -612,7 +632,7 @@ lpmldata::DataPackage Oversampling::run( const lpmldata::DataPackage& aDataPacka
 	lpmldata::TabularData updatedFDB;
 	lpmldata::TabularData updatedLDB;
 		
-	updatedFDB = aDataPackage.sampleDatabaseSubset( mSyntheticSamples );
+	updatedFDB = aDataPackage.sampleDatabaseSubset( mSyntheticNames, mSyntheticRows );
 	updatedLDB = aDataPackage.labelDatabaseSubset( mSyntheticNames, mLabel );	
 
 	lpmldata::DataPackage result( updatedFDB, updatedLDB );
@@ -13,10 +13,14 @@
 
 #include <Evaluation/Export.h>
 #include <Evaluation/AbstractTDPAction.h>
+#include <DataRepresentation/PairwiseDistanceMatrix.h>
+#include <DataRepresentation/Array2D.h>
 #include <QDebug>
+#include <QHash>
 #include <qmath.h>
 #include <random>
 #include <algorithm>
+#include <memory>
 
 namespace dkeval
 {
@@ -41,12 +45,19 @@ public:
 		mSelectionThreshold( 0.0 ),
 		mMethod(),
 		mLabel( 0 ),
-		mSyntheticSamples(),
 		mSyntheticPairs(),
 		mSyntheticNames(),
+		mSyntheticRows(),
 		mAutomatic( false ),
 		mParameters(),
-		mDataPackage( nullptr )
+		mDataPackage( nullptr ),
+		mDistances(),
+		mDistancePrecision( lpmldata::DistancePrecision::Double ),
+		mKnnBackend( "exact" ),
+		mHnswConnectionCount( 16 ),
+		mHnswConstructionBreadth( 200 ),
+		mHnswSearchBreadth( 64 ),
+		mHnswTargetRecall( 0.0 )
 	{
 		//Create parameters
 		if ( mSettings == nullptr )
@@ -98,6 +109,25 @@ public:
 			bool isAutimatic;
 			mAutomatic = mSettings->value( "Oversampling/auto" ).toBool();	
 
+			//Optional, single precision halves the memory of the shared distance matrix
+			if ( mSettings->value( "Oversampling/distancePrecision" ).toString() == "single" )
+			{
+				mDistancePrecision = lpmldata::DistancePrecision::Single;
+			}
+
+			//Optional, the approximate HNSW graph replaces the exact k-d tree for wide and large cohorts
+			mKnnBackend = mSettings->value( "Oversampling/knnBackend", "exact" ).toString();
+			if ( mKnnBackend != "exact" && mKnnBackend != "hnsw" )
+			{
+				qDebug() << "Oversampling - Error: Invalid parameter knnBackend, exact search is used";
+				mKnnBackend = "exact";
+			}
+
+			mHnswConnectionCount     = std::max( mSettings->value( "Oversampling/hnswM", 16 ).toInt(), 2 );
+			mHnswConstructionBreadth = std::max( mSettings->value( "Oversampling/hnswEfConstruction", 200 ).toInt(), 1 );
+			mHnswSearchBreadth       = std::max( mSettings->value( "Oversampling/hnswEfSearch", 64 ).toInt(), 1 );
+			mHnswTargetRecall        = mSettings->value( "Oversampling/hnswTargetRecall", 0.0 ).toDouble(); //0 keeps hnswEfSearch
+
 			mParameters.insert( "Oversampling/neighboursNumber", mNeighboursNumber );
 			mParameters.insert( "Oversampling/m_neighboursNumber", mM_NeighboursNumber );
 			mParameters.insert( "Oversampling/n_neighboursNumber", mN_NeighboursNumber );
@@ -142,11 +172,15 @@ public:
 
 private:
 
-	QMap< double, QString > getNeighbours( const QString& aSampleKey, const QStringList& aSampleKeys );
-	QMap< double, QString > getNearestNeighbours( const QString& aSampleKey, const QStringList& aSampleKeys, const int& aNearestNeighboursCount );	
-	void filterNearestNeighbours( QMap< double, QString >& aNeighbours, const int& aNeighboursNumber );
+	QHash< QString, QMap< double, QString > > nearestNeighbours( const QStringList& aQueryKeys, const QStringList& aCandidateKeys, const int& aNearestNeighboursCount );
+	const lpmldata::PairwiseDistanceMatrix& distances();
 
-	QMap< QString, QVector< double > > generateSyntheticSample( const QString& aSampleKey, const double& aDistance );
+	/*!
+	* \brief Generates one synthetic row for each pair of sample and chosen neighbour into a preallocated dense block.
+	* \details The row is a random point on the segment between the two samples, a pair of identical keys copies the sample.
+	* The random gaps are drawn up front, the rows are interpolated in parallel. The names are sequential and unique within the feature database.
+	*/
+	void generateSyntheticSamples( const QVector< QPair< QString, QString > >& aSamplePairs );
 	QStringList borderlineMajorities( const QStringList& aMinorityKeys, const QStringList& aMajorityKeys );
 	QStringList borderlineMinorities( const QStringList& aMinorityKeys, const QStringList& aMajorityKeys );
 
@@ -180,12 +214,19 @@ private:
 	bool mAutomatic;
 	double mSelectionThreshold;
 	QString mMethod;
-	QMap< QString, QVector< double > > mSyntheticSamples;
 	QList< QPair< QString, double > > mSyntheticPairs;
 	QStringList mSyntheticNames;
+	lpmldata::Array2D< double > mSyntheticRows; //!< One row per name of mSyntheticNames.
 	std::mt19937* mRng;
 	QMap< QString, QVariant > mParameters;
 	const lpmldata::DataPackage* mDataPackage;
+	std::shared_ptr< const lpmldata::PairwiseDistanceMatrix > mDistances;
+	lpmldata::DistancePrecision mDistancePrecision;
+	QString mKnnBackend;                //!< "exact" k-d tree or approximate "hnsw" graph.
+	int mHnswConnectionCount;           //!< HNSW links per sample (M).
+	int mHnswConstructionBreadth;       //!< HNSW candidate list size of the build (efConstruction).
+	int mHnswSearchBreadth;             //!< HNSW candidate list size of the queries (efSearch).
+	double mHnswTargetRecall;           //!< If positive, efSearch is raised until the probe recall against the exact search reaches it.
 };
 
 }
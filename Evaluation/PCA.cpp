@@ -7,35 +7,14 @@ namespace dkeval
 
 void PCA::build( const lpmldata::DataPackage& aDataPackage )
 {
-	//Create a matrix from original dataset
-	auto FDB     = aDataPackage.featureDatabase();
-	auto headers = FDB.headerNames();
-	auto keys    = aDataPackage.commonKeys();		
+	mChoosenEigenvectors.clear();
 
-	std::sort( keys.begin(), keys.end() );
-
-	auto rowsCount    = keys.size();
-	auto columnsCount = headers.size();
-
-	lpmldata::Array2D< double > originalMatrix( rowsCount, columnsCount );		
-
-	for ( int i = 0; i < rowsCount; ++i ) 
-	{
-		for ( int j = 0; j < columnsCount; ++j )
-		{
-			auto key = keys.at( i );
-			auto cellValue = FDB.valueAt( key, j ).toDouble();
-			
-			originalMatrix.operator()( i, j ) = cellValue;		
-		}				
-	}
-
-	//Recenter the dataset
-	auto recenteredFDB = recenter( aDataPackage );
-	
+	//Compute the centering statistics of the training features
+	auto deviations = recenter( aDataPackage );
+	auto FDB        = aDataPackage.featureDatabase();
 
 	//Compute eigenvalues and eigenvectors
-	auto eigenParams = eigens( recenteredFDB );
+	auto eigenParams = eigens( FDB );
 	auto eigenValues = eigenParams.keys();
 		
 		
@@ -101,69 +80,90 @@ void PCA::build( const lpmldata::DataPackage& aDataPackage )
 			}
 		}
 	}
-	
+
+	//Store the choosen eigenvectors as a dense projection matrix
+	buildProjection( deviations );
 }
 
 //-----------------------------------------------------------------------------
 
-lpmldata::TabularData PCA::recenter( const lpmldata::DataPackage& aDataPackage )
+QVector< double > PCA::recenter( const lpmldata::DataPackage& aDataPackage )
 {
-	
-	auto FDB        = aDataPackage.featureDatabase();
-	auto headers    = FDB.headerNames();
+	const auto& FDB = aDataPackage.featureDatabase();
 
-	//Read out the feature values for each sample from the dataset 
-	QVector< QVector< double > > modifiedFeatureValues;
-	QVector< QString > keys;
-	
-	for ( int i = 0; i < 1; ++i )
+	mFeatureNames = FDB.headerNames();
+
+	int featureCount = mFeatureNames.size();
+
+	//Mean and deviation of each feature from the statistics cached by the feature database, the eigenvectors are computed over the correlation matrix
+	auto statistics = FDB.columnStatistics();
+
+	mCenters.fill( 0.0, featureCount );
+	QVector< double > deviations( featureCount, 1.0 );
+
+	for ( int j = 0; j < featureCount; ++j )
 	{
-		for ( int j = 0; j < FDB.keys().size(); ++j )
+		if ( statistics.count( j ) > 0 )
 		{
-			auto key =  FDB.keys().at( j );
+			mCenters[ j ] = statistics.mean( j );
 
-			keys.push_back( key );
+			//Constant features keep the deviation of 1, only centering is applied
+			if ( statistics.deviation( j ) > 0.0 )
+			{
+				deviations[ j ] = statistics.deviation( j );
+			}
 		}
 	}
 
-	std::sort( keys.begin(), keys.end() );
+	return deviations;
+}
 
-	for ( int i = 0; i < headers.size(); ++i )
+//-----------------------------------------------------------------------------
+
+lpmldata::Array2D< double > PCA::denseRows( const lpmldata::TabularData& aFDB, const QStringList& aKeys, const QVector< int >& aColumnIndices ) const
+{
+	int columnCount = aColumnIndices.size();
+	const auto& table = aFDB.table();
+
+	lpmldata::Array2D< double > rows( aKeys.size(), columnCount, lpmldata::Array2DLayout::RowMajor );
+
+	for ( int i = 0; i < aKeys.size(); ++i )
 	{
-		QVector< double > featureValues;
-		
-		for ( int j = 0; j < FDB.keys().size(); ++j )
+		const QVariantList& featureRow = table.constFind( aKeys.at( i ) ).value();
+		auto row = rows.row( i );
+
+		for ( int j = 0; j < columnCount; ++j )
 		{
-			auto key          = keys.at( j );
-			auto featureValue = FDB.valueAt( key, i ).toDouble();
-			
-			featureValues.push_back( featureValue );
-		}		
-		
+			row[ j ] = featureRow.at( aColumnIndices.at( j ) ).toDouble();
+		}
+	}
 
-		//Calculate mean value for each feature	
-		auto denominator        = featureValues.size();	
+	return rows;
+}
 
-		auto sumOfFeatureValues = std::accumulate( featureValues.begin(), featureValues.end(), 0.0 );
+//-----------------------------------------------------------------------------
 
-		auto mean               = sumOfFeatureValues / denominator;		
+void PCA::buildProjection( const QVector< double >& aScales )
+{
+	int featureCount   = mFeatureNames.size();
+	int componentCount = mChoosenEigenvectors.size();
 
+	mProjection = lpmldata::Array2D< double >( featureCount, componentCount, lpmldata::Array2DLayout::RowMajor );
+	mComponentNames.clear();
 
-		//Substract mean value from the feature values
-		QVector< double >substractedFeatureValues;
+	for ( int c = 0; c < componentCount; ++c )
+	{
+		mComponentNames.append( "A::B::Feature" + QString::number( c + 1 ) );
 
-		for ( double& element : featureValues )
+		const auto& eigenvector = mChoosenEigenvectors.at( c );
+		int size = std::min( eigenvector.size(), featureCount );
+
+		//Fold the feature scaling into the projection, so the transform only needs to subtract the centers
+		for ( int k = 0; k < size; ++k )
 		{
-			substractedFeatureValues.push_back( element - mean ); 
+			mProjection( k, c ) = eigenvector.at( k ) / aScales.at( k );
 		}
-
-		modifiedFeatureValues.push_back( substractedFeatureValues );
 	}
-	
-
-	//Return the recentered dataset
-	lpmldata::TabularData updatedFDB = aDataPackage.featureDatabase();
-	return updatedFDB;
 }
 
 //-----------------------------------------------------------------------------
@@ -562,92 +562,167 @@ double PCA::standardDeviation( const QVector< double >& aFeatureVector, double a
 
 lpmldata::DataPackage PCA::run( const lpmldata::DataPackage& aDataPackage )
 {
-	auto FDB = aDataPackage.featureDatabase();
-	auto headers = FDB.headerNames();
-	auto keys = aDataPackage.commonKeys();
+	if ( !isFitted() )
+	{
+		qDebug() << "PCA - Warning: The transform is not fitted, the datapackage is returned unchanged";
+
+		lpmldata::DataPackage result( aDataPackage.featureDatabase(), aDataPackage.labelDatabase() );
+
+		return result;
+	}
 
-	if ( mChoosenEigenvectors.isEmpty() )
+	bool isTransformed;
+	auto transformedFDB = transform( aDataPackage.featureDatabase(), &isTransformed );
+
+	if ( !isTransformed )
 	{
-		for ( auto& feature : headers )
-		{
-			QVector< double > featureVector;
+		qDebug() << "PCA - Error: The datapackage cannot be transformed, it is returned unchanged";
 
-			for ( auto& key : keys )
-			{				
-				featureVector.push_back( FDB.valueAt( key, headers.indexOf( feature ) ).toDouble() );
-			}
-			mChoosenEigenvectors.push_back( featureVector );
-		}
 		lpmldata::DataPackage result( aDataPackage.featureDatabase(), aDataPackage.labelDatabase() );
 
 		return result;
 	}
-	else
-	{	
 
-		lpmldata::Array2D< double > originalMatrix( keys.size(), headers.size() );
+	lpmldata::DataPackage result( transformedFDB, aDataPackage.labelDatabase() );
 
-		for ( int i = 0; i < keys.size(); ++i )
-		{
-			for ( int j = 0; j < headers.size(); ++j )
-			{
-				auto key = keys.at( i );
-				auto cellValue = FDB.valueAt( key, j ).toDouble();
+	return result;
+}
 
-				originalMatrix.operator()( i, j ) = cellValue;
-			}
-		}
+//-----------------------------------------------------------------------------
+
+lpmldata::TabularData PCA::transform( const lpmldata::TabularData& aFDB, bool* aIsValid ) const
+{
+	if ( aIsValid != nullptr )
+	{
+		*aIsValid = true;
+	}
+
+	lpmldata::TabularData transformedFDB;
+	transformedFDB.setHeader( mComponentNames );
 
+	//Match the fitted features by name
+	auto headers = aFDB.headerNames();
+	QHash< QString, int > headerIndices;
 
-		//Create new feature names
-		QStringList featureNames;
+	for ( int i = 0; i < headers.size(); ++i )
+	{
+		headerIndices.insert( headers.at( i ), i );
+	}
 
-		for ( int i = 0; i < mChoosenEigenvectors.size(); ++i )
+	QVector< int > columnIndices;
+
+	for ( auto& featureName : mFeatureNames )
+	{
+		auto columnIndex = headerIndices.value( featureName, -1 );
+
+		if ( columnIndex < 0 )
 		{
-			QString name = "A::B::Feature" + QString::number( i + 1 );
+			qDebug() << "PCA - Error: Feature" << featureName << "is missing from the database to transform";
 
-			featureNames.append( name );
+			if ( aIsValid != nullptr )
+			{
+				*aIsValid = false;
+			}
+			return transformedFDB;
 		}
 
+		columnIndices.push_back( columnIndex );
+	}
+
+	auto keys          = aFDB.keys();
+	int rowCount       = keys.size();
+	int featureCount   = mFeatureNames.size();
+	int componentCount = mComponentNames.size();
 
-		//Create new dataset
-		QVector< QVector< double > > features;
+	//Center the dense feature block
+	auto rows = denseRows( aFDB, keys, columnIndices );
 
-		for ( int i = 0; i < mChoosenEigenvectors.size(); ++i )
+	for ( int i = 0; i < rowCount; ++i )
+	{
+		auto row = rows.row( i );
+
+		for ( int j = 0; j < featureCount; ++j )
 		{
-			auto vector = mChoosenEigenvectors.at( i );
+			row[ j ] -= mCenters.at( j );
+		}
+	}
 
-			QVector< double > feature;
+	//Project all samples at once
+	lpmldata::Array2D< double > components( rowCount, componentCount, lpmldata::Array2DLayout::RowMajor );
+	lpmldata::Array2D< double >::gemm( rows, mProjection, components );
 
-			for ( int j = 0; j < originalMatrix.rowCount(); ++j )
-			{
-				double sum = 0.0;
+	auto& table = transformedFDB.table();
+	table.reserve( rowCount );
 
-				for ( int k = 0; k < vector.size(); ++k )
-				{
-					auto originalValue = originalMatrix.at( j, k );
-					auto element = vector.at( k );
+	for ( int i = 0; i < rowCount; ++i )
+	{
+		auto componentValues = components.row( i );
 
-					auto value = originalValue * element;
+		QVariantList componentRow;
+		componentRow.reserve( componentCount );
 
-					sum += value;
-				}
-				feature.push_back( sum );
-			}
-			features.push_back( feature );
+		for ( int c = 0; c < componentCount; ++c )
+		{
+			componentRow.append( componentValues[ c ] );
 		}
-				
-		//Save the obtained dataset
-		lpmldata::TabularData updatedFDB = aDataPackage.featureDatabaseSubset( features, featureNames );
 
-		lpmldata::DataPackage result( updatedFDB, aDataPackage.labelDatabase() );
+		table.insert( keys.at( i ), componentRow );
+	}
 
-		return result;
+	return transformedFDB;
+}
+
+//-----------------------------------------------------------------------------
+
+void PCA::save( QDataStream& aOut ) const
+{
+	aOut << qint32( mPreservationPercentage )
+		 << mFeatureNames
+		 << mComponentNames
+		 << mCenters
+		 << mChoosenEigenvectors
+		 << quint32( mProjection.rowCount() )
+		 << quint32( mProjection.columnCount() );
+
+	for ( unsigned int i = 0; i < mProjection.rowCount(); ++i )
+	{
+		for ( unsigned int j = 0; j < mProjection.columnCount(); ++j )
+		{
+			aOut << mProjection( i, j );
+		}
 	}
+}
+
+//-----------------------------------------------------------------------------
+
+void PCA::load( QDataStream& aIn )
+{
+	qint32 preservationPercentage;
+	quint32 rowCount;
+	quint32 columnCount;
+
+	aIn >> preservationPercentage
+		>> mFeatureNames
+		>> mComponentNames
+		>> mCenters
+		>> mChoosenEigenvectors
+		>> rowCount
+		>> columnCount;
 
+	mProjection = lpmldata::Array2D< double >( rowCount, columnCount, lpmldata::Array2DLayout::RowMajor );
 
+	for ( unsigned int i = 0; i < rowCount; ++i )
+	{
+		for ( unsigned int j = 0; j < columnCount; ++j )
+		{
+			aIn >> mProjection( i, j );
+		}
+	}
+
+	mPreservationPercentage = preservationPercentage;
+	mParameters.insert( "PCA/preservationPercentage", mPreservationPercentage );
 }
 
 //-----------------------------------------------------------------------------
 
-}
\ No newline at end of file
+}
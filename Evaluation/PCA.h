@@ -15,6 +15,7 @@
 #include <Evaluation/AbstractTDPAction.h>
 #include <Evaluation/CovarianceMatrix.h>
 #include <DataRepresentation/Array2D.h>
+#include <QDataStream>
 #include <QDebug>
 #include <qmath.h>
 #include <random>
@@ -43,6 +44,10 @@ public:
 		AbstractTBPAction( aSettings ),
 		mPreservationPercentage( 0 ),
 		mChoosenEigenvectors(),
+		mFeatureNames(),
+		mComponentNames(),
+		mCenters(),
+		mProjection(),
 		mParameters()
 	{
 		//Create parameters
@@ -83,6 +88,32 @@ public:
 	*/
 	lpmldata::DataPackage run( const lpmldata::DataPackage& aDataPackage ) override;	
 
+	/*!
+	* \brief Projects a feature database with the fitted transform. Features are matched by name, so the input may contain additional columns
+	* \param [in] aFDB The feature database to transform
+	* \param [out] aIsValid If not nullptr, set to false when a fitted feature is missing from aFDB, true otherwise
+	* \return lpmldata::TabularData of principal component values with the same keys as the input, only the header if a fitted feature is missing
+	*/
+	lpmldata::TabularData transform( const lpmldata::TabularData& aFDB, bool* aIsValid = nullptr ) const;
+
+	/*!
+	* \brief Checks if the transform was fitted by build() or load()
+	* \return true if the projection matrix is available
+	*/
+	bool isFitted() const { return mProjection.rowCount() > 0 && mProjection.columnCount() > 0; }
+
+	/*!
+	* \brief Saves the fitted transform (feature names, centering statistics and projection matrix)
+	* \param [in] aOut The output data stream
+	*/
+	void save( QDataStream& aOut ) const;
+
+	/*!
+	* \brief Loads a fitted transform previously stored with save()
+	* \param [in] aIn The input data stream
+	*/
+	void load( QDataStream& aIn );
+
 
 	/*!
 	* \brief Unique class ID
@@ -105,7 +136,9 @@ public:
 
 private:
 
-	lpmldata::TabularData recenter( const lpmldata::DataPackage& aDataPackage );
+	lpmldata::Array2D< double > denseRows( const lpmldata::TabularData& aFDB, const QStringList& aKeys, const QVector< int >& aColumnIndices ) const;
+	QVector< double > recenter( const lpmldata::DataPackage& aDataPackage );
+	void buildProjection( const QVector< double >& aScales );
 	QMap< double, QVector< double > > eigens( lpmldata::TabularData& aDataBase );
 	QVector< double > projection( QVector< double >& aInitial, const QVector< double >& aOrthonormal ) ;
 	QVector< double > normalize( QVector< double >& aOrthonormal );
@@ -117,6 +150,10 @@ private:
 
 	int mPreservationPercentage;
 	QVector< QVector< double > > mChoosenEigenvectors;
+	QStringList mFeatureNames;      //!< Names of the features the transform was fitted on.
+	QStringList mComponentNames;    //!< Names of the generated principal component features.
+	QVector< double > mCenters;     //!< Mean of each fitted feature.
+	lpmldata::Array2D< double > mProjection;  //!< Row-major projection matrix of size featureCount x componentCount, feature scaling folded in.
 	QMap< QString, QVariant > mParameters;
 };
 
@@ -159,6 +159,21 @@ Pair PatientFoldGenerator::fold( int aFoldIndex )
 
 //-----------------------------------------------------------------------------
 
+void PatientFoldGenerator::save( QDataStream& aOut ) const
+{
+	aOut << mValidationPatientHistory;
+}
+
+//-----------------------------------------------------------------------------
+
+void PatientFoldGenerator::load( QDataStream& aIn )
+{
+	mValidationPatientHistory.clear();
+	aIn >> mValidationPatientHistory;
+}
+
+//-----------------------------------------------------------------------------
+
 bool PatientFoldGenerator::isValidTrainingSet( const QList<QString>& aTrainingKeys )
 {
 	QMap< QString, int > trainingSubgroupCounts;
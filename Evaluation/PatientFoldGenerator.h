@@ -12,6 +12,7 @@
 
 #include <DataRepresentation/DataPackage.h>
 #include <Evaluation/Export.h>
+#include <QDataStream>
 #include <QVariant>
 #include <QVector>
 
@@ -52,6 +53,23 @@ public:
 	*/
 	Pair fold( int aFoldIndex );
 
+	/*!
+	* \brief Number of generated or loaded folds
+	*/
+	int foldCount() const { return mValidationPatientHistory.size(); }
+
+	/*!
+	* \brief Saves the validation patients of the folds, a resumed run loads them to continue on the same folds
+	* \param [in] aOut The stream to save to
+	*/
+	void save( QDataStream& aOut ) const;
+
+	/*!
+	* \brief Loads the validation patients of the folds instead of generating them
+	* \param [in] aIn The stream to load from
+	*/
+	void load( QDataStream& aIn );
+
 	/*!
 	* \brief Tests if training data samples are valid
 	* \param [in] aTrainingKeys The training data sample keys
@@ -16,6 +16,18 @@ double PipelineAnalytics::evaluate( lpmleval::AbstractModel* aModel )
 
 //-----------------------------------------------------------------------------
 
+lpmleval::AbstractAnalytics* PipelineAnalytics::clone() const
+{
+	auto dataPackage = std::make_shared< lpmldata::DataPackage >( *mDataPackage );
+
+	auto analytics               = new PipelineAnalytics( mSettings, dataPackage.get(), mModel );
+	analytics->mOwnedDataPackage = dataPackage;
+
+	return analytics;
+}
+
+//-----------------------------------------------------------------------------
+
 QMap< QString, double > PipelineAnalytics::allValues()
 {
 	QMap< QString, double > result;
@@ -21,6 +21,8 @@ public:
 
 	double evaluate( lpmleval::AbstractModel* aModel ) override;
 
+	lpmleval::AbstractAnalytics* clone() const override;
+
 	void setDataPackage( lpmldata::DataPackage* aDataPackage ) override;
 
 	~PipelineAnalytics();
@@ -39,6 +41,7 @@ private:
 	lpmleval::AbstractModel* mModel;
 	QSettings* mSettings;
 	lpmldata::DataPackage mPreprocessedData;
+	std::shared_ptr< lpmldata::DataPackage > mOwnedDataPackage; //The data of a clone, the evaluation reads it through non-const accessors
 };
 
 //-----------------------------------------------------------------------------
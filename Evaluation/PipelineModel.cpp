@@ -7,13 +7,31 @@
 #include <Evaluation/IsolationForest.h>
 #include <Evaluation/Undersampling.h>
 #include <Evaluation/PCA.h>
+#include <Evaluation/CorrelationPruning.h>
 #include <DataRepresentation/TabularData.h>
+#include <QFile>
+#include <atomic>
+#include <cmath>
 
 namespace dkeval
 {
+
+namespace
+{
+	std::atomic< int > lastThreadSlot( 0 );
+
+	//Pipelines evaluated in parallel write their settings into separate files, the first thread keeps the original file name. Each file is removed once its pipeline is built
+	QString threadSlotSuffix()
+	{
+		thread_local int threadSlot = lastThreadSlot++;
+
+		return threadSlot == 0 ? QString() : "_" + QString::number( threadSlot );
+	}
+}
+
 //-----------------------------------------------------------------------------
 
-PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QVector< std::shared_ptr< Node > > aPipeline, lpmldata::DataPackage& aDataPackage )
+PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QStringList aPipeline, lpmldata::DataPackage& aDataPackage )
 :
 	AbstractModel( aPluginModelSettings ),
 	mDPActions(),
@@ -21,14 +39,18 @@ PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QVector< std::sha
 	mPluginModel( nullptr ),
 	mDataPackage( aDataPackage ),
 	mRanges(),
+	mConfiguration(),
+	mRuntimeSettings(),
 	mFitness( DBL_MAX ),
-	mFoldId( 1 )
+	mFoldId( 1 ),
+	mTreeFraction( 1.0 ),
+	mCache( std::make_shared< PipelineEvaluationCache >() )
 {
 	//create parameter list for each pre-processing algorithm
 	for ( auto& algorithm : mPipeline )
 	{		
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "FeatureSelection" )
+		if ( algorithm == "FeatureSelection" )
 		{
 			//auto maxFeatureCount = (int)std::sqrt( majoritySampleCount * 2 ); //Fulfill the curse of dimensionality requirements to avoid model overfitting
 			auto totalFeatureCount = aDataPackage.featureDatabase().headerNames().size(); 
@@ -39,15 +61,23 @@ PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QVector< std::sha
 				featureCount.push_back( i );
 			}
 
-			mRanges.insert( algorithm->element + "/featureCount", featureCount );
+			mRanges.insert( algorithm + "/featureCount", featureCount );
 
+			//The global rankMethod setting may list several candidates, e.g. RSquared,AnovaF,MutualInformation
 			QVariantList rankMethod;
-			rankMethod.push_back( "RSquared" );
-			mRanges.insert( algorithm->element + "/rankMethod", rankMethod );
+			for ( auto& method : mSettings->value( "FeatureSelection/rankMethod", "RSquared" ).toStringList() )
+			{
+				rankMethod.push_back( method.trimmed() );
+			}
+			if ( rankMethod.isEmpty() )
+			{
+				rankMethod.push_back( "RSquared" );
+			}
+			mRanges.insert( algorithm + "/rankMethod", rankMethod );
 		}
 
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "IsolationForest" )
+		if ( algorithm == "IsolationForest" )
 		{
 			QVariantList treeCount;
 	
@@ -56,10 +86,15 @@ PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QVector< std::sha
 			treeCount.push_back( aDataPackage.featureCount() * 20 );
 
 			mRanges.insert( "IsolationForest/treeCount", treeCount );
+
+			if ( mSettings->contains( "IsolationForest/subsamplingSize" ) )
+			{
+				mRuntimeSettings.insert( "IsolationForest/subsamplingSize", mSettings->value( "IsolationForest/subsamplingSize" ) );
+			}
 		}
 
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "Oversampling" )
+		if ( algorithm == "Oversampling" )
 		{
 			auto minorityCount = aDataPackage.minorityCount(); //Max number of minority samples within training dataset
 			QVariantList neighboursCount;
@@ -116,14 +151,24 @@ PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QVector< std::sha
 			//type.push_back( "ADASYN" );
 
 			mRanges.insert( "Oversampling/type", type );
+
+
+			//Neighbour search options only change the speed, they are not optimized
+			for ( auto& option : QStringList( { "distancePrecision", "knnBackend", "hnswM", "hnswEfConstruction", "hnswEfSearch", "hnswTargetRecall" } ) )
+			{
+				if ( mSettings->contains( "Oversampling/" + option ) )
+				{
+					mRuntimeSettings.insert( "Oversampling/" + option, mSettings->value( "Oversampling/" + option ) );
+				}
+			}
 		}
 
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "Undersampling" )
+		if ( algorithm == "Undersampling" )
 		{
 			QVariantList type;
 			type.push_back( "RandomUndersampling" );
-			type.push_back( "TomekLink" );			
+			type.push_back( "TomekLinks" );			
 
 			mRanges.insert( "Undersampling/type", type );
 
@@ -131,7 +176,7 @@ PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QVector< std::sha
 		}
 
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "PCA" )
+		if ( algorithm == "PCA" )
 		{
 			QVariantList preservationPercentage;
 			for ( int i = 90; i < 100; ++i ) 
@@ -140,14 +185,31 @@ PipelineModel::PipelineModel( QSettings* aPluginModelSettings, QVector< std::sha
 			}
 
 			mRanges.insert( "PCA/preservationPercentage", preservationPercentage );
-		}		
+		}
+
+		//----------------------------------------------------------------------------------------------
+		if ( algorithm == "CorrelationPruning" )
+		{
+			QVariantList threshold;
+			threshold.push_back( 0.80 );
+			threshold.push_back( 0.85 );
+			threshold.push_back( 0.90 );
+			threshold.push_back( 0.95 );
+
+			mRanges.insert( "CorrelationPruning/threshold", threshold );
+
+			if ( mSettings->contains( "CorrelationPruning/scope" ) )
+			{
+				mRuntimeSettings.insert( "CorrelationPruning/scope", mSettings->value( "CorrelationPruning/scope" ) );
+			}
+		}
 	}
 }
 
 //-----------------------------------------------------------------------------
 
-void PipelineModel::set( const QVector< double >& aParameters )
-{	
+QVector< int > PipelineModel::discreteIndices( const QVector< double >& aParameters ) const
+{
 	QVector< double > normalizedParameters;
 
 	double min = DBL_MAX;
@@ -172,21 +234,86 @@ void PipelineModel::set( const QVector< double >& aParameters )
 		normalizedParameters.push_back( normalizedParameter );
 	}
 
+	auto parameterKeys = mRanges.keys();
+	QVector< int > parameterIndices;
+	for ( int i = 0; i < normalizedParameters.size(); ++i )	
+	{
+		auto parameterValues = mRanges.value( parameterKeys.at( i ) );
+		parameterIndices.push_back( ( parameterValues.size() - 1 ) * normalizedParameters.at( i ) );
+	}
+
+	return parameterIndices;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< int > PipelineModel::discreteRanges() const
+{
+	QVector< int > rangeSizes;
+
+	for ( auto& parameterValues : mRanges )
+	{
+		rangeSizes.push_back( parameterValues.size() );
+	}
+
+	return rangeSizes;
+}
+
+//-----------------------------------------------------------------------------
+
+void PipelineModel::set( const QVector< double >& aParameters )
+{	
+	setDiscrete( discreteIndices( aParameters ) );
+}
+
+//-----------------------------------------------------------------------------
+
+void PipelineModel::setDiscrete( const QVector< int >& aIndices )
+{	
+	clearCache();
+
+	//Many simplex points map to the same discrete configuration, it is built only once
+	auto parameterKeys    = mRanges.keys();
+	auto parameterIndices = aIndices;
+	mConfiguration        = aIndices;
+
+	bool isCached = false;
+
+	#pragma omp critical( PipelineModelCache )
+	{
+		++mCache->lookupCount;
+
+		auto cached = mCache->evaluations.constFind( parameterIndices );
+		if ( cached != mCache->evaluations.constEnd() )
+		{
+			++mCache->hitCount;
+			mFitness     = cached->fitness;
+			mDPActions   = cached->dpactions;
+			mPluginModel = cached->pluginModel;
+			isCached     = true;
+		}
+	}
+
+	if ( isCached )
+	{
+		return;
+	}
+
 	auto currentDataPackage     = mDataPackage;	
 	auto pipelineSettingsPath   = mSettings->fileName().split( "Settings.ini" ).at( 0 );
-	QSettings* pipelineSettings = new QSettings( pipelineSettingsPath + QString::number( mFoldId ) + "pipelineSettings.ini", QSettings::IniFormat );
+	QSettings* pipelineSettings = new QSettings( pipelineSettingsPath + QString::number( mFoldId ) + "pipelineSettings" + threadSlotSuffix() + ".ini", QSettings::IniFormat );
 	
-	clearCache();
-	
-	auto parameterKeys = mRanges.keys();
-	for ( int i = 0; i < normalizedParameters.size(); ++i )	
+	for ( int i = 0; i < parameterIndices.size(); ++i )	
 	{
 		auto parameterName   = parameterKeys.at( i );
-		auto parameterValues = mRanges.value( parameterName );
-		int parameterIndex   = ( parameterValues.size() - 1 ) * normalizedParameters.at( i );
-		auto parameterValue  = parameterValues.at( parameterIndex );
+		auto parameterValue  = mRanges.value( parameterName ).at( parameterIndices.at( i ) );
 		pipelineSettings->setValue( parameterName, parameterValue );
 	}
+
+	for ( auto iterator = mRuntimeSettings.constBegin(); iterator != mRuntimeSettings.constEnd(); ++iterator )
+	{
+		pipelineSettings->setValue( iterator.key(), iterator.value() );
+	}
 	
 	pipelineSettings->sync();
 	
@@ -194,39 +321,46 @@ void PipelineModel::set( const QVector< double >& aParameters )
 	for ( auto& algorithm : mPipeline )
 	{
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "FeatureSelection" )
+		if ( algorithm == "FeatureSelection" )
 		{			
 			std::shared_ptr< FeatureSelection > fs = std::make_shared< FeatureSelection >( pipelineSettings );
 			mDPActions.push_back( fs );
 		}
 		
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "IsolationForest" )
+		if ( algorithm == "IsolationForest" )
 		{
 			std::shared_ptr< IsolationForest > isf = std::make_shared< IsolationForest >( pipelineSettings );
 			mDPActions.push_back( isf );
 		}
 
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "Oversampling" )
+		if ( algorithm == "Oversampling" )
 		{
 			std::shared_ptr< Oversampling > os = std::make_shared< Oversampling >( pipelineSettings );
 			mDPActions.push_back( os ); 
 		}
 
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "Undersampling" )
+		if ( algorithm == "Undersampling" )
 		{
 			std::shared_ptr< Undersampling > us = std::make_shared< Undersampling >( pipelineSettings );
 			mDPActions.push_back( us ); 
 		}
 
 		//----------------------------------------------------------------------------------------------
-		if ( algorithm->element == "PCA" )
+		if ( algorithm == "PCA" )
 		{
 			std::shared_ptr< PCA > pca = std::make_shared< PCA >( pipelineSettings );
 			mDPActions.push_back( pca ); 
 		}
+
+		//----------------------------------------------------------------------------------------------
+		if ( algorithm == "CorrelationPruning" )
+		{
+			std::shared_ptr< CorrelationPruning > cp = std::make_shared< CorrelationPruning >( pipelineSettings );
+			mDPActions.push_back( cp );
+		}
 	}
 	
 	for ( auto dpaction : mDPActions )
@@ -240,15 +374,29 @@ void PipelineModel::set( const QVector< double >& aParameters )
 	lpmleval::RandomForestModel* model = new lpmleval::RandomForestModel( mSettings );
 	auto analytics                     = new lpmleval::ConfusionMatrixAnalytics( mSettings, &currentDataPackage ); 
 	auto optimizer                     = new lpmleval::RandomForestOptimizer( mSettings, &currentDataPackage, model, analytics );
+
+	if ( mTreeFraction < 1.0 )
+	{
+		optimizer->setNumberOfTrees( int( std::ceil( mSettings->value( "Optimizer/NumberOfTrees" ).toInt() * mTreeFraction ) ) );
+	}
 	
 	optimizer->build();
 	mFitness = analytics->rocDistance();
 	
-	mPluginModel = model;
+	mPluginModel = std::shared_ptr< AbstractModel >( model );
+
+	#pragma omp critical( PipelineModelCache )
+	{
+		mCache->evaluations.insert( parameterIndices, PipelineEvaluation{ mFitness, mDPActions, mPluginModel } );
+	}
 
 	delete analytics;
 	delete optimizer;
+
+	//The settings of the pipeline are read back by now, remove the temp file of this thread
+	auto pipelineSettingsFileName = pipelineSettings->fileName();
 	delete pipelineSettings;
+	QFile::remove( pipelineSettingsFileName );
 	
 	
 
@@ -270,6 +418,49 @@ int PipelineModel::inputCount()
 
 //-----------------------------------------------------------------------------
 
+lpmleval::AbstractModel* PipelineModel::clone() const
+{
+	//The clone has the same pipeline and parameter ranges, it is not set yet
+	lpmldata::DataPackage dataPackage = mDataPackage;
+
+	auto model = new PipelineModel( mSettings, mPipeline, dataPackage );
+	model->setFoldId( mFoldId );
+	model->setTreeFraction( mTreeFraction );
+	model->mCache = mCache;
+
+	return model;
+}
+
+//-----------------------------------------------------------------------------
+
+int PipelineModel::cacheLookupCount() const
+{
+	int lookupCount;
+
+	#pragma omp critical( PipelineModelCache )
+	{
+		lookupCount = mCache->lookupCount;
+	}
+
+	return lookupCount;
+}
+
+//-----------------------------------------------------------------------------
+
+int PipelineModel::cacheHitCount() const
+{
+	int hitCount;
+
+	#pragma omp critical( PipelineModelCache )
+	{
+		hitCount = mCache->hitCount;
+	}
+
+	return hitCount;
+}
+
+//-----------------------------------------------------------------------------
+
 PipelineModel::~PipelineModel()
 {	
 	mRanges.clear();
@@ -288,11 +479,8 @@ void PipelineModel::clearCache()
 	}
 	mDPActions.clear();
 
-	if ( mPluginModel != nullptr )
-	{
-		delete mPluginModel;
-		mPluginModel = nullptr;
-	}
+	//The model may still be referenced by the evaluation cache
+	mPluginModel = nullptr;
 }
 
 //-----------------------------------------------------------------------------
@@ -7,19 +7,41 @@
 #include <Evaluation/AbstractTDPAction.h>
 #include <DataRepresentation/DataPackage.h>
 #include <QDir>
+#include <QHash>
+#include <memory>
 
 namespace dkeval
 {
 
 //-----------------------------------------------------------------------------
 
+//Result of one discrete pipeline configuration, the trained model is shared by the cache and the PipelineModel
+struct PipelineEvaluation
+{
+	double fitness;
+	QVector< std::shared_ptr< dkeval::AbstractTBPAction > > dpactions;
+	std::shared_ptr< lpmleval::AbstractModel > pluginModel;
+};
+
+//Memo table of a PipelineModel and its clones, keyed on the indices into the parameter ranges
+struct PipelineEvaluationCache
+{
+	PipelineEvaluationCache() : evaluations(), lookupCount( 0 ), hitCount( 0 ) {}
+
+	QHash< QVector< int >, PipelineEvaluation > evaluations;
+	int lookupCount;
+	int hitCount;
+};
+
+//-----------------------------------------------------------------------------
+
 
 class Evaluation_API PipelineModel : public lpmleval::AbstractModel
 {
 
 public:
 
-	PipelineModel( QSettings* aPluginModelSettings, QVector< std::shared_ptr< Node > > aPipeline, lpmldata::DataPackage& aDataPackage );
+	PipelineModel( QSettings* aPluginModelSettings, QStringList aPipeline, lpmldata::DataPackage& aDataPackage );
 
 
 	void set( const QVector< double >& aParameters ) override;
@@ -30,7 +52,17 @@ public:
 
 	int inputCount() override;
 
-	AbstractModel* model() { return mPluginModel; }
+	QVector< int > discreteIndices( const QVector< double >& aParameters ) const override;
+
+	QVector< int > discreteRanges() const override;
+
+	void setDiscrete( const QVector< int >& aIndices ) override;
+
+	const QVector< int >& discreteConfiguration() const { return mConfiguration; } //Indices of the configuration the pipeline is set to
+
+	lpmleval::AbstractModel* clone() const override;
+
+	AbstractModel* model() { return mPluginModel.get(); }
 
 	~PipelineModel();
 
@@ -42,6 +74,11 @@ public:
 
 	void setFoldId( const int& aFoldId ) { mFoldId = aFoldId; }
 
+	void setTreeFraction( double aTreeFraction ) { mTreeFraction = aTreeFraction; } //Fraction of Optimizer/NumberOfTrees, reduced for cheap racing evaluations
+
+	int cacheLookupCount() const; //Number of set() calls, including the clones
+	int cacheHitCount() const;    //Number of set() calls that found their discrete configuration in the cache
+
 private:
 
 	void clearCache();
@@ -49,12 +86,16 @@ private:
 private:
 
 	QVector< std::shared_ptr< dkeval::AbstractTBPAction > > mDPActions;
-	QVector< std::shared_ptr< Node > > mPipeline;
-	AbstractModel* mPluginModel;
+	QStringList mPipeline;
+	std::shared_ptr< AbstractModel > mPluginModel;
 	lpmldata::DataPackage mDataPackage;
 	QMap< QString, QVariantList > mRanges;
+	QVector< int > mConfiguration;
+	QMap< QString, QVariant > mRuntimeSettings; //Options that are not optimized, passed on unchanged from the global settings
 	double mFitness;
 	int mFoldId;
+	double mTreeFraction;
+	std::shared_ptr< PipelineEvaluationCache > mCache; //Shared with the clones
 };
 
 //-----------------------------------------------------------------------------
@@ -6,88 +6,159 @@ namespace dkeval
 	
 	void PipelineTree::buildTree()
 	{	
-		//Initialize the root and build the tree 
+		//Initialize the root, its children are expanded on demand
+		mPool.removeAll( "addedLeaf" );
 		mPool << "addedLeaf"; //creates an empty node which determine the pipeline end if selected in a random path pipeline establishment.
-							  //Handling of this artificial leaf node is done in applyConstrains and randomPath functions
-		mRoot = createNode( "", mPool, 0, 0, 0, nullptr );		
-		addNode( mRoot );
-		
-		//Remove artifical leaf from root children - handle in tree build
-		auto rootChildrenSize = mRoot->children.size();
-		mRoot->children.removeAt( rootChildrenSize - 1 );	
+							  //Handling of this artificial leaf node is done in applyConstrains, expand and randomPath functions
+		mNodes.clear();
+		mStates.clear();
+		mChildIds.clear();
+		mTransitions.clear();
+
+		Node root;
+		root.element            = "";
+		root.pool               = mPool;
+		root.undersamplingCount = 0;
+		root.oversamplingCount  = 0;
+		root.depth              = 0;
+
+		internState( root );
 	}
-	
+
 	//-----------------------------------------------------------------------------
-	
-	std::shared_ptr< Node > PipelineTree::createNode( QString aAlgorithm, QList< QString >& aPool, int aUndersamplingCoung, int aOversmaplingCount, int aDepth, std::shared_ptr< Node > aParent )
+
+	int PipelineTree::internState( const Node& aNode )
 	{
-		std::shared_ptr< Node > node = std::make_shared< Node >();
-		node->element                = aAlgorithm;
-		node->pool                   = aPool;
-		node->undersamplingCount     = aUndersamplingCoung;
-		node->oversamplingCount      = aOversmaplingCount;
-		node->parent                 = aParent;
-		node->depth                  = aDepth;
-			
-		if ( aDepth < mMaxTreeDepth )
+		//The children of a node only depend on these
+		QString key = aNode.element + "|" + QStringList( aNode.pool ).join( "," ) + "|" + QString::number( aNode.undersamplingCount ) + "|" +
+			QString::number( aNode.oversamplingCount ) + "|" + QString::number( aNode.depth );
+
+		auto found = mStates.constFind( key );
+		if ( found != mStates.constEnd() )
 		{
-			for ( int i = 0; i < aPool.size(); ++i )
-			{
-				node->children.push_back( nullptr );
-			}
+			return found.value();
 		}
-			
-	
-		return node;
+
+		int state = mNodes.size();
+		mStates.insert( key, state );
+		mNodes.push_back( aNode );
+		mChildIds.push_back( QVector< int >() );
+		mTransitions.push_back( QVector< int >() );
+
+		return state;
 	}
-	
+
 	//-----------------------------------------------------------------------------
-	
-	void PipelineTree::addNode( std::shared_ptr< Node > aNode )
+
+	void PipelineTree::expand( int aState )
 	{
-		if ( aNode == nullptr )
+		if ( !mTransitions.at( aState ).isEmpty() )
 		{
-			qDebug() << "Error - the root is empty!";
+			return;
 		}
-		else
-		{		
-			for ( int i = 0; i < aNode->children.size(); ++i )
+
+		QVector< int > transitions( mPool.size(), -1 );
+		QVector< int > childIds;
+		Node node = mNodes.at( aState );
+
+		if ( node.depth < mMaxTreeDepth )
+		{
+			for ( int i = 0; i < node.pool.size(); ++i )
 			{
-				if ( aNode->depth < mMaxTreeDepth )
+				auto pool = node.pool;
+
+				//Next node element
+				mElement = pool.at( i );
+
+				if ( aState == rootState() && mElement == "addedLeaf" ) //the pipeline may not be empty
 				{
-					if ( aNode->children.at( i ) == nullptr )
-					{
-						auto pool            = aNode->pool;
-						auto previousElement = aNode->element;
-						auto parent          = aNode->parent;
-						auto nodeDepth       = aNode->depth;
+					continue;
+				}
 
-						++nodeDepth;
+				//handle Feature Selection and Dimensionality reduction duality, constrain 2 consecutive oversampling elements 
+				applyConstrains( pool, node.element );
 
-						//Next node element
-						mElement = pool.at( i );
+				//Get undersampling and oversampling repetition number and update
+				auto undersamplingCount = node.undersamplingCount;
+				auto oversamplingCount  = node.oversamplingCount;
 
-						//handle Feature Selection and Dimensionality reduction duality, constrain 2 consecutive oversampling elements 
-						applyConstrains( pool, previousElement );
+				//check and increment the count of undersampling and oversmapling		
+				updateRepeatability( undersamplingCount, oversamplingCount );
 
-						//Get undersampling and oversampling repetition number and update
-						auto undersamplingCount = aNode->undersamplingCount;
-						auto oversamplingCount  = aNode->oversamplingCount;
+				//Remove the elements which should not be saved in the next node from the pool
+				updatePool( pool, undersamplingCount, oversamplingCount );
 
-						//check and increment the count of undersampling and oversmapling		
-						updateRepeatability( undersamplingCount, oversamplingCount );
+				//Consecutive oversampling may give two children of the same element, the first one is kept
+				int id = mPool.indexOf( mElement );
+				if ( id < 0 || transitions.at( id ) != -1 )
+				{
+					continue;
+				}
 
-						//Remove the elements which should not be saved in the next node from the pool
-						updatePool( pool, undersamplingCount, oversamplingCount );
+				Node child;
+				child.element            = mElement;
+				child.pool               = pool;
+				child.undersamplingCount = undersamplingCount;
+				child.oversamplingCount  = oversamplingCount;
+				child.depth              = node.depth + 1;
 
-						//Create node and attach it to the tree					
-						aNode->children[ i ] = createNode( mElement, pool, undersamplingCount, oversamplingCount, nodeDepth, aNode );
-						addNode( aNode->children[ i ] );
+				transitions[ id ] = internState( child );
+				childIds.push_back( id );
+			}
+		}
 
-					}
-				}				
-			}		
-		}		
+		mChildIds[ aState ]    = childIds;
+		mTransitions[ aState ] = transitions;
+	}
+
+	//-----------------------------------------------------------------------------
+
+	QVector< int > PipelineTree::childIds( int aState )
+	{
+		QVector< int > ids;
+
+		//The states are expanded by the first pipeline that reaches them
+		#pragma omp critical( PipelineTree )
+		{
+			expand( aState );
+			ids = mChildIds.at( aState );
+		}
+
+		return ids;
+	}
+
+	//-----------------------------------------------------------------------------
+
+	int PipelineTree::nextState( int aState, int aId )
+	{
+		if ( aState < 0 || aId < 0 || aId >= mPool.size() )
+		{
+			return -1;
+		}
+
+		int state;
+
+		#pragma omp critical( PipelineTree )
+		{
+			expand( aState );
+			state = mTransitions.at( aState ).at( aId );
+		}
+
+		return state;
+	}
+
+	//-----------------------------------------------------------------------------
+
+	QStringList PipelineTree::children( int aState )
+	{
+		QStringList names;
+
+		for ( int id : childIds( aState ) )
+		{
+			names.push_back( mPool.at( id ) );
+		}
+
+		return names;
 	}
 	
 	//-----------------------------------------------------------------------------
@@ -199,56 +270,13 @@ namespace dkeval
 
 	//-----------------------------------------------------------------------------
 
-	void PipelineTree::printTree( std::shared_ptr< Node > aNode )
-	{
-		if ( aNode == nullptr )
-		{
-			qDebug() << "Error - the root is empty!";
-		}
-		else
-		{
-			for ( int i = 0; i < aNode->children.size(); ++i )
-			{				
-					if ( aNode->element.isEmpty() == false )
-					{
-						mChoosenElements << aNode->element;
-					}					
-
-					if ( aNode->children.at( i )->children.isEmpty() == true ) //Check if it is a leaf
-					{
-						mChoosenElements << aNode->children.at( i )->element; //add leaf element into list
-
-						writeToFile();
-
-						mChoosenElements.clear();
-					}
-
-					printTree( aNode->children.at( i ) );				
-			}
-		}
-	}
-
-	//-----------------------------------------------------------------------------
-
-	void PipelineTree::writeToFile()
-	{
-		for ( auto& element : mChoosenElements )
-		{
-			mTextFile << "-" << element.toStdString();
-		}
-
-		mTextFile << "\n";
-	}
-
-	//-----------------------------------------------------------------------------
-
-	QVector< QString > PipelineTree::algorithmNames( Creature aPath )
+	QStringList PipelineTree::algorithmNames( const Creature& aPath ) const
 	{		
-		QVector< QString > names;
+		QStringList names;
 
 		for ( int i = 0; i < aPath.size(); ++i )
 		{
-			auto name = aPath.at( i )->element;
+			auto name = mPool.at( aPath.at( i ) );
 			
 			names.push_back( name );			
 		}
@@ -258,172 +286,48 @@ namespace dkeval
 
 	//-----------------------------------------------------------------------------
 
-	std::shared_ptr< Node > PipelineTree::nodeAtIndex( Creature aPath, int aIndex )
-	{
-		auto node = aPath.at( aIndex );
-
-		return node;
-	}
-
-	//-----------------------------------------------------------------------------
-
-	QVector< int > PipelineTree::algorithmIndices( QVector< std::shared_ptr< Node > >& aPath )
-	{
-		QVector< int > indices;
-
-		for ( int i = 0; i < aPath.size(); ++i )
-		{
-			auto node = aPath.at( i );
-			auto siblings = this->sibilings( node );
-			auto index = siblings.indexOf( node );
-			indices.push_back( index );
-		}
-
-		return indices;
-	}
-
-	//-----------------------------------------------------------------------------
-
-	std::shared_ptr< Node > PipelineTree::parent( std::shared_ptr< Node > aNode )
-	{
-		if ( aNode != nullptr )
-		{
-			return aNode->parent;
-		}
-		else
-		{			
-			return nullptr;
-		}
-	}
-
-	//-----------------------------------------------------------------------------
-
-	Creature PipelineTree::children( std::shared_ptr< Node > aNode )
-	{
-		QVector < std::shared_ptr< Node > > children;
-
-		if ( aNode == nullptr || isLeaf( aNode ) )
-		{
-			return children;
-		}
-
-		for ( int i = 0; i < aNode->children.size(); ++i )
-		{
-			children << aNode->children.at( i );
-		}
-
-		return children;
-	}
-
-	//-----------------------------------------------------------------------------
-
-	Creature PipelineTree::sibilings( std::shared_ptr< Node > aNode )
-	{
-		QVector < std::shared_ptr< Node > > sibilings;
-
-		if ( aNode == nullptr || isRoot( aNode ) )
-		{
-			return sibilings;
-		}		
-
-		for ( int i = 0; i < aNode->parent->children.count(); ++i )
-		{
-			sibilings << aNode->parent->children.at( i );
-		}
-
-		return sibilings;
-	}
-
-	//-----------------------------------------------------------------------------
-
-	bool PipelineTree::isLeaf( std::shared_ptr< Node > aNode )
-	{		
-		if ( aNode == nullptr )
-		{
-			qDebug() << "PipelineTree::isLeaf received a nullptr argument";
-
-			std::exit( EXIT_SUCCESS );
-		}
-		else if ( aNode->children.isEmpty() )
-		{
-			return true;
-		}
-		else
-		{
-			return false;
-		}
-	}
-
-	//-----------------------------------------------------------------------------
-
-	bool PipelineTree::isRoot( std::shared_ptr< Node > aNode )
-	{
-		if ( aNode == nullptr )
-		{
-			qDebug() << "PipelineTree::isRoot received a nullptr argument";
-
-			std::exit( EXIT_SUCCESS );
-		}
-		else if ( aNode->parent == nullptr )
-		{
-			return true;
-		}
-		else
-		{
-			return false;
-		}
-	}
-
-	//-----------------------------------------------------------------------------
-
 	Creature PipelineTree::randomPath()
 	{		
-		QVector< std::shared_ptr< Node > > pathNodes;
+		Creature path;
 
-		auto node = mRoot;		
+		int state     = rootState();
+		auto childIds = this->childIds( state );
 
-		while ( true )
+		while ( !childIds.isEmpty() )
 		{
-			auto childrenOfNode = node->children;
-			auto randomIndex    = this->randomIndex( childrenOfNode.size() );
+			int id = childIds.at( this->randomIndex( childIds.size() ) );
 
-			node = childrenOfNode.at( randomIndex );
+			if ( id == leafId() ) break; //if aritificial leaf node is selected, don't include it in the pipeline
 
-			if ( node->element != "addedLeaf" ) //if aritificial leaf node is selected, don't include it in the pipeline
-			{
-				pathNodes.push_back( node );
-			}
-
-			if ( isLeaf( node ) ) break;
+			path.push_back( id );
+			state    = nextState( state, id );
+			childIds = this->childIds( state );
 		}
 
-		return pathNodes;
+		return path;
 	}
 
 	//-----------------------------------------------------------------------------
 
-	bool PipelineTree::isValidPath( Creature aPath )
+	bool PipelineTree::isValidPath( const Creature& aPath )
 	{
 		if ( aPath.isEmpty() )
 		{
 			qDebug() << "path is empty!";
 		}
 
-		auto parent = this->parent( aPath.at( 0 ) );
+		int state = rootState();
 
 		for ( int i = 0; i < aPath.size(); ++i )
 		{
-			auto node = aPath.at( i );
+			state = nextState( state, aPath.at( i ) );
 			
-			if ( !parent->children.contains( node ) )
+			if ( state < 0 )
 			{
 				qDebug() << "Error - node is not part of siblings!";
 
 				return false;
-				break;
 			}
-
-			parent = node;
 		}
 
 		return true;
@@ -431,6 +335,24 @@ namespace dkeval
 
 	//-----------------------------------------------------------------------------
 
+	QByteArray PipelineTree::rngState() const
+	{
+		std::ostringstream state;
+		state << *mRng;
+
+		return QByteArray::fromStdString( state.str() );
+	}
+
+	//-----------------------------------------------------------------------------
+
+	void PipelineTree::setRngState( const QByteArray& aState )
+	{
+		std::istringstream state( aState.toStdString() );
+		state >> *mRng;
+	}
+
+	//-----------------------------------------------------------------------------
+
 	int PipelineTree::randomIndex( int aListSize )
 	{
 		std::uniform_int_distribution< int > dice( 0, aListSize - 1 );
@@ -2,6 +2,9 @@
 * \file
 * PipelienTree class defitition. This file is part of Evaluation module.
 * The PipelienTree class is responsible for generation of tree structure which contains all possible combinations of data preparation algorithms to for unique pipelines. 
+* The tree is implicit, the children of a node are computed on demand from its element, pool, repetition counts and depth by the constraint rules.
+* The nodes of equal element, pool, repetition counts and depth have equal subtrees, they are interned into states of a transition table (state x algorithm id -> state),
+* pipelines are generated and validated on the table as Creatures, arrays of algorithm ids (indices into Tree/pool) with a precomputed 64-bit hash.
 * \remarks
 *
 * \authors
@@ -13,16 +16,21 @@
 #include <Evaluation/Export.h>
 #include <QDebug>
 #include <qsettings.h>
-#include <fstream>
+#include <QDataStream>
+#include <QHash>
+#include <QStringList>
+#include <array>
 #include <random>
+#include <sstream>
 
 namespace dkeval
 {
 
+/*!
+* \brief Node of the implicit tree, its children follow from these by the constraint rules
+*/
 struct Node
 {
-	QVector< std::shared_ptr< Node > > children;
-	std::shared_ptr< Node > parent;
 	QString element;
 	QList< QString > pool;
 	int undersamplingCount;
@@ -30,7 +38,68 @@ struct Node
 	int depth;
 };
 
-typedef QVector< std::shared_ptr< Node > > Creature;
+//! Maximum length of an encoded pipeline, Tree/maxTreeDepth may not exceed it
+const int MaxCreatureLength = 16;
+
+/*!
+* \brief Algorithm pipeline encoded as algorithm ids (indices into Tree/pool) with an incrementally computed 64-bit FNV-1a hash
+*/
+struct Creature
+{
+	Creature() : length( 0 ), hash( 0xcbf29ce484222325ULL ) { ids.fill( 0 ); }
+
+	int size() const { return length; }
+	bool isEmpty() const { return length == 0; }
+	int at( int aIndex ) const { return ids[ aIndex ]; }
+
+	void push_back( int aId )
+	{
+		ids[ length++ ] = quint8( aId );
+		hash = ( hash ^ quint64( aId + 1 ) ) * 0x100000001b3ULL;
+	}
+
+	bool operator==( const Creature& aOther ) const { return hash == aOther.hash && length == aOther.length && ids == aOther.ids; }
+	bool operator!=( const Creature& aOther ) const { return !( *this == aOther ); }
+
+	std::array< quint8, MaxCreatureLength > ids;   //!< Algorithm ids, the entries after length are 0
+	quint8 length;
+	quint64 hash;
+};
+
+inline uint qHash( const Creature& aCreature, uint aSeed = 0 ) { return uint( aCreature.hash ^ ( aCreature.hash >> 32 ) ) ^ aSeed; }
+
+//! Stores the length and the ids of a creature, the hash is recomputed on load
+inline QDataStream& operator<<( QDataStream& aOut, const Creature& aCreature )
+{
+	aOut << quint8( aCreature.size() );
+	for ( int i = 0; i < aCreature.size(); ++i )
+	{
+		aOut << quint8( aCreature.at( i ) );
+	}
+
+	return aOut;
+}
+
+inline QDataStream& operator>>( QDataStream& aIn, Creature& aCreature )
+{
+	quint8 length = 0;
+	aIn >> length;
+
+	aCreature = Creature();
+	for ( int i = 0; i < length && i < MaxCreatureLength; ++i )
+	{
+		quint8 id = 0;
+		aIn >> id;
+		aCreature.push_back( id );
+	}
+
+	if ( length > MaxCreatureLength )
+	{
+		aIn.setStatus( QDataStream::ReadCorruptData );
+	}
+
+	return aIn;
+}
 
 
 class Evaluation_API PipelineTree
@@ -44,15 +113,16 @@ public:
 	*/
 	PipelineTree( QSettings* aSettings )
 	:
-		mRoot( nullptr ),
-		mTextFile(),
-		mChoosenElements(),
 		mElement(),
 		mSettings( aSettings ),
 		mIsInitValid( true ),
 		mMaxAlgorithmRepetability(),
 		mPool(),
-		mMaxTreeDepth()
+		mMaxTreeDepth(),
+		mNodes(),
+		mStates(),
+		mChildIds(),
+		mTransitions()
 	{
 		//Create parameters
 		if ( mSettings == nullptr )
@@ -78,9 +148,15 @@ public:
 				mIsInitValid = false;
 			}
 			
+			if ( mMaxTreeDepth > MaxCreatureLength )
+			{
+				qDebug() << "PipelineTree - Error: maxTreeDepth may not exceed" << MaxCreatureLength;
+				mIsInitValid = false;
+			}
+			
 			bool isPool;
 			mPool = mSettings->value( "Tree/pool" ).toStringList();
-			if ( mPool.isEmpty() )
+			if ( mPool.isEmpty() || mPool.size() > 255 )
 			{
 				qDebug() << "PipelineTree - Error: Invalid parameter pool";
 				mIsInitValid = false;
@@ -99,36 +175,51 @@ public:
 public:
 
 	/*!
-	* \brief Generates the tree structure of data preprocessing alogrithms
+	* \brief Initializes the implicit tree of data preprocessing alogrithms, only the root is created, the other nodes are expanded when a pipeline reaches them
 	*/
 	void buildTree();
 
 	/*!
-	* \brief Equals operator.
-	* \return std::shared_ptr< Node > of tree root node
+	* \brief get algorithm names
+	* \param [in] aPath Algorithm pipeline
+	* \return QStringList of algorithm names in the pipeline
+	*/
+	QStringList algorithmNames( const Creature& aPath ) const;		
+
+	/*!
+	* \brief get children of a state
+	* \param [in] aState State of a pipeline prefix
+	* \return Names of the algorithms that may follow the state
+	*/
+	QStringList children( int aState );	
+
+	/*!
+	* \brief State of the empty pipeline
+	*/
+	int rootState() const { return 0; }
+
+	/*!
+	* \brief Algorithm ids that may follow a state, in the order of the tree children. The artificial leaf (leafId()) ends the pipeline.
+	* \param [in] aState State of a pipeline prefix
+	* \return Algorithm ids, empty if the state is a leaf
 	*/
-	std::shared_ptr< Node > treeRoot(){ return mRoot; }
+	QVector< int > childIds( int aState );
 
 	/*!
-	* \brief get node at index
-	* \param [in] aPath Path of sequential algorithm pipeline in a tree
-	* \param [in] aIndex Pipeline node index
+	* \brief State after appending an algorithm id
+	* \return The next state, -1 if the algorithm may not follow the state
 	*/
-	std::shared_ptr< Node > nodeAtIndex( Creature aPath, int aIndex );
+	int nextState( int aState, int aId );
 
 	/*!
-	* \brief get node at index
-	* \param [in] aPath Path of sequential algorithm pipeline in a tree
-	* \return QVector< QString > of algorithm names in the pipeline
+	* \brief Number of the states created so far
 	*/
-	QVector< QString > algorithmNames( Creature aPath );		
+	int stateCount() const { return mNodes.size(); }
 
 	/*!
-	* \brief get node at index
-	* \param [in] aNode node in the algorithm pipeline
-	* \return Creature List of children of algorithm pipeline node
+	* \brief Id of the artificial leaf, it is never stored in a Creature
 	*/
-	Creature children( std::shared_ptr< Node > aNode );	
+	int leafId() const { return mPool.indexOf( "addedLeaf" ); }
 
 	/*!
 	* \brief generate random path to form the algorithm pipeline
@@ -137,48 +228,39 @@ public:
 	Creature randomPath();
 
 	/*!
-	* \brief Tests if the node is leaf
-	* \param [in] aNode node in the algorithm pipeline
-	* \return True if node is leaf, false otherwise.
+	* \brief Tests if the state is leaf
+	* \param [in] aState State of a pipeline prefix
+	* \return True if no algorithm may follow the state, false otherwise.
 	*/
-	bool isLeaf( std::shared_ptr< Node > aNode );
+	bool isLeaf( int aState ) { return childIds( aState ).isEmpty(); }
 
 	/*!
-	* \brief Tests if the node is root
-	* \param [in] aNode node in the algorithm pipeline
-	* \return True if node is root, false otherwise.
+	* \brief State of the random generator, a resumed run continues its sequence
 	*/
-	bool isRoot( std::shared_ptr< Node > aNode );	
+	QByteArray rngState() const;
+	void setRngState( const QByteArray& aState );
 
 	/*!
 	* \brief Tests if the algorithm pipeline is valid
 	* \param [in] aPath algorithm pipeline
 	* \return True if pipeline is valid, false otherwise.
 	*/
-	bool isValidPath( Creature aPath );
+	bool isValidPath( const Creature& aPath );
 	
 	
 private:
 	
 	PipelineTree();
-	std::shared_ptr< Node > createNode( QString aAlgorithm, QList< QString >& aPool, int aUndersamplingCoung, int aOversmaplingCount, int aDepth, std::shared_ptr< Node > aParent );
 	QList < int > indices( QList < QString >& aPool );
-	void addNode( std::shared_ptr< Node > aNode );
+	int internState( const Node& aNode );
+	void expand( int aState );
 	void applyConstrains( QList< QString >& aPool, QString aPreviousElement );
 	void updateRepeatability( int& aUndersamplingCount, int& aOversamplingCount );
 	void updatePool( QList < QString >& aPool, int& aUndersamplingCount, int& aOversamplingCount );	
-	void printTree( std::shared_ptr< Node > aNode );
-	void writeToFile();	
-	Creature sibilings( std::shared_ptr< Node > aNode );
-	std::shared_ptr< Node > parent( std::shared_ptr< Node > aNode );
 	int randomIndex( int aListSize );
-	QVector< int > algorithmIndices( QVector< std::shared_ptr< Node > >& aPath );
 
 private:
 
-	std::shared_ptr< Node > mRoot;
-	std::ofstream mTextFile;
-	QList< QString > mChoosenElements;
 	QString mElement;
 	std::mt19937* mRng;
 	QSettings* mSettings;
@@ -186,6 +268,10 @@ private:
 	int mMaxAlgorithmRepetability;
 	int mMaxTreeDepth;
 	QStringList mPool;
+	QVector< Node > mNodes;                  //!< Node of each state.
+	QHash< QString, int > mStates;           //!< Interned states by the node key.
+	QVector< QVector< int > > mChildIds;     //!< Distinct algorithm ids of the children of each state, filled when the state is expanded.
+	QVector< QVector< int > > mTransitions;  //!< State x algorithm id -> state, -1 if not allowed, empty until the state is expanded.
 
 };
 
@@ -20,6 +20,7 @@
 #include <QMap>
 #include <QString>
 #include <QVariant>
+#include <algorithm>
 
 namespace lpmleval
 {
@@ -42,6 +43,9 @@ public:
 	//! Adds a decision tree model to the random forest model
 	void addDecisionTree( const lpmleval::DecisionTreeModel* );
 
+	//! Overrides the number of trees read from the settings, the number of selected trees is capped by it
+	void setNumberOfTrees( int aNumberOfTrees ) { mNumberOfTrees = std::max( 1, aNumberOfTrees ); mNumberSelectedTrees = std::min( mNumberSelectedTrees, mNumberOfTrees ); }
+
 private:
 	//! Calculates the boost weight multiplier for a tree model
 	void calculateBoostMultiplier( lpmleval::DecisionTreeModel* aTreeModel, const int aBagIndex );
@@ -0,0 +1,327 @@
+#include <Evaluation/SurrogateOptimizer.h>
+#include <QDebug>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <omp.h>
+
+namespace lpmleval
+{
+
+//-----------------------------------------------------------------------------
+
+SurrogateOptimizer::SurrogateOptimizer( lpmleval::AbstractModel* aModel, lpmleval::AbstractAnalytics* aAnalytics, int aMaximumEvaluationCount )
+:
+	AbstractOptimizer( nullptr ),
+	mAnalytics( aAnalytics ),
+	mMaximumEvaluationCount( aMaximumEvaluationCount ),
+	mInitialEvaluationCount( 8 ),
+	mBatchSize( 4 ),
+	mCandidateCount( 64 ),
+	mGoodFraction( 0.25 ),
+	mRanges(),
+	mObservations(),
+	mBestIndices(),
+	mBestValue( DBL_MAX ),
+	mRng( std::random_device{}() ),
+	mModelClones(),
+	mAnalyticsClones()
+{
+	mModel = aModel;
+}
+
+//-----------------------------------------------------------------------------
+
+SurrogateOptimizer::~SurrogateOptimizer()
+{
+	releaseWorkers();
+}
+
+//-----------------------------------------------------------------------------
+
+void SurrogateOptimizer::build()
+{
+	mObservations.clear();
+	mBestIndices.clear();
+	mBestValue = DBL_MAX;
+
+	mRanges = mModel->discreteRanges();
+	if ( mRanges.isEmpty() || std::find( mRanges.begin(), mRanges.end(), 0 ) != mRanges.end() )
+	{
+		qDebug() << "SurrogateOptimizer - Error: The model has no discrete configurations";
+		return;
+	}
+
+	//The budget cannot exceed the grid
+	double gridSize = 1.0;
+	for ( int rangeSize : mRanges )
+	{
+		gridSize *= rangeSize;
+	}
+	int evaluationBudget = int( std::min( double( mMaximumEvaluationCount ), gridSize ) );
+
+	createWorkers();
+
+	//Random initial design, then batches proposed by the surrogate
+	while ( mObservations.size() < evaluationBudget )
+	{
+		int batchSize = std::min( std::max( 1, mBatchSize ), evaluationBudget - mObservations.size() );
+		QList< QVector< int > > batch;
+
+		if ( mObservations.size() < std::min( mInitialEvaluationCount, evaluationBudget ) )
+		{
+			batchSize = std::min( batchSize, std::min( mInitialEvaluationCount, evaluationBudget ) - mObservations.size() );
+
+			for ( int attempt = 0; batch.size() < batchSize && attempt < 100 * batchSize; ++attempt )
+			{
+				auto configuration = randomConfiguration();
+
+				if ( !mObservations.contains( configuration ) && !batch.contains( configuration ) )
+				{
+					batch.push_back( configuration );
+				}
+			}
+		}
+		else
+		{
+			batch = propose( batchSize );
+		}
+
+		if ( batch.isEmpty() )
+		{
+			break;  // Grid exhausted.
+		}
+
+		auto values = evaluateBatch( batch );
+
+		for ( int i = 0; i < batch.size(); ++i )
+		{
+			mObservations.insert( batch.at( i ), values.at( i ) );
+
+			if ( values.at( i ) < mBestValue )
+			{
+				mBestValue   = values.at( i );
+				mBestIndices = batch.at( i );
+			}
+		}
+	}
+
+	releaseWorkers();
+
+	//Leave the model in the best configuration, a PipelineModel finds it in its evaluation cache
+	if ( !mBestIndices.isEmpty() )
+	{
+		mModel->setDiscrete( mBestIndices );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< double > SurrogateOptimizer::result()
+{
+	QVector< double > indices;
+
+	for ( int index : mBestIndices )
+	{
+		indices.push_back( index );
+	}
+
+	return indices;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< int > SurrogateOptimizer::randomConfiguration()
+{
+	QVector< int > configuration;
+
+	for ( int rangeSize : mRanges )
+	{
+		std::uniform_int_distribution< int > dice( 0, rangeSize - 1 );
+		configuration.push_back( dice( mRng ) );
+	}
+
+	return configuration;
+}
+
+//-----------------------------------------------------------------------------
+
+QList< QVector< int > > SurrogateOptimizer::propose( int aCount )
+{
+	//Split the evaluations by their value, the ties are ordered by the configuration to stay deterministic
+	QList< QPair< double, QVector< int > > > ranked;
+	for ( auto observation = mObservations.constBegin(); observation != mObservations.constEnd(); ++observation )
+	{
+		ranked.push_back( qMakePair( observation.value(), observation.key() ) );
+	}
+	std::sort( ranked.begin(), ranked.end() );
+
+	int goodCount = std::max( 1, int( std::ceil( mGoodFraction * ranked.size() ) ) );
+
+	QList< QVector< int > > good;
+	QList< QVector< int > > bad;
+	for ( int i = 0; i < ranked.size(); ++i )
+	{
+		( i < goodCount ? good : bad ).push_back( ranked.at( i ).second );
+	}
+
+	auto goodDensities = densities( good );
+	auto badDensities  = densities( bad );
+
+	QVector< std::discrete_distribution< int > > samplers;
+	for ( auto& density : goodDensities )
+	{
+		samplers.push_back( std::discrete_distribution< int >( density.begin(), density.end() ) );
+	}
+
+	//Candidates from the good density, scored by the log density ratio
+	QList< QPair< double, QVector< int > > > candidates;
+	for ( int candidateIndex = 0; candidateIndex < mCandidateCount; ++candidateIndex )
+	{
+		QVector< int > configuration;
+		double score = 0.0;
+
+		for ( int input = 0; input < mRanges.size(); ++input )
+		{
+			int index = samplers[ input ]( mRng );
+			configuration.push_back( index );
+			score += std::log( goodDensities.at( input ).at( index ) ) - std::log( badDensities.at( input ).at( index ) );
+		}
+
+		if ( !mObservations.contains( configuration ) )
+		{
+			candidates.push_back( qMakePair( -score, configuration ) );
+		}
+	}
+	std::sort( candidates.begin(), candidates.end() );
+
+	QList< QVector< int > > proposals;
+	for ( auto& candidate : candidates )
+	{
+		if ( proposals.size() >= aCount ) break;
+
+		if ( !proposals.contains( candidate.second ) )
+		{
+			proposals.push_back( candidate.second );
+		}
+	}
+
+	//The good density may be too narrow for enough new candidates
+	for ( int attempt = 0; proposals.size() < aCount && attempt < 100 * aCount; ++attempt )
+	{
+		auto configuration = randomConfiguration();
+
+		if ( !mObservations.contains( configuration ) && !proposals.contains( configuration ) )
+		{
+			proposals.push_back( configuration );
+		}
+	}
+
+	return proposals;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< QVector< double > > SurrogateOptimizer::densities( const QList< QVector< int > >& aConfigurations ) const
+{
+	QVector< QVector< double > > result;
+
+	for ( int input = 0; input < mRanges.size(); ++input )
+	{
+		int rangeSize = mRanges.at( input );
+
+		//Neighbouring values of the ordered ranges share the weight, the prior keeps every value possible
+		double bandwidth = std::max( 0.5, rangeSize / 10.0 );
+		QVector< double > density( rangeSize, 1.0 / rangeSize );
+
+		for ( auto& configuration : aConfigurations )
+		{
+			int observed = configuration.at( input );
+
+			for ( int index = 0; index < rangeSize; ++index )
+			{
+				double distance   = ( index - observed ) / bandwidth;
+				density[ index ] += std::exp( -0.5 * distance * distance );
+			}
+		}
+
+		double sum = 0.0;
+		for ( double weight : density ) sum += weight;
+		for ( double& weight : density ) weight /= sum;
+
+		result.push_back( density );
+	}
+
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
+QVector< double > SurrogateOptimizer::evaluateBatch( const QList< QVector< int > >& aConfigurations )
+{
+	int configurationCount = aConfigurations.size();
+	int workerCount        = mModelClones.size() + 1;
+	QVector< double > values( configurationCount, DBL_MAX );
+
+	#pragma omp parallel for num_threads( workerCount ) schedule( dynamic, 1 ) if ( workerCount > 1 )
+	for ( int configurationIndex = 0; configurationIndex < configurationCount; ++configurationIndex )
+	{
+		values[ configurationIndex ] = evaluateConfiguration( aConfigurations.at( configurationIndex ), omp_get_thread_num() );
+	}
+
+	return values;
+}
+
+//-----------------------------------------------------------------------------
+
+double SurrogateOptimizer::evaluateConfiguration( const QVector< int >& aConfiguration, int aWorker )
+{
+	auto model     = aWorker == 0 ? mModel : mModelClones.at( aWorker - 1 ).get();
+	auto analytics = aWorker == 0 ? mAnalytics : mAnalyticsClones.at( aWorker - 1 ).get();
+
+	model->setDiscrete( aConfiguration );
+
+	return analytics->evaluate( model );
+}
+
+//-----------------------------------------------------------------------------
+
+void SurrogateOptimizer::createWorkers()
+{
+	releaseWorkers();
+
+	//A batch is evaluated on one thread inside a parallel region
+	if ( mBatchSize < 2 || omp_in_parallel() )
+	{
+		return;
+	}
+
+	int workerCount = std::min( mBatchSize, omp_get_max_threads() );
+
+	for ( int worker = 1; worker < workerCount; ++worker )
+	{
+		std::shared_ptr< lpmleval::AbstractModel > model( mModel->clone() );
+		std::shared_ptr< lpmleval::AbstractAnalytics > analytics( mAnalytics->clone() );
+
+		if ( model == nullptr || analytics == nullptr )
+		{
+			releaseWorkers();
+			return;
+		}
+
+		mModelClones.push_back( model );
+		mAnalyticsClones.push_back( analytics );
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void SurrogateOptimizer::releaseWorkers()
+{
+	mModelClones.clear();
+	mAnalyticsClones.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+}
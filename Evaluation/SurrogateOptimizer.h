@@ -0,0 +1,108 @@
+/*!
+* \file
+* SurrogateOptimizer class defitition. This file is part of Evaluation module.
+* The SurrogateOptimizer searches the discrete configurations of a model (AbstractModel::discreteRanges()) with a tree-structured Parzen estimator.
+* After a random initial design, the evaluated configurations are split into a good and a bad set, a per-input Parzen density is fitted to both,
+* and of the candidates drawn from the good density the ones with the highest good/bad density ratio (the expected improvement of the estimator) are evaluated next.
+* The proposals are made in batches, a batch is evaluated concurrently on clones of the model and the analytics.
+*
+* \remarks
+*
+* \authors
+* dkrajnc
+*/
+
+#pragma once
+
+#include <Evaluation/Export.h>
+#include <Evaluation/AbstractOptimizer.h>
+#include <Evaluation/AbstractAnalytics.h>
+#include <QHash>
+#include <QVector>
+#include <memory>
+#include <random>
+
+namespace lpmleval
+{
+
+//-----------------------------------------------------------------------------
+
+class Evaluation_API SurrogateOptimizer: public lpmleval::AbstractOptimizer
+{
+
+public:
+
+	/*!
+	* \brief Constructor
+	* \param [in] aModel The model, it has to provide AbstractModel::discreteRanges() and AbstractModel::setDiscrete().
+	* \param [in] aAnalytics The analytics, its value is minimized.
+	* \param [in] aMaximumEvaluationCount The number of objective evaluations.
+	*/
+	SurrogateOptimizer( lpmleval::AbstractModel* aModel, lpmleval::AbstractAnalytics* aAnalytics, int aMaximumEvaluationCount );
+
+	virtual ~SurrogateOptimizer();
+
+	/*!
+	* \brief Runs the search, the model is left set to the best configuration.
+	*/
+	void build() override;
+
+	/*!
+	* \brief Returns with the indices of the best configuration.
+	*/
+	QVector< double > result() override;
+
+	void setInitialEvaluationCount( int aInitialEvaluationCount ) { mInitialEvaluationCount = aInitialEvaluationCount; }  //!< Random configurations before the first proposal.
+	void setBatchSize( int aBatchSize ) { mBatchSize = aBatchSize; }                                                     //!< Configurations proposed and evaluated together.
+	void setCandidateCount( int aCandidateCount ) { mCandidateCount = aCandidateCount; }                                 //!< Samples of the good density per proposal.
+	void setGoodFraction( double aGoodFraction ) { mGoodFraction = aGoodFraction; }                                      //!< Fraction of the evaluations forming the good set.
+	void setSeed( unsigned int aSeed ) { mRng.seed( aSeed ); }
+
+	const QVector< int >& bestIndices() const { return mBestIndices; }
+	double bestValue() const { return mBestValue; }
+	int evaluationCount() const { return mObservations.size(); }
+
+private:
+
+	SurrogateOptimizer();
+
+	QVector< int > randomConfiguration();
+
+	/*!
+	* \brief Proposes not yet evaluated configurations by the density ratio of the good and the bad evaluations.
+	* \param [in] aCount The number of configurations.
+	* \return The configurations, fewer if the grid is exhausted.
+	*/
+	QList< QVector< int > > propose( int aCount );
+
+	/*!
+	* \brief Parzen density of every input over its discrete values, with a uniform prior.
+	*/
+	QVector< QVector< double > > densities( const QList< QVector< int > >& aConfigurations ) const;
+
+	QVector< double > evaluateBatch( const QList< QVector< int > >& aConfigurations );
+	double evaluateConfiguration( const QVector< int >& aConfiguration, int aWorker );
+
+	void createWorkers();
+	void releaseWorkers();
+
+private:
+
+	lpmleval::AbstractAnalytics*                              mAnalytics;
+	int                                                       mMaximumEvaluationCount;
+	int                                                       mInitialEvaluationCount;
+	int                                                       mBatchSize;
+	int                                                       mCandidateCount;
+	double                                                    mGoodFraction;
+	QVector< int >                                            mRanges;            //!< Number of values of each input.
+	QHash< QVector< int >, double >                           mObservations;      //!< Evaluated configurations and their values.
+	QVector< int >                                            mBestIndices;
+	double                                                    mBestValue;
+	std::mt19937                                              mRng;
+	QVector< std::shared_ptr< lpmleval::AbstractModel > >     mModelClones;       //!< Models of the workers 1..n during build().
+	QVector< std::shared_ptr< lpmleval::AbstractAnalytics > > mAnalyticsClones;   //!< Analytics of the workers 1..n during build().
+};
+
+//-----------------------------------------------------------------------------
+
+}
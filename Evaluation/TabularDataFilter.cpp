@@ -1,5 +1,6 @@
 #include <Evaluation/TabularDataFilter.h>
 #include <Evaluation/FeatureSelector.h>
+#include <DataRepresentation/DistanceKernels.h>
 #include <QSet>
 #include <omp.h>
 #include <QDebug>
@@ -1002,37 +1003,29 @@ QVector< int > TabularDataFilter::maskIndicesByNames( const lpmldata::TabularDat
 // Measure distance of two vectors by selected features
 double TabularDataFilter::distance( const QVariantList& aFirstVector, const QVariantList& aSecondVector, QVector< double > aFeatureMask )
 {
-	double distance = 0.0;
-
-	if ( !aFeatureMask.isEmpty() && aFeatureMask.size() == aFirstVector.size() && aFirstVector.size() == aSecondVector.size() )  // Valid mask & sizes are OK?
+	if ( aFirstVector.size() != aSecondVector.size() )  // Sizes do not match.
 	{
-		for ( int i = 0; i < aFirstVector.size(); ++i )
-		{
-			if ( aFeatureMask.at( i ) > 0.0 )
-			{
-				double first = aFirstVector.at( i ).toDouble();
-				double second = aSecondVector.at( i ).toDouble();
-
-				distance += std::pow( first - second, 2.0 );
-			}
-		}
+		return -1.0;
 	}
-	else if ( aFirstVector.size() == aSecondVector.size() ) // No mask and sizes are OK?
+
+	bool isMasked = !aFeatureMask.isEmpty() && aFeatureMask.size() == aFirstVector.size();  // Valid mask?
+
+	// Gather the used features into dense rows for the vectorized kernel.
+	QVector< double > first;
+	QVector< double > second;
+	first.reserve( aFirstVector.size() );
+	second.reserve( aSecondVector.size() );
+
+	for ( int i = 0; i < aFirstVector.size(); ++i )
 	{
-		for ( int i = 0; i < aFirstVector.size(); ++i )
+		if ( !isMasked || aFeatureMask.at( i ) > 0.0 )
 		{
-			double first = aFirstVector.at( i ).toDouble();
-			double second = aSecondVector.at( i ).toDouble();
-
-			distance += std::pow( first - second, 2.0 );
+			first.push_back( aFirstVector.at( i ).toDouble() );
+			second.push_back( aSecondVector.at( i ).toDouble() );
 		}
 	}
-	else  // Sizes do not match.
-	{
-		return -1.0;
-	}
 
-	return std::sqrt( distance );
+	return lpmldata::DistanceKernels::euclidean( first.constData(), second.constData(), first.size() );
 }
 
 //-----------------------------------------------------------------------------
@@ -1094,15 +1087,43 @@ QStringList TabularDataFilter::nearestNeighbors( const QVariantList& aFeatureVec
 
 //-----------------------------------------------------------------------------
 
+QStringList TabularDataFilter::nearestNeighbors( const QString& aKey, const lpmldata::NearestNeighbourIndex& aIndex, int aNeighborCount )
+{
+	QStringList nearestNeighborKeys;
+	int index = aIndex.indexOf( aKey );
+
+	if ( index < 0 )
+	{
+		return nearestNeighborKeys;
+	}
+
+	for ( auto& neighbor : aIndex.nearestNeighbours( index, std::max( aNeighborCount, 0 ) ) )
+	{
+		nearestNeighborKeys.push_back( aIndex.key( neighbor.second ) );
+	}
+
+	return nearestNeighborKeys;
+}
+
+//-----------------------------------------------------------------------------
+
 QMap< QString, QStringList > TabularDataFilter::nearestNeighborMap( lpmldata::TabularData& aFeatureDatabase, int aNeighborCount, QVector< double > aFeatureMask )
 {
-	QStringList keys = aFeatureDatabase.keys();
+	// One tree, the queries of all samples run in parallel.
+	lpmldata::NearestNeighbourIndex index( aFeatureDatabase, QStringList(), aFeatureMask );
+	auto neighborLists = index.allNearestNeighbours( std::max( aNeighborCount, 0 ) );
 	QMap< QString, QStringList > nearestNeighborMap;
 
-	for ( int keyIndex = 0; keyIndex < keys.size(); ++keyIndex )
+	for ( unsigned int keyIndex = 0; keyIndex < index.sampleCount(); ++keyIndex )
 	{
-		QString actualKey = keys.at( keyIndex );
-		nearestNeighborMap.insert( actualKey, this->nearestNeighbors( actualKey, aFeatureDatabase, aNeighborCount, aFeatureMask ) );
+		QStringList nearestNeighborKeys;
+
+		for ( auto& neighbor : neighborLists.at( keyIndex ) )
+		{
+			nearestNeighborKeys.push_back( index.key( neighbor.second ) );
+		}
+
+		nearestNeighborMap.insert( index.key( keyIndex ), nearestNeighborKeys );
 	}
 
 	return nearestNeighborMap;
@@ -1318,6 +1339,7 @@ QPair< lpmldata::TabularData, lpmldata::TabularData> TabularDataFilter::MSMOTE(
 			commonKeys = commonKeysfiltered;
 
 			lpmldata::TabularData tableOfMinority = subTableByKeys( aFeatureDatabase, commonKeys );
+			lpmldata::NearestNeighbourIndex minorityIndex( tableOfMinority, QStringList(), aFeatureMask );  // Reused while the neighbor count grows.
 
 			int newSampleCounter = 0;
 			bool isNewSamplesNeeded = true;
@@ -1344,16 +1366,10 @@ QPair< lpmldata::TabularData, lpmldata::TabularData> TabularDataFilter::MSMOTE(
 					QString category = MSMOTECategories.value( key );
 					//QMap< QString, double > neighborScores;
 
-					QStringList neighbors = nearestNeighbors( key, tableOfMinority, localBSNeighborcount, aFeatureMask );
-					for ( int j = 0; j < neighbors.size(); ++j )
-					{
-						QString neighborKey = neighbors.at( j );							
-						QVariantList neighborFeature = aFeatureDatabase.value( neighborKey ); // Take the neighbor feature vector.
-						//double neighborScore = MSMOTEMap.value( neighborKey );  // Take the MSMOTEMap value.
-						double neighborDistance = this->distance( keyFeature, neighborFeature, aFeatureMask );  // Calculate the distance from the given key.
-						//double fitnessScore = neighborScore; // / neighborDistance;  // Come up with a summarized score to characterize fitness. Larger neighborScore and smaller neighborDistance is larger fitness!
-						//neighborScores.insert( neighborKey, neighborDistance );
-					}
+					QStringList neighbors = nearestNeighbors( key, minorityIndex, localBSNeighborcount );
+					//double neighborScore = MSMOTEMap.value( neighborKey );  // Take the MSMOTEMap value.
+					//double neighborDistance = this->distance( keyFeature, aFeatureDatabase.value( neighborKey ), aFeatureMask );  // The distance from the given key.
+					//double fitnessScore = neighborScore; // / neighborDistance;  // Come up with a summarized score to characterize fitness. Larger neighborScore and smaller neighborDistance is larger fitness!
 
 					// Weighted average the N neighbors to create the new feature variant.
 					QVector < double > vecvar;
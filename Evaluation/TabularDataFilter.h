@@ -190,6 +190,8 @@ public:
 
 	QStringList nearestNeighbors( const QVariantList& aFeatureVector, lpmldata::TabularData& aFeatureDatabase, int aNeighborCount, QVector< double > aFeatureMask = {} );
 
+	QStringList nearestNeighbors( const QString& aKey, const lpmldata::NearestNeighbourIndex& aIndex, int aNeighborCount );  // Query of a prebuilt index.
+
 	QMap< QString, QStringList > nearestNeighborMap( lpmldata::TabularData& aFeatureDatabase, int aNeighborCount, QVector< double > aFeatureMask = {} );
 
 	QMap< QString, double > scoreFeaturesByMSMOTE( lpmldata::TabularData& aFeatureDatabase, const lpmldata::TabularData& aLabelDatabase, const int aLabelIndex, int aNeighborCount, QVector< double > aFeatureMask = {} );
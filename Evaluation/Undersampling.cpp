@@ -1,4 +1,6 @@
 #include <Evaluation/Undersampling.h>
+#include <QSet>
+#include <algorithm>
 
 
 namespace dkeval
@@ -36,39 +38,63 @@ lpmldata::DataPackage Undersampling::run( const lpmldata::DataPackage& aDataPack
 
 //-----------------------------------------------------------------------------
 
-int Undersampling::counterDeterminant( const QVariantList& aFeature, QString aFeatureName, const QVariantList& aMinorityFeature, QString aMinorityName, const QVariantList& aMajorityFeature, QString aMajorityName, const double& aDistance )
+QVector< bool > Undersampling::linkableMajorities( const lpmldata::PairwiseDistanceMatrix& aDistances, unsigned int aMinorityIndex, const QVector< unsigned int >& aMajorityIndices, const QVector< unsigned int >& aAllIndices )
 {
-	int counter = 0;
+	//The other samples by ascending distance from the minority, the incomparable (NaN) distances are tested for every pair
+	QVector< QPair< double, unsigned int > > neighbours;
+	QVector< unsigned int > incomparables;
+	neighbours.reserve( aAllIndices.size() );
 
-	if ( aMinorityName != aFeatureName && aMajorityName != aFeatureName )
+	for ( auto index : aAllIndices )
 	{
-		auto minorityDistance = distance( aMinorityFeature, aFeature );				
-		auto majorityDistance = distance( aMajorityFeature, aFeature );
+		if ( index == aMinorityIndex ) continue;
 
-		if ( aDistance < minorityDistance || aDistance < majorityDistance )
+		auto distance = aDistances.distance( aMinorityIndex, index );
+
+		if ( distance == distance )
+		{
+			neighbours.push_back( qMakePair( distance, index ) );
+		}
+		else
 		{
-			counter++;
+			incomparables.push_back( index );
 		}
 	}
 
-	return counter;
-}
+	std::sort( neighbours.begin(), neighbours.end() );
 
-//-----------------------------------------------------------------------------
+	//A pair is linkable if every third sample is farther from the minority or from the majority than they are from each other.
+	//The samples farther from the minority pass the test, so only the neighbours up to the pair distance are tested.
+	QVector< bool > isLinkable( aMajorityIndices.size(), true );
 
-double Undersampling::distance( const QVariantList& aFirst, const QVariantList& aSecond )
-{
-	double distance           = 0.0;
-	double substractedSquared = 0.0;
-
-	for ( int i = 0; i < aFirst.size(); ++i )
+	for ( int majority = 0; majority < aMajorityIndices.size(); ++majority )
 	{
-		substractedSquared = pow( aSecond.at( i ).toDouble() - aFirst.at( i ).toDouble(), 2.0 );
-		substractedSquared += substractedSquared;
+		auto majorityIndex = aMajorityIndices.at( majority );
+		auto distance      = aDistances.distance( aMinorityIndex, majorityIndex );
+
+		for ( auto index : incomparables )
+		{
+			if ( index != majorityIndex && !( distance < aDistances.distance( aMinorityIndex, index ) || distance < aDistances.distance( majorityIndex, index ) ) )
+			{
+				isLinkable[ majority ] = false;
+				break;
+			}
+		}
+
+		for ( int k = 0; k < neighbours.size() && isLinkable.at( majority ); ++k )
+		{
+			if ( distance < neighbours.at( k ).first ) break;
+
+			auto index = neighbours.at( k ).second;
+
+			if ( index != majorityIndex && !( distance < aDistances.distance( majorityIndex, index ) ) )
+			{
+				isLinkable[ majority ] = false;
+			}
+		}
 	}
-	distance = sqrt( substractedSquared );
 
-	return distance;
+	return isLinkable;
 }
 
 //-----------------------------------------------------------------------------
@@ -112,98 +138,48 @@ void Undersampling::randomUndersampling( const lpmldata::DataPackage& aDataPacka
 
 void Undersampling::tomekLinks( const lpmldata::DataPackage& aDataPackage )
 {
-	QMap< QString, QVariantList > minorityFeatures;
-	QMap< QString, QVariantList > majorityFeatures;
-	QMap< QString, QVariantList > allFeatures;
-	QMap< QString, QString > allLabels;
+	auto majorityKeys = aDataPackage.getMajorityKeys();
+	auto minorityKeys = aDataPackage.getMinorityKeys();
+	majorityKeys.sort();
+	minorityKeys.sort();
 
-	auto majorityKeys  = aDataPackage.getMajorityKeys();
-	auto minorityKeys  = aDataPackage.getMinorityKeys();
-	auto minorityLabel = aDataPackage.getMinorityLabel();	
-
-	//Read out the feature values for each sample in minority class from the dataset and store each sample-values pair in a QMap.
-	for ( int i = 0; i < minorityKeys.size(); ++i )
-	{
-		auto key = minorityKeys.at( i );
-		auto featureVector = aDataPackage.featureVector( key );
-		QString actualLabel = aDataPackage.labelDatabase().valueAt( key, aDataPackage.activeLabelIndex() ).toString();
+	//The distances are shared with the other resampling stages of the package, only looked up here
+	auto distances       = aDataPackage.pairwiseDistances();
+	auto minorityIndices = distances->indicesOf( minorityKeys );
+	auto majorityIndices = distances->indicesOf( majorityKeys );
+	auto allIndices      = minorityIndices + majorityIndices;
+	int minorityCount    = minorityIndices.size();
 
-		minorityFeatures.insert( key, featureVector );
-		allFeatures.insert( key, featureVector );
-		allLabels.insert( key, actualLabel );
-	}
+	//The linkable pairs of the minorities are independent, only the linking below depends on the order
+	QVector< QVector< bool > > isLinkable( minorityCount );
 
-	//Read out the feature values for each sample in majority class from the dataset and store each sample-values pair in a QMap.
-	for ( int i = 0; i < majorityKeys.size(); ++i )
+#pragma omp parallel for schedule( dynamic )
+	for ( int minority = 0; minority < minorityCount; ++minority )
 	{
-		auto key            = majorityKeys.at( i );		
-		auto featureVector  = aDataPackage.featureVector( key );
-		QString actualLabel = aDataPackage.labelDatabase().valueAt( key, aDataPackage.activeLabelIndex() ).toString();
-		
-		majorityFeatures.insert( key, featureVector );
-		allFeatures.insert( key, featureVector );
-		allLabels.insert( key, actualLabel );
+		isLinkable[ minority ] = linkableMajorities( *distances, minorityIndices.at( minority ), majorityIndices, allIndices );
 	}
 
+	QSet< unsigned int > linkedIndices;
+
 	//Find Tomek Links
-	for ( int i = 0; i < minorityFeatures.size(); ++i )
+	for ( int minority = 0; minority < minorityCount; ++minority )
 	{
-		auto minorityFeature = minorityFeatures.values().at( i );
-		auto minorityName    = minorityFeatures.keys().at( i );
+		auto minorityIndex = minorityIndices.at( minority );
 
-		for ( int j = 0; j < majorityFeatures.size(); ++j )
+		for ( int majority = 0; majority < majorityIndices.size(); ++majority )
 		{
-			auto majorityFeature  = majorityFeatures.values().at( j );
-			auto majorityName     = majorityFeatures.keys().at( j );
-			auto distance         = aDataPackage.distance( minorityFeature, majorityFeature );			
-			auto allFeatureValues = allFeatures.values();
-			auto allFeatureKeys   = allFeatures.keys();
-			int counter = 0;
-
-			QVector< int  > counters;
-			counters.resize( allFeatures.size() );
-			counters.fill( 0 );			
-
-#pragma omp parallel for schedule( dynamic )
-			for ( int k = 0; k < allFeatures.size(); ++k )
-			{
-				auto feature     = allFeatureValues.at( k );
-				auto featureName = allFeatureKeys.at( k );
-				counters[ k ]    = counterDeterminant( feature, featureName, minorityFeature, minorityName, majorityFeature, majorityName, distance );
-			}
-
-			for ( int k = 0; k < counters.size(); ++k )
-			{
-				counter += counters.at( k );
-			}
+			auto majorityIndex = majorityIndices.at( majority );
 
-			if ( counter == allFeatures.size() - 2 )
+			if ( isLinkable.at( minority ).at( majority ) )
 			{
 				//All elements included into TL pairs without repetition
-				if ( mChoosenSamples.contains( minorityName ) == false && mChoosenSamples.contains( majorityName ) == false )
+				if ( !linkedIndices.contains( minorityIndex ) && !linkedIndices.contains( majorityIndex ) )
 				{
-					mChoosenSamples.push_back( minorityName );
-					mChoosenSamples.push_back( majorityName );
-				}
-			}
-			counter = 0; //reset counter
-		}
-	}
-
-	//Filter the mChoosenSamples (samples to be removed) from minorities and keep majorities only (minorities shall be cleaned out as well for large data)
-	for ( int i = 0; i < mChoosenSamples.size(); ++i )
-	{
-		auto key = mChoosenSamples.at( i );
+					linkedIndices.insert( minorityIndex );
+					linkedIndices.insert( majorityIndex );
 
-		for ( int j = 0; j < allLabels.size(); ++j )
-		{
-			if ( allLabels.keys().at( j ) == key )
-			{
-				auto value = allLabels.values().at( j ).toInt();
-
-				if ( value == minorityLabel )
-				{
-					mChoosenSamples.removeAll( key );
+					//Only the majorities are removed (minorities shall be cleaned out as well for large data)
+					mChoosenSamples.push_back( distances->key( majorityIndex ) );
 				}
 			}
 		}
@@ -13,6 +13,7 @@
 
 #include <Evaluation/Export.h>
 #include <Evaluation/AbstractTDPAction.h>
+#include <DataRepresentation/PairwiseDistanceMatrix.h>
 #include <QDebug>
 #include <random>
 #include <set>
@@ -90,8 +91,7 @@ public:
 private:
 	void randomUndersampling( const lpmldata::DataPackage& aDataPackage );
 	void tomekLinks( const lpmldata::DataPackage& aDataPackage );
-	int counterDeterminant( const QVariantList& aFeature, QString aFeatureName, const QVariantList& aMinorityFeature, QString aMinorityName, const QVariantList& aMajorityFeature, QString aMajorityName, const double& aDistance );
-	double distance( const QVariantList& aFirst, const QVariantList& aSecond );
+	QVector< bool > linkableMajorities( const lpmldata::PairwiseDistanceMatrix& aDistances, unsigned int aMinorityIndex, const QVector< unsigned int >& aMajorityIndices, const QVector< unsigned int >& aAllIndices );
 
 private:
 
@@ -13,6 +13,9 @@
 
 #include "Evaluation/DataOptimizer.h"
 #include "Evaluation/CentralAi.h"
+#include "DataRepresentation/HnswIndex.h"
+#include <QElapsedTimer>
+#include <QSaveFile>
 
 namespace dkeval
 {
@@ -43,11 +46,15 @@ void saveFoldAt( QString aFoldPath, lpmldata::DataPackage aTrainingDataPackage,
 * \brief Inspects the datasets to eliminate misalignments in sample keys, to fill in missing values, eliminate empty features etc.
 * \param [in] aFDB The feature database
 * \param [in] aLDB The label database
+* \param [in] aSettingsPath Path to setings file
 * \return lpmldata::DataPackage Optimized datapackage
 */
-lpmldata::DataPackage optimizeData( const lpmldata::TabularData& aFDB, const lpmldata::TabularData& aLDB )
+lpmldata::DataPackage optimizeData( const lpmldata::TabularData& aFDB, const lpmldata::TabularData& aLDB, const QString& aSettingsPath )
 {
-	dkeval::DataOptimizer optimizer( aFDB );
+	QSettings settings( aSettingsPath, QSettings::IniFormat );
+	double maximumMissingPercentage = settings.value( "DataOptimizer/maximumMissingPercentage", 20.0 ).toDouble();
+
+	dkeval::DataOptimizer optimizer( aFDB, maximumMissingPercentage );
 	optimizer.build();
 
 	auto redundandFeatures = optimizer.redundandFeatures();
@@ -67,9 +74,11 @@ lpmldata::DataPackage optimizeData( const lpmldata::TabularData& aFDB, const lpm
 * \brief Generate folds
 * \param [in] aSettingsPath Path to setings file
 * \param [in] aDataPackage The datapackage for which folds are generated
+* \param [in] aFoldsPath Path of the file with the validation patients of the folds
+* \param [in] aIsResumed If true, the folds are loaded from aFoldsPath when it exists, otherwise they are generated and saved to it
 * \return MCFolds Generated Monte Carlo cross-validation folds
 */
-MCFolds getFolds( QString& aSettingsPath, const lpmldata::DataPackage& aDataPackage )
+MCFolds getFolds( QString& aSettingsPath, const lpmldata::DataPackage& aDataPackage, const QString& aFoldsPath, bool aIsResumed )
 {
 	QSettings settings( aSettingsPath, QSettings::IniFormat );
 
@@ -95,8 +104,39 @@ MCFolds getFolds( QString& aSettingsPath, const lpmldata::DataPackage& aDataPack
 	auto validationSize = aDataPackage.sampleCountOfPercentage( splitPercentage );
 
 	dkeval::PatientFoldGenerator foldGenerator( aDataPackage, validationSize );
-	foldGenerator.generate( foldCount );
-	qDebug() << "Number of generated folds: " << foldCount;
+
+	//A resumed run continues on the folds of the interrupted one
+	QFile foldsFile( aFoldsPath );
+
+	if ( aIsResumed && foldsFile.exists() && foldsFile.open( QIODevice::ReadOnly ) )
+	{
+		QDataStream in( &foldsFile );
+		in.setVersion( QDataStream::Qt_5_12 );
+
+		foldGenerator.load( in );
+		foldsFile.close();
+		qDebug() << "Number of loaded folds: " << foldGenerator.foldCount();
+	}
+	else
+	{
+		foldGenerator.generate( foldCount );
+		qDebug() << "Number of generated folds: " << foldCount;
+
+		QSaveFile file( aFoldsPath );
+
+		if ( file.open( QIODevice::WriteOnly ) )
+		{
+			QDataStream out( &file );
+			out.setVersion( QDataStream::Qt_5_12 );
+
+			foldGenerator.save( out );
+			file.commit();
+		}
+		else
+		{
+			qDebug() << "Error - cannot save the folds to" << aFoldsPath;
+		}
+	}
 
 
 	//Create Monte Carlo cross-validation folds list
@@ -114,6 +154,57 @@ MCFolds getFolds( QString& aSettingsPath, const lpmldata::DataPackage& aDataPack
 
 //-----------------------------------------------------------------------------
 
+/*!
+* \brief Marks a fold as completed, the marker keeps the confusion matrix values of the fold for the overall performance of a resumed run
+* \param [in] aMarkerPath The path of the marker file
+* \param [in] aConfusionMatrixValues The confusion matrix values of the fold
+*/
+void saveFoldMarker( const QString& aMarkerPath, const QMap< QString, double >& aConfusionMatrixValues )
+{
+	QSaveFile file( aMarkerPath );
+
+	if ( !file.open( QIODevice::WriteOnly ) )
+	{
+		qDebug() << "Error - cannot save the fold marker" << aMarkerPath;
+		return;
+	}
+
+	QDataStream out( &file );
+	out.setVersion( QDataStream::Qt_5_12 );
+	out << quint32( dkeval::CheckpointMagic ) << quint32( dkeval::CheckpointVersion ) << aConfusionMatrixValues;
+
+	file.commit();
+}
+
+//-----------------------------------------------------------------------------
+
+/*!
+* \brief Loads the marker of a completed fold
+* \param [in] aMarkerPath The path of the marker file
+* \param [out] aConfusionMatrixValues The confusion matrix values of the fold
+* \return True if the fold is completed, false otherwise.
+*/
+bool loadFoldMarker( const QString& aMarkerPath, QMap< QString, double >& aConfusionMatrixValues )
+{
+	QFile file( aMarkerPath );
+
+	if ( !file.exists() || !file.open( QIODevice::ReadOnly ) )
+	{
+		return false;
+	}
+
+	QDataStream in( &file );
+	in.setVersion( QDataStream::Qt_5_12 );
+
+	quint32 magic;
+	quint32 version;
+	in >> magic >> version >> aConfusionMatrixValues;
+
+	return in.status() == QDataStream::Ok && magic == dkeval::CheckpointMagic && version == dkeval::CheckpointVersion;
+}
+
+//-----------------------------------------------------------------------------
+
 /*!
 * \brief Saves the performance from confussion matrix
 * \param [in] aTotalConfusionMatrixValues The confussion matrix values
@@ -141,14 +232,23 @@ void overallPerformance( QMap< QString, double >& aTotalConfusionMatrixValues, c
 * \brief Performs the automated data preparation over single center data
 * \param [in] aGlobalSettingsPath The path to location of Settings.ini and pluginSettings.ini files
 * \param [in] aDataPath The path to the location of the feature and label databases
+* \param [in] aIsResumed If true, the completed folds are skipped and the interrupted folds continue from their checkpoints
 */
-void singleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aDataPath )
+void singleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aDataPath, bool aIsResumed )
 {
 	QDir dir( aDataPath );
 	QString settingsPath = aGlobalSettingsPath + "Settings.ini";
 	QString pluginSettingsPath = aGlobalSettingsPath + "pluginSettings.ini";
+	QString checkpointPath = aDataPath + "/checkpoints/";
 	int foldCounter = 0;
 
+	//A new run discards the checkpoints of the previous one
+	if ( !aIsResumed )
+	{
+		QDir( checkpointPath ).removeRecursively();
+	}
+	dir.mkpath( checkpointPath );
+
 	//Load feature and label database from .csv file
 	lpmldata::TabularData FDB;
 	lpmldata::TabularData LDB;
@@ -157,8 +257,8 @@ void singleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aD
 	loader.load( aDataPath + "LDB.csv", LDB );
 
 	//Check FDB+LDB and generate folds
-	auto optimizedData = optimizeData( FDB, LDB );
-	auto folds = getFolds( settingsPath, optimizedData );
+	auto optimizedData = optimizeData( FDB, LDB, settingsPath );
+	auto folds = getFolds( settingsPath, optimizedData, checkpointPath + "folds.bin", aIsResumed );
 
 	//Store TP, TN, FP, FN across all folds
 	QMap< QString, double > totalConfusionMatrixValues;
@@ -168,6 +268,27 @@ void singleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aD
 #pragma omp parallel for schedule( static )
 	for ( int i = 0; i < folds.size(); ++i )
 	{
+		auto foldCheckpointPath = checkpointPath + "Fold-" + QString::number( i + 1 );
+
+		//Skip the folds a resumed run has already finished
+		QMap< QString, double > completedConfusionValues;
+
+		if ( aIsResumed && loadFoldMarker( foldCheckpointPath + ".done", completedConfusionValues ) )
+		{
+#pragma omp critical
+			{
+				for ( auto key : completedConfusionValues.keys() )
+				{
+					totalConfusionMatrixValues[ key ] += completedConfusionValues.value( key );
+				}
+
+				foldCounter++;
+			}
+
+			qInfo() << "Fold:" << i + 1 << "already finished, skipped!";
+			continue;
+		}
+
 		QSettings settings( settingsPath, QSettings::IniFormat );
 		QSettings pluginSettings( pluginSettingsPath, QSettings::IniFormat );
 
@@ -178,6 +299,7 @@ void singleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aD
 		qInfo() << "Fold:" << i + 1 << "analysis in progress...";
 		dkeval::CentralAi ai( &settings, &pluginSettings, *trainingDataPair, *validationDataPair );
 		ai.setFoldId( i + 1 );
+		ai.setCheckpoint( foldCheckpointPath + ".ckpt", aIsResumed );
 		ai.execute();
 		
 
@@ -212,9 +334,16 @@ void singleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aD
 		qInfo() << "Fold:" << i + 1 << "analysis finished and saved!";
 
 
-		//Remove temp files
-		QFile pipelineSettingsFile( aGlobalSettingsPath + QString::number( i + 1 ) + "pipelineSettings.ini" );
-		pipelineSettingsFile.remove();
+		//Mark the fold as completed, its checkpoint is not needed anymore
+		saveFoldMarker( foldCheckpointPath + ".done", ai.confusionMatrixValues() );
+		QFile::remove( foldCheckpointPath + ".ckpt" );
+
+
+		//Remove temp files, including the ones of the threads
+		for ( auto pipelineSettingsFile : QDir( aGlobalSettingsPath ).entryList( QStringList() << QString::number( i + 1 ) + "pipelineSettings*.ini", QDir::Files ) )
+		{
+			QFile::remove( aGlobalSettingsPath + pipelineSettingsFile );
+		}
 
 
 		//Report progress
@@ -233,8 +362,9 @@ void singleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aD
 * \brief Performs the automated data preparation over multiple center data
 * \param [in] aGlobalSettingsPath The path to location of Settings.ini and pluginSettings.ini files
 * \param [in] aDataPath The path to the location of the feature and label databases for training and validation
+* \param [in] aIsResumed If true, the analysis continues from its checkpoint
 */
-void multipleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aDataPath )
+void multipleCenterAnalysis( const QString& aGlobalSettingsPath, const QString& aDataPath, bool aIsResumed )
 {
 	QDir dir( aDataPath );
 	QString settingsPath = aGlobalSettingsPath + "Settings.ini";
@@ -268,10 +398,57 @@ void multipleCenterAnalysis( const QString& aGlobalSettingsPath, const QString&
 
 	//Run analysis - singlecenter data
 	qInfo() << "Central AI data analysis in progress...";
-	dkeval::CentralAi ai( &settings, &pluginSettings, trainingData, validationData );
-	ai.setFoldId( 1 );
-	ai.execute();
-	
+	QString checkpointPath = aDataPath + "/checkpoints/";
+	dir.mkpath( checkpointPath );
+
+	//Optional, independent populations on the same data that exchange their best creatures, each island runs on its own thread
+	int islandCount = std::max( settings.value( "Island/count", 1 ).toInt(), 1 );
+	auto migrationChannel = std::make_shared< dkeval::MigrationChannel >( islandCount );
+
+	QVector< std::shared_ptr< QSettings > > islandSettings;
+	QVector< std::shared_ptr< QSettings > > islandPluginSettings;
+	QVector< std::shared_ptr< dkeval::CentralAi > > islands;
+	QStringList islandCheckpointPaths;
+
+	for ( int island = 0; island < islandCount; ++island )
+	{
+		islandSettings.push_back( std::make_shared< QSettings >( settingsPath, QSettings::IniFormat ) );
+		islandPluginSettings.push_back( std::make_shared< QSettings >( pluginSettingsPath, QSettings::IniFormat ) );
+		islandCheckpointPaths << ( islandCount == 1 ? checkpointPath + "Fold-1.ckpt" : checkpointPath + "Fold-1-Island-" + QString::number( island + 1 ) + ".ckpt" );
+
+		auto ai = std::make_shared< dkeval::CentralAi >( islandSettings.at( island ).get(), islandPluginSettings.at( island ).get(), trainingData, validationData );
+		ai->setFoldId( 1 );
+		ai->setCheckpoint( islandCheckpointPaths.at( island ), aIsResumed );
+		if ( islandCount > 1 )
+		{
+			ai->setIsland( migrationChannel, island );
+		}
+
+		islands.push_back( ai );
+	}
+
+#pragma omp parallel for schedule( static, 1 ) num_threads( islandCount )
+	for ( int island = 0; island < islandCount; ++island )
+	{
+		islands.at( island )->execute();
+	}
+
+	//Keep the island of the best selected pipeline, as the pipeline of a single population is selected
+	int bestIsland = 0;
+	for ( int island = 1; island < islandCount; ++island )
+	{
+		if ( islands.at( island )->roc() < islands.at( bestIsland )->roc() )
+		{
+			bestIsland = island;
+		}
+	}
+
+	if ( islandCount > 1 )
+	{
+		qInfo() << "Island" << bestIsland + 1 << "of" << islandCount << "selected";
+	}
+
+	auto& ai = *islands.at( bestIsland );
 
 
 	auto confusionValues = ai.confusionMatrixValues();
@@ -302,8 +479,15 @@ void multipleCenterAnalysis( const QString& aGlobalSettingsPath, const QString&
 
 
 	//Remove temp files
-	QFile pipelineSettingsFile( aGlobalSettingsPath + QString::number( 1 ) + "pipelineSettings.ini" );
-	pipelineSettingsFile.remove();
+	for ( auto pipelineSettingsFile : QDir( aGlobalSettingsPath ).entryList( QStringList() << QString::number( 1 ) + "pipelineSettings*.ini", QDir::Files ) )
+	{
+		QFile::remove( aGlobalSettingsPath + pipelineSettingsFile );
+	}
+
+	for ( auto islandCheckpointPath : islandCheckpointPaths )
+	{
+		QFile::remove( islandCheckpointPath );
+	}
 
 
 	//Calculate and store overall performance
@@ -312,6 +496,94 @@ void multipleCenterAnalysis( const QString& aGlobalSettingsPath, const QString&
 
 //-----------------------------------------------------------------------------
 
+/*!
+* \brief Compares the approximate HNSW neighbour search of the resampling stages with the exact k-d tree search on the feature database
+* \details Reports the build and query times and the recall of the k nearest neighbours for increasing efSearch values,
+* k and the HNSW parameters are taken from the Oversampling section of the settings. The results are stored in Summary/knn_benchmark.csv.
+* \param [in] aGlobalSettingsPath The path to location of Settings.ini
+* \param [in] aDataPath The path to the location of the feature database FDB.csv
+*/
+void neighbourSearchBenchmark( const QString& aGlobalSettingsPath, const QString& aDataPath )
+{
+	QSettings settings( aGlobalSettingsPath + "Settings.ini", QSettings::IniFormat );
+
+	unsigned int neighbourCount      = std::max( std::abs( settings.value( "Oversampling/neighboursNumber", 5 ).toInt() ), 1 );
+	unsigned int connectionCount     = std::max( settings.value( "Oversampling/hnswM", 16 ).toInt(), 2 );
+	unsigned int constructionBreadth = std::max( settings.value( "Oversampling/hnswEfConstruction", 200 ).toInt(), 1 );
+
+	lpmldata::TabularData FDB;
+	lpmlfio::TabularDataFileIo loader;
+	loader.load( aDataPath + "FDB.csv", FDB );
+	qInfo() << "Data is loaded:" << FDB.rowCount() << "samples," << FDB.columnCount() << "features";
+
+	QElapsedTimer timer;
+	timer.start();
+	lpmldata::NearestNeighbourIndex exactIndex( FDB );
+	qint64 exactBuildTime = timer.restart();
+	lpmldata::HnswIndex approximateIndex( FDB, QStringList(), QVector< double >(), connectionCount, constructionBreadth );
+	qint64 approximateBuildTime = timer.restart();
+
+	//The exact neighbours of every sample are the reference of the recall
+	auto exactNeighbours  = exactIndex.allNearestNeighbours( neighbourCount );
+	qint64 exactQueryTime = timer.restart();
+
+	QDir dir( aDataPath );
+	dir.mkpath( aDataPath + "/Summary" );
+	QFile file( aDataPath + "/Summary/knn_benchmark.csv" );
+	if ( !file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+	{
+		qInfo() << "Error - cannot write the benchmark results!";
+		return;
+	}
+
+	QTextStream stream( &file );
+	stream << "Samples;" << FDB.rowCount() << endl;
+	stream << "Features;" << FDB.columnCount() << endl;
+	stream << "Neighbours;" << neighbourCount << endl;
+	stream << "M;" << connectionCount << endl;
+	stream << "efConstruction;" << constructionBreadth << endl;
+	stream << endl;
+	stream << "Backend;" << "efSearch;" << "Build time [ms];" << "Query time [ms];" << "Recall;" << endl;
+	stream << "exact;" << ";" << exactBuildTime << ";" << exactQueryTime << ";" << 1.0 << ";" << endl;
+	qInfo() << "exact: build" << exactBuildTime << "ms, query" << exactQueryTime << "ms";
+
+	for ( unsigned int searchBreadth : { 16u, 32u, 64u, 128u, 256u, 512u } )
+	{
+		timer.restart();
+		auto approximateNeighbours  = approximateIndex.allNearestNeighbours( neighbourCount, searchBreadth );
+		qint64 approximateQueryTime = timer.restart();
+
+		//A neighbour at the distance of the exact k-th neighbour counts as found, ties may be resolved differently
+		double recallSum = 0.0;
+		for ( int sampleIndex = 0; sampleIndex < exactNeighbours.size(); ++sampleIndex )
+		{
+			auto& exact = exactNeighbours.at( sampleIndex );
+			if ( exact.isEmpty() )
+			{
+				recallSum += 1.0;
+				continue;
+			}
+
+			int foundCount = 0;
+			for ( auto& neighbour : approximateNeighbours.at( sampleIndex ) )
+			{
+				if ( neighbour.first <= exact.last().first * ( 1.0 + 1e-12 ) ) ++foundCount;
+			}
+
+			recallSum += double( std::min( foundCount, exact.size() ) ) / exact.size();
+		}
+
+		double recall = exactNeighbours.isEmpty() ? 1.0 : recallSum / exactNeighbours.size();
+
+		stream << "hnsw;" << searchBreadth << ";" << approximateBuildTime << ";" << approximateQueryTime << ";" << recall << ";" << endl;
+		qInfo() << "hnsw efSearch" << searchBreadth << ": build" << approximateBuildTime << "ms, query" << approximateQueryTime << "ms, recall" << recall;
+	}
+
+	file.close();
+}
+
+//-----------------------------------------------------------------------------
+
 /*!
 * \brief Runs the single/multi center automated data preparation execution
 * \param [in] *aArgv[] Array of the terminal input arguments
@@ -322,14 +594,21 @@ void runMLDP( char *aArgv[] )
 	QString dataPath = QString::fromStdString( std::string( aArgv[ 2 ] ) );
 	QString studyType = QString::fromStdString( std::string( aArgv[ 3 ] ) );
 
-	//Swtich for SINGLE/MULTI center analysis
+	//Optional RESUME continues an interrupted run from its checkpoints, argv is terminated by a null pointer
+	bool isResumed = aArgv[ 4 ] != nullptr && QString::fromStdString( std::string( aArgv[ 4 ] ) ) == "RESUME";
+
+	//Swtich for SINGLE/MULTI center analysis, KNNBENCHMARK compares the neighbour search backends
 	if ( studyType == "SINGLE" )
 	{
-		singleCenterAnalysis( globalSettingsPath, dataPath );
+		singleCenterAnalysis( globalSettingsPath, dataPath, isResumed );
 	}
 	else if ( studyType == "MULTI" )
 	{
-		multipleCenterAnalysis( globalSettingsPath, dataPath );
+		multipleCenterAnalysis( globalSettingsPath, dataPath, isResumed );
+	}
+	else if ( studyType == "KNNBENCHMARK" )
+	{
+		neighbourSearchBenchmark( globalSettingsPath, dataPath );
 	}
 	else
 	{
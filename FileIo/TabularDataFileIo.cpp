@@ -10,6 +10,7 @@
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QDebug>
+#include <limits>
 
 namespace lpmlfio
 {
@@ -43,21 +44,9 @@ TabularDataFileIo::~TabularDataFileIo()
 void TabularDataFileIo::load( QString aHeaderFileName, lpmldata::TabularData& aTabularData )
 {
 
-	QString fullPath;
-	if ( mWorkingDirectory.count() == 0 )
-	{
-		fullPath = aHeaderFileName;
-	}
-	else
-	{
-		fullPath = mWorkingDirectory + "/" + aHeaderFileName;
-	}
-	
+	QString fullPath = this->fullPath( aHeaderFileName );
+
 	//Load CSV
-	if ( !fullPath.contains( ".csv" ) )
-	{
-		fullPath = fullPath + ".csv";
-	}
 	QFile fileInCsv( fullPath );
 	if ( fileInCsv.open( QIODevice::ReadOnly | QIODevice::Text ) )
 	{
@@ -119,21 +108,9 @@ void TabularDataFileIo::load( QString aHeaderFileName, lpmldata::TabularData& aT
 
 void TabularDataFileIo::save( QString aFileName, lpmldata::TabularData& aTabularData )
 {
-	QString fullPath;
-	if ( mWorkingDirectory.count() == 0 )
-	{
-		fullPath = aFileName;
-	}
-	else
-	{
-		fullPath = mWorkingDirectory + "/" + aFileName;
-	}
+	QString fullPath = this->fullPath( aFileName );
 
 	// Save CSV
-	if ( !fullPath.contains( ".csv" ) )
-	{
-		fullPath = fullPath + ".csv";
-	}
 	QFile fileOutCsv( fullPath );
 	if ( fileOutCsv.open( QFile::WriteOnly | QFile::Text ) )
 	{
@@ -185,4 +162,154 @@ void TabularDataFileIo::save( QString aFileName, lpmldata::TabularData& aTabular
 
 //-----------------------------------------------------------------------------
 
+void TabularDataFileIo::loadChunks( QString aFileName,
+	std::function< void( const QStringList& aHeaderNames ) > aHeaderHandler,
+	std::function< void( const QStringList& aKeys, const double* aRows, unsigned int aRowCount ) > aChunkHandler,
+	unsigned int aChunkRowCount )
+{
+	QString fullPath = this->fullPath( aFileName );
+
+	QFile fileInCsv( fullPath );
+	if ( !fileInCsv.open( QIODevice::ReadOnly | QIODevice::Text ) )
+	{
+		qDebug() << "Failed to open: " << fullPath << endl;
+		return;
+	}
+
+	if ( aChunkRowCount == 0 )
+	{
+		aChunkRowCount = 1;
+	}
+
+	// Read the header, the first column is the key.
+	QList< QByteArray > separatedHeader = fileInCsv.readLine().trimmed().split( mCommaSeparator );
+
+	if ( !separatedHeader.isEmpty() && separatedHeader.last().isEmpty() )
+	{
+		separatedHeader.removeLast();
+	}
+
+	QStringList headerNames;
+
+	for ( int headerIndex = 1; headerIndex < separatedHeader.size(); ++headerIndex )
+	{
+		headerNames.push_back( separatedHeader.at( headerIndex ) );
+	}
+
+	aHeaderHandler( headerNames );
+
+	unsigned int columnCount = headerNames.size();
+
+	const double missing = std::numeric_limits< double >::quiet_NaN();
+
+	QStringList chunkKeys;
+	QVector< double > chunk( aChunkRowCount * columnCount );
+	unsigned int chunkRowIndex = 0;
+	int shortRowCount = 0;
+
+	while ( !fileInCsv.atEnd() )
+	{
+		QByteArray line = fileInCsv.readLine().trimmed();
+
+		if ( line.isEmpty() )
+		{
+			continue;
+		}
+
+		QList< QByteArray > separatedLine = line.split( mCommaSeparator );
+		unsigned int cellCount = separatedLine.size() - 1;
+
+		if ( cellCount < columnCount )
+		{
+			++shortRowCount;
+		}
+
+		// Parse the cells straight into the chunk, missing ("NA", empty, non-numeric) and absent cells become NaN.
+		double* chunkRow = chunk.data() + chunkRowIndex * columnCount;
+
+		for ( unsigned int columnIndex = 0; columnIndex < columnCount; ++columnIndex )
+		{
+			if ( columnIndex >= cellCount )
+			{
+				chunkRow[ columnIndex ] = missing;
+				continue;
+			}
+
+			const QByteArray& cell = separatedLine.at( columnIndex + 1 );
+			bool isNumber = false;
+			double value  = cell.toDouble( &isNumber );
+
+			if ( !isNumber )
+			{
+				// Decimal comma.
+				value = QByteArray( cell ).replace( ',', '.' ).toDouble( &isNumber );
+			}
+
+			chunkRow[ columnIndex ] = isNumber ? value : missing;
+		}
+
+		chunkKeys.push_back( separatedLine.at( 0 ) );
+
+		if ( ++chunkRowIndex == aChunkRowCount )
+		{
+			aChunkHandler( chunkKeys, chunk.constData(), chunkRowIndex );
+			chunkKeys.clear();
+			chunkRowIndex = 0;
+		}
+	}
+
+	if ( chunkRowIndex > 0 )
+	{
+		aChunkHandler( chunkKeys, chunk.constData(), chunkRowIndex );
+	}
+
+	fileInCsv.close();
+
+	if ( shortRowCount > 0 )
+	{
+		qDebug() << "TabularDataFileIo - Warning:" << shortRowCount << "records have fewer values than the header in" << fullPath << ", the absent values are treated as missing";
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void TabularDataFileIo::loadStatistics( QString aFileName, lpmldata::StreamingStatistics& aStatistics, bool aIsCovarianceEnabled, unsigned int aChunkRowCount )
+{
+	loadChunks( aFileName,
+		[ &aStatistics, aIsCovarianceEnabled ]( const QStringList& aHeaderNames )
+		{
+			aStatistics.reset( aHeaderNames.size(), aIsCovarianceEnabled );
+			aStatistics.columnNames() = aHeaderNames;
+		},
+		[ &aStatistics ]( const QStringList& aKeys, const double* aRows, unsigned int aRowCount )
+		{
+			aStatistics.addChunk( aRows, aRowCount );
+		},
+		aChunkRowCount );
+}
+
+//-----------------------------------------------------------------------------
+
+QString TabularDataFileIo::fullPath( QString aFileName ) const
+{
+	QString fullPath;
+	if ( mWorkingDirectory.count() == 0 )
+	{
+		fullPath = aFileName;
+	}
+	else
+	{
+		fullPath = mWorkingDirectory + "/" + aFileName;
+	}
+
+	if ( !fullPath.contains( ".csv" ) )
+	{
+		fullPath = fullPath + ".csv";
+	}
+
+	return fullPath;
+}
+
+//-----------------------------------------------------------------------------
+
 }
@@ -11,6 +11,8 @@
 
 #include <FileIo/Export.h>
 #include <DataRepresentation/TabularData.h>
+#include <DataRepresentation/StreamingStatistics.h>
+#include <functional>
 
 namespace lpmlfio
 {
@@ -33,6 +35,31 @@ public:
 
 	void save( QString aHeaderFileName, lpmldata::TabularData& aTabularData );
 
+	/*!
+	* \brief Reads the numeric rows of a CSV file in dense chunks, without building a tabular data. Missing, non-numeric and absent cells are passed as NaN.
+	* \param [in] aFileName The name of the CSV file.
+	* \param [in] aHeaderHandler Called once with the column names, before the first chunk.
+	* \param [in] aChunkHandler Called with the keys and the row-major values of each chunk.
+	* \param [in] aChunkRowCount The maximal number of rows in one chunk.
+	*/
+	void loadChunks( QString aFileName,
+		std::function< void( const QStringList& aHeaderNames ) > aHeaderHandler,
+		std::function< void( const QStringList& aKeys, const double* aRows, unsigned int aRowCount ) > aChunkHandler,
+		unsigned int aChunkRowCount = 4096 );
+
+	/*!
+	* \brief Computes the column statistics of a CSV file in one streaming pass, only the current chunk is held in memory. Missing values are skipped cell by cell.
+	* \param [in] aFileName The name of the CSV file.
+	* \param [out] aStatistics The statistics, reset to the columns of the file.
+	* \param [in] aIsCovarianceEnabled If true, the covariance of the columns is accumulated as well.
+	* \param [in] aChunkRowCount The number of rows accumulated at once.
+	*/
+	void loadStatistics( QString aFileName, lpmldata::StreamingStatistics& aStatistics, bool aIsCovarianceEnabled = false, unsigned int aChunkRowCount = 4096 );
+
+private:
+
+	QString fullPath( QString aFileName ) const;
+
 private:
 
 	QString mWorkingDirectory;  //!< The working directory of the file tabular data file IO.